@@ -5,14 +5,24 @@
 #include <boost/program_options/variables_map.hpp>
 #include <cstring>
 #include <fstream>
+#include <iterator>
+#include <optional>
+#include <sstream>
 #include <string>
 
 #include "BNFParser.h"
 #include "CodeGenerator.h"
+#include "CombTables.h"
 #include "Entities.h"
+#include "ExpressionAnalyzer.h"
+#include "GenerationCache.h"
+#include "LLTableBuilder.h"
+#include "LayoutProfile.h"
 #include "LexerGenerator.h"
 #include "ParserGenerator.h"
+#include "StackAnalyzer.h"
 #include "TableBuilder.h"
+#include "TableOptimizer.h"
 
 int main(int argc, char **argv) {
     namespace po = boost::program_options;
@@ -21,10 +31,29 @@ int main(int argc, char **argv) {
     desc.add_options()
         ("help", "produce help message")
         ("input", po::value<std::string>(), "input grammar file")
-        ("generate-to", po::value<std::string>()->default_value("."), "relative path to a folder a parser will be generated to");
+        ("generate-to", po::value<std::string>()->default_value("."), "relative path to a folder a parser will be generated to")
+        ("cache-dir", po::value<std::string>(), "folder to cache generation results in; unchanged grammars skip straight to code generation")
+        ("incremental", "when the grammar changed, rebuild the tables from the latest cached version of the grammar (requires --cache-dir)")
+        ("max-states", po::value<size_t>()->default_value(0), "abort if the LR(1) automaton grows past this many states and report the LR(0) cores split the most (0 for no limit)")
+        ("max-memory", po::value<size_t>()->default_value(0), "abort if the LR(1) automaton is estimated to take more than this many MiB (0 for no limit)")
+        ("progress", "report the number of states while building the LR(1) automaton and the most split cores after it is built")
+        ("stack-report", "report the worst-case stack depth of the LR parser and the recursive rules that make it grow with the input");
 
     po::options_description parser_opts("Parser options");
     parser_opts.add_options()
+        ("parser", po::value<std::string>()->default_value("lr"), "kind of the generated parser: `lr` for LR(1), `ll1` for a predictive LL(1) parser (fails if the grammar is not LL(1)), `auto` for LL(1) when possible and LR(1) otherwise")
+        ("tables", po::value<std::string>()->default_value("map"), "layout of the LR tables in the generated parser: `map` for maps keyed by terminal ids and non-terminal names, `comb` for static integer arrays compressed by row displacement")
+        ("default-reductions", po::value<std::string>()->default_value("none"), "states of the LR parser that reduce without a table lookup: `none`, `consistent` for the states whose only action is a single reduction, `all` to also make the most frequent reduction of every state its default (errors may be detected a few reductions later)")
+        ("minimize", "merge the LR states that behave the same way (after the default reductions) and report the number of states before and after; reductions by rules with the same left-hand side and length are treated as equal")
+        ("merge-terminals", "let the terminals that have the same actions in every LR state share a column of the action table (implies --minimize)")
+        ("unit-rules", po::value<std::string>()->default_value("keep"), "reductions by unit rules like `<T> = <F>` in the states that do nothing else: `keep`, `synthesize` to jump past them and rebuild their tree nodes from a small table, `drop` to jump past them and leave their nodes out of the tree (both imply --default-reductions consistent)")
+        ("shift-reduce", "shift directly into the reduction of the states that only reduce by a single rule instead of pushing them onto the stack (implies --default-reductions consistent)")
+        ("precedence", po::value<std::vector<std::string>>()->composing(), "expression non-terminal like `<Sum> = <Sum> '+' <Prod> | <Prod>` to parse with a precedence-climbing sub-parser, one step per operator instead of a reduction per level (repeatable, LR parser only)")
+        ("profile-hooks", "make the LR parser count the visits of its states and the shifts of its terminals, `Parser::WriteProfile()` writes the counts out for --profile")
+        ("profile", po::value<std::string>(), "profile written by a parser generated with --profile-hooks and otherwise the same options: renumber the LR states and the terminal columns so the most used ones come first and pack the `comb` tables in that order")
+        ("bundle", "also write the LR tables to `tables.bin` and a grammar-independent `BundleParser.hpp` that maps them into memory at run time, so the tables can be updated without recompiling the parser")
+        ("scanner", po::value<std::string>()->default_value("table"), "how the generated lexer runs its automaton: `table` for transitions looked up in a table by byte class, `direct` for a block of code per state")
+        ("keywords", po::value<std::string>()->default_value("rules"), "how the generated lexer recognizes the quote terminals a regex terminal like an identifier also matches: `rules` for a pattern of the automaton each, `hash` to lex them with the regex terminal and tell them apart by a perfect hash of the lexeme")
         ("json-tree", "include support for generating a parse tree to a JSON file (adds `nlohmann/json` dependency)")
         ("indent", po::value<size_t>()->default_value(4), "amount of spaces per indent in a JSON generated by the parser");
 
@@ -54,36 +83,336 @@ int main(int argc, char **argv) {
         return 1;
     }
 
+    std::string parser_kind = vm["parser"].as<std::string>();
+    if (parser_kind != "lr" && parser_kind != "ll1" && parser_kind != "auto") {
+        std::cerr << "Unknown parser kind `" << parser_kind << "`" << std::endl;
+        return 1;
+    }
+
+    std::string table_layout = vm["tables"].as<std::string>();
+    if (table_layout != "map" && table_layout != "comb") {
+        std::cerr << "Unknown table layout `" << table_layout << "`"
+                  << std::endl;
+        return 1;
+    }
+
+    std::string scanner = vm["scanner"].as<std::string>();
+    if (scanner != "table" && scanner != "direct") {
+        std::cerr << "Unknown scanner `" << scanner << "`" << std::endl;
+        return 1;
+    }
+    ScannerKind scanner_kind =
+        scanner == "direct" ? ScannerKind::DIRECT : ScannerKind::TABLE;
+
+    std::string keywords = vm["keywords"].as<std::string>();
+    if (keywords != "rules" && keywords != "hash") {
+        std::cerr << "Unknown keywords mode `" << keywords << "`" << std::endl;
+        return 1;
+    }
+    KeywordMode keyword_mode =
+        keywords == "hash" ? KeywordMode::HASH : KeywordMode::RULES;
+
+    std::string default_reductions = vm["default-reductions"].as<std::string>();
+    DefaultReductions default_mode = DefaultReductions::NONE;
+    if (default_reductions == "consistent") {
+        default_mode = DefaultReductions::CONSISTENT;
+    } else if (default_reductions == "all") {
+        default_mode = DefaultReductions::ALL;
+    } else if (default_reductions != "none") {
+        std::cerr << "Unknown default reductions mode `" << default_reductions
+                  << "`" << std::endl;
+        return 1;
+    }
+    std::string unit_rules = vm["unit-rules"].as<std::string>();
+    UnitRules unit_mode = UnitRules::KEEP;
+    if (unit_rules == "synthesize") {
+        unit_mode = UnitRules::SYNTHESIZE;
+    } else if (unit_rules == "drop") {
+        unit_mode = UnitRules::DROP;
+    } else if (unit_rules != "keep") {
+        std::cerr << "Unknown unit rules mode `" << unit_rules << "`"
+                  << std::endl;
+        return 1;
+    }
+    if (vm.contains("precedence") && unit_mode == UnitRules::DROP) {
+        std::cerr << "--precedence builds the unit nodes of the expressions, "
+                     "it can't be used with --unit-rules drop"
+                  << std::endl;
+        return 1;
+    }
+    if ((vm.contains("shift-reduce") || unit_mode != UnitRules::KEEP) &&
+        default_mode == DefaultReductions::NONE) {
+        default_mode = DefaultReductions::CONSISTENT;
+    }
+
     std::string filename = vm["input"].as<std::string>();
-    GrammarParser gp(std::make_unique<std::ifstream>(filename));
-    try {
-        gp.Parse();
-    } catch (const GrammarParserError &e) {
-        std::cerr << "GrammarParserError" << e.what() << std::endl;
-        return 2;
+    std::ifstream file(filename);
+    std::string grammar_text(
+        (std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>()
+    );
+
+    std::optional<GenerationCache> cache;
+    uint64_t cache_key =
+        GenerationCache::Key(grammar_text, "parser=" + parser_kind);
+    std::optional<CacheEntry> entry;
+    if (vm.contains("cache-dir")) {
+        try {
+            cache.emplace(vm["cache-dir"].as<std::string>());
+            entry = cache->Load(cache_key);
+        } catch (const GenerationCacheError &e) {
+            std::cerr << "Warning: ignoring generation cache: " << e.what()
+                      << std::endl;
+        }
     }
 
-    Grammar g = gp.Get();
+    std::optional<PredictTable> predict;
+    if (!entry.has_value()) {
+        std::optional<CacheEntry> prev;
+        if (cache.has_value() && vm.contains("incremental")) {
+            try {
+                prev = cache->LoadLatest(filename);
+            } catch (const GenerationCacheError &e) {
+                std::cerr << "Warning: ignoring previous build: " << e.what()
+                          << std::endl;
+            }
+        }
 
-    GrammarAnalyzer ga(g);
-    ParserTables tables(g, ga);
-    try {
-        tables.Generate();
-    } catch (const std::exception &e) {
-        std::cerr << "TableGeneratorError: " << e.what() << std::endl;
-        return 3;
+        GrammarParser gp(std::make_unique<std::istringstream>(grammar_text));
+        try {
+            gp.Parse();
+        } catch (const GrammarParserError &e) {
+            std::cerr << "GrammarParserError" << e.what() << std::endl;
+            return 2;
+        }
+
+        entry.emplace();
+        entry->grammar_ = gp.Get();
+        const Grammar &g = entry->grammar_;
+
+        GrammarAnalyzer ga =
+            prev.has_value() ? GrammarAnalyzer(
+                                   g, prev->grammar_, prev->first_, prev->follow_
+                               )
+                             : GrammarAnalyzer(g);
+        entry->first_ = ga.GetFirst();
+        entry->follow_ = ga.GetFollow();
+
+        if (parser_kind != "lr") {
+            LLParserTables ll_tables(g, ga);
+            ll_tables.Generate();
+            if (ll_tables.IsLL1()) {
+                predict = ll_tables.GetTable();
+            } else if (parser_kind == "ll1") {
+                std::cerr << "LLConflictError: grammar is not LL(1):\n"
+                          << ll_tables.DescribeConflicts();
+                return 3;
+            }
+        }
+
+        if (!predict.has_value()) {
+            AutomatonLimits limits;
+            limits.max_states_ = vm["max-states"].as<size_t>();
+            limits.max_memory_ = vm["max-memory"].as<size_t>() * 1024 * 1024;
+            if (vm.contains("progress")) {
+                limits.report_every_ = 1000;
+                limits.on_progress_ = [](size_t states, size_t pending,
+                                         size_t memory) {
+                    std::cerr << "States: " << states << " (" << pending
+                              << " pending, ~" << memory / (1024 * 1024)
+                              << " MiB)" << std::endl;
+                };
+            }
+
+            std::optional<ParserTables> built;
+            try {
+                if (prev.has_value()) {
+                    built.emplace(
+                        g, ga, prev->states_, prev->transitions_, limits
+                    );
+                } else {
+                    built.emplace(g, ga, limits);
+                }
+                built->Generate();
+            } catch (const AutomatonBudgetError &e) {
+                std::cerr << "AutomatonBudgetError: " << e.what();
+                return 3;
+            } catch (const std::exception &e) {
+                std::cerr << "TableGeneratorError: " << e.what() << std::endl;
+                return 3;
+            }
+            const ParserTables &tables = built.value();
+            if (vm.contains("progress")) {
+                const Automaton &automaton = tables.GetAutomaton();
+                std::cout << "Built " << tables.GetStates().size()
+                          << " LR(1) states from " << automaton.GetCoreCount()
+                          << " LR(0) cores\n"
+                          << automaton.DescribeCoreSplits(5);
+            }
+            if (prev.has_value()) {
+                const GrammarDiff &diff = ga.GetDiff().value();
+                std::cout << "Incremental build: recomputed "
+                          << diff.recomputed_first_ << " FIRST and "
+                          << diff.recomputed_follow_ << " FOLLOW sets, reused "
+                          << tables.GetReusedStates() << " of "
+                          << tables.GetStates().size() << " states"
+                          << std::endl;
+            }
+
+            entry->states_ = tables.GetStates();
+            entry->transitions_ = tables.GetTransitions();
+            entry->tables_ = built->TakeTables();
+        }
+        if (cache.has_value()) {
+            try {
+                cache->Store(cache_key, entry.value());
+            } catch (const GenerationCacheError &e) {
+                std::cerr << "Warning: " << e.what() << std::endl;
+            }
+        }
+    } else if (parser_kind != "lr") {
+        GrammarAnalyzer ga(entry->grammar_);
+        LLParserTables ll_tables(entry->grammar_, ga);
+        ll_tables.Generate();
+        if (ll_tables.IsLL1()) {
+            predict = ll_tables.GetTable();
+        }
+    }
+    if (cache.has_value()) {
+        try {
+            cache->MarkLatest(filename, cache_key);
+        } catch (const GenerationCacheError &e) {
+            std::cerr << "Warning: " << e.what() << std::endl;
+        }
+    }
+
+    if (vm.contains("stack-report") && !predict.has_value()) {
+        GrammarAnalyzer ga(entry->grammar_);
+        StackAnalyzer stack_analyzer(
+            entry->grammar_, ga, entry->transitions_
+        );
+        std::cout << stack_analyzer.Describe();
+    }
+
+    if (!predict.has_value()) {
+        TableOptimizer optimizer(entry->grammar_, entry->tables_);
+        bool minimize =
+            vm.contains("minimize") || vm.contains("merge-terminals");
+        if (minimize) {
+            optimizer.ShareReductions();
+        }
+        if (default_mode != DefaultReductions::NONE) {
+            DefaultReductionStats stats =
+                optimizer.AddDefaultReductions(default_mode);
+            std::cout << "Default reductions: " << stats.states_
+                      << " states, " << stats.default_only_
+                      << " of them without a lookahead, " << stats.removed_
+                      << " action entries removed" << std::endl;
+        }
+        if (minimize) {
+            MinimizationStats stats = optimizer.MinimizeStates();
+            std::cout << "Minimized LR states: " << stats.before_ << " -> "
+                      << stats.after_ << std::endl;
+        }
+        if (unit_mode != UnitRules::KEEP) {
+            UnitRuleStats stats = optimizer.EliminateUnitRules(unit_mode);
+            std::cout << "Bypassed unit reductions: " << stats.bypassed_
+                      << " goto entries, " << stats.removed_states_
+                      << " states removed" << std::endl;
+        }
+        if (vm.contains("shift-reduce")) {
+            ShiftReduceStats stats = optimizer.FuseShiftReduce();
+            std::cout << "Fused shift-reduce actions: " << stats.fused_
+                      << ", " << stats.removed_states_ << " states removed"
+                      << std::endl;
+        }
+        if (vm.contains("merge-terminals")) {
+            TerminalClassStats stats = optimizer.MergeTerminals();
+            std::cout << "Terminal classes: " << stats.terminals_
+                      << " terminals in " << stats.after_ << " columns"
+                      << std::endl;
+        }
+        if (vm.contains("profile")) {
+            std::string profile_path = vm["profile"].as<std::string>();
+            std::ifstream profile_file(profile_path);
+            if (!profile_file) {
+                std::cerr << "Could not open " << profile_path << std::endl;
+                return 1;
+            }
+            try {
+                ProfileLayoutStats stats = optimizer.ApplyProfile(
+                    LayoutProfile::Read(profile_file)
+                );
+                std::cout << "Profile layout: 90% of the visits in "
+                          << stats.hot_states_ << " of " << stats.states_
+                          << " states, 90% of the shifts in "
+                          << stats.hot_columns_ << " of " << stats.columns_
+                          << " columns" << std::endl;
+            } catch (const LayoutProfileError &e) {
+                std::cerr << "LayoutProfileError: " << e.what() << std::endl;
+                return 3;
+            }
+        }
     }
 
-    ActionTable at = tables.GetActionTable();
-    GotoTable gt = tables.GetGotoTable();
-    FollowSets fs = ga.GetFollow();
+    std::vector<Expression> expressions;
+    if (vm.contains("precedence") && predict.has_value()) {
+        std::cerr << "Warning: --precedence only applies to the LR parser, "
+                     "ignoring it"
+                  << std::endl;
+    } else if (vm.contains("precedence")) {
+        std::vector<NonTerminal> roots;
+        for (std::string name :
+             vm["precedence"].as<std::vector<std::string>>()) {
+            if (name.size() > 2 && name.front() == '<' && name.back() == '>') {
+                name = name.substr(1, name.size() - 2);
+            }
+            roots.push_back(NonTerminal{name});
+        }
+        try {
+            expressions = ExpressionAnalyzer(entry->grammar_).Analyze(roots);
+        } catch (const ExpressionError &e) {
+            std::cerr << "ExpressionError: " << e.what() << std::endl;
+            return 2;
+        }
+        for (const Expression &expression : expressions) {
+            std::cout << "Precedence climbing: "
+                      << expression.levels_[0].lhs_.name_ << " with "
+                      << expression.levels_.size() << " levels over "
+                      << expression.operand_.name_ << std::endl;
+        }
+    }
+
+    std::optional<CombTables> comb;
+    if (table_layout == "comb" && !predict.has_value()) {
+        comb.emplace(entry->tables_, vm.contains("profile"));
+        size_t dense_size = (entry->tables_.action_.GetCells().size() +
+                             entry->tables_.goto_.GetCells().size()) *
+                            sizeof(uint32_t);
+        std::cout << "Compressed tables: " << comb->GetByteSize()
+                  << " bytes, " << comb->GetNext().size() << " slots for "
+                  << comb->GetStateCount() << " states (dense: " << dense_size
+                  << " bytes)" << std::endl;
+    }
 
     try {
-        CodeGenerator codegen(
-            vm["generate-to"].as<std::string>(), at, gt, fs, g,
-            vm.count("json-tree"), vm["indent"].as<size_t>()
-        );
-        codegen.Generate();
+        std::string folder = vm["generate-to"].as<std::string>();
+        if (predict.has_value()) {
+            CodeGenerator codegen(
+                folder, predict.value(), entry->follow_, entry->grammar_,
+                vm.count("json-tree"), vm["indent"].as<size_t>(),
+                scanner_kind, keyword_mode
+            );
+            codegen.Generate();
+        } else {
+            CodeGenerator codegen(
+                folder, entry->tables_, entry->follow_, entry->grammar_,
+                vm.count("json-tree"), vm["indent"].as<size_t>(),
+                comb.has_value() ? &comb.value() : nullptr,
+                vm.contains("bundle"), vm.contains("profile-hooks"),
+                expressions, scanner_kind, keyword_mode
+            );
+            codegen.Generate();
+        }
     } catch (const CodeGeneratorError &e) {
         std::cerr << "CodeGeneratorError: " << e.what() << std::endl;
         return 4;
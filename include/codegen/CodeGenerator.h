@@ -7,7 +7,12 @@
 #include <cstdlib>
 #include <cstring>
 
+#include "CombTables.h"
+#include "DenseTables.h"
 #include "Entities.h"
+#include "ExpressionAnalyzer.h"
+#include "LLTableBuilder.h"
+#include "LexerGenerator.h"
 
 /**
  * @class CodeGeneratorError
@@ -40,19 +45,52 @@ public:
     /**
      * @brief Constructs a CodeGenerator object with the specified parameters.
      * @param folder The folder to generate the code to.
-     * @param at The action table to use for the generated code
-     * @param gt The goto table to use for the generated code.
+     * @param tables The parser tables to use for the generated code.
      * @param fs The FOLLOW sets to use for the generated code.
      * @param g The grammar to generate the code for.
      * @param add_json_generator Whether to add a JSON parse tree generator to
      * the generated parser.
      * @param json_indents The number of indents to use for the JSON parse tree
      * (if it is generated).
+     * @param comb The compressed tables to emit instead of the maps keyed by
+     * names, or `nullptr` to emit the maps.
+     * @param bundle Whether to also write the tables to a binary table bundle
+     * and a parser loading it at run time.
+     * @param profile Whether to make the parser count how often it uses the
+     * states and the terminals and write the counts out as a profile.
+     * @param expressions The expressions to parse with precedence-climbing
+     * sub-parsers.
+     * @param scanner How the generated lexer runs its automaton.
+     * @param keywords How the generated lexer recognizes the keywords.
      */
     CodeGenerator(
-        const std::string &folder, ActionTable &at, GotoTable &gt,
-        FollowSets &fs, const Grammar &g, bool add_json_generator,
-        size_t json_indents
+        const std::string &folder, const DenseTables &tables, FollowSets &fs,
+        const Grammar &g, bool add_json_generator, size_t json_indents,
+        const CombTables *comb = nullptr, bool bundle = false,
+        bool profile = false, std::vector<Expression> expressions = {},
+        ScannerKind scanner = ScannerKind::TABLE,
+        KeywordMode keywords = KeywordMode::RULES
+    );
+
+    /**
+     * @brief Constructs a CodeGenerator object that generates a predictive
+     * (LL(1)) parser.
+     * @param folder The folder to generate the code to.
+     * @param pt The predictive parsing table to use for the generated code.
+     * @param fs The FOLLOW sets to use for the generated code.
+     * @param g The grammar to generate the code for.
+     * @param add_json_generator Whether to add a JSON parse tree generator to
+     * the generated parser.
+     * @param json_indents The number of indents to use for the JSON parse tree
+     * (if it is generated).
+     * @param scanner How the generated lexer runs its automaton.
+     * @param keywords How the generated lexer recognizes the keywords.
+     */
+    CodeGenerator(
+        const std::string &folder, const PredictTable &pt, FollowSets &fs,
+        const Grammar &g, bool add_json_generator, size_t json_indents,
+        ScannerKind scanner = ScannerKind::TABLE,
+        KeywordMode keywords = KeywordMode::RULES
     );
 
     /**
@@ -64,11 +102,23 @@ public:
     void Generate();
 
 private:
+    /**
+     * @brief Creates the folder the code is generated to.
+     * @throws CodeGeneratorError if the folder can't be created.
+     */
+    void CreateFolder();
+
     std::string folder_;
     Grammar g_;
-    ActionTable &at_;
-    GotoTable &gt_;
+    const DenseTables *tables_ = nullptr;
+    const CombTables *comb_ = nullptr;
+    const PredictTable *pt_ = nullptr;
     FollowSets &fs_;
     bool add_json_generator_;
     size_t json_indents_;
+    bool bundle_ = false;
+    bool profile_ = false;
+    std::vector<Expression> expressions_;
+    ScannerKind scanner_ = ScannerKind::TABLE;
+    KeywordMode keywords_ = KeywordMode::RULES;
 };
\ No newline at end of file
@@ -0,0 +1,30 @@
+/**
+ * @file CodegenHelpers.h
+ * @brief Contains helper functions shared by the lexer and the parser
+ * generators.
+ * @author Vadim Melnikov
+ * @version 1.0
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Returns the name of the unsigned integer type of the given width.
+ * @param width The width of the type in bytes.
+ */
+std::string UnsignedType(size_t width);
+
+/**
+ * @brief Generates the elements of a static array, 16 per line.
+ * @param out The stream to generate the elements to.
+ * @param values The elements.
+ * @param indent The number of spaces every line starts with.
+ */
+void GenerateArray(
+    std::ostream &out, const std::vector<uint32_t> &values, size_t indent
+);
@@ -0,0 +1,67 @@
+/**
+ * @file KeywordHash.h
+ * @brief Provides a class for building a perfect hash of the keywords the
+ * generated lexer recognizes after lexing them as identifiers.
+ * @author Vadim Melnikov
+ * @version 1.0
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @class KeywordHash
+ * @brief A perfect hash of a set of distinct keywords, built by hashing and
+ * displacing.
+ * @details A keyword falls into the bucket `Hash(keyword, 0) % buckets` and
+ * then into the slot `Hash(keyword, seed) % slots`, where the seed of every
+ * bucket is chosen so that no two keywords share a slot. The number of slots
+ * is a power of two. A lookup takes two hashes and a single comparison, and
+ * the generated lexer repeats it with the same `Hash`.
+ */
+class KeywordHash {
+public:
+    /**
+     * @brief Builds the hash, the buckets with the most keywords are placed
+     * first.
+     * @param keywords The keywords, which must be distinct.
+     */
+    explicit KeywordHash(const std::vector<std::string> &keywords);
+
+    /**
+     * @brief The FNV-1a hash of the bytes started from the seed, with the
+     * bits mixed at the end so that the low ones can index the slots.
+     */
+    static uint64_t Hash(std::string_view s, uint64_t seed);
+
+    /**
+     * @brief Returns the seed of every bucket.
+     */
+    const std::vector<uint32_t> &GetSeeds() const;
+    /**
+     * @brief Returns the index of the keyword in every slot plus 1, 0 for the
+     * empty slots.
+     */
+    const std::vector<uint32_t> &GetSlots() const;
+    /**
+     * @brief Returns the index of the keyword, `std::nullopt` if the string
+     * isn't one.
+     */
+    std::optional<size_t> Find(std::string_view s) const;
+
+private:
+    /**
+     * @brief Tries to place the keywords in the given number of slots.
+     * @return Whether a seed was found for every bucket.
+     */
+    bool Place(size_t slot_count);
+
+    std::vector<std::string> keywords_;
+    std::vector<uint32_t> seeds_;
+    std::vector<uint32_t> slots_;
+};
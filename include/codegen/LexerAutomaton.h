@@ -0,0 +1,126 @@
+/**
+ * @file LexerAutomaton.h
+ * @brief Provides a class for compiling the terminal definitions of a grammar
+ * into a minimal DFA the generated lexer runs.
+ * @author Vadim Melnikov
+ * @version 1.0
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+/**
+ * @class RegexError
+ * @brief An exception class for reporting a pattern that can't be compiled.
+ */
+class RegexError : public std::exception {
+public:
+    /**
+     * @brief Constructs a RegexError object with the specified error.
+     * @param msg The error message.
+     */
+    explicit RegexError(const std::string &msg);
+
+    /**
+     * @brief Returns the error message.
+     * @return The error message.
+     */
+    const char *what() const noexcept override;
+
+private:
+    std::string msg_;
+};
+
+/**
+ * @class LexerAutomaton
+ * @brief Compiles a list of patterns into a minimal DFA over byte equivalence
+ * classes.
+ * @details The patterns use the flex syntax the lexers used to be generated
+ * with: characters and escapes (`\n`, `\x41`, `\101`, `\.`), `.` for any byte
+ * but a newline, bracket classes with ranges, negation and `[:alpha:]`-like
+ * named classes, `"..."` strings, grouping, `|` and the `*`, `+`, `?`, `{n}`,
+ * `{n,}` and `{n,m}` repetitions. Anchors, trailing context and definitions
+ * are not supported. A pattern ends at the first whitespace outside of a
+ * class or a string, which may only be followed by more whitespace.
+ *
+ * The patterns are UTF-8: a non-ASCII character is matched and repeated as a
+ * whole, and `\u00e9`, `\u{1F600}` and `\U0001F600` escape code points. A
+ * class with such characters or escapes, like `[a-zà-ÿ\u{400}-\u{4FF}]`, is
+ * a set of code points compiled into byte range sequences of their UTF-8
+ * encodings, and negating it matches the valid encodings of the other code
+ * points. The rest of the classes and `.` still match single bytes.
+ *
+ * The lexer takes the longest non-empty match at the current position, and of
+ * the patterns matching it the one that comes first. The state that accepts
+ * it records that pattern. State 0 is the dead state every missing transition
+ * goes to and state 1 is the start state.
+ */
+class LexerAutomaton {
+public:
+    /**
+     * @brief Compiles the patterns.
+     * @param patterns The patterns, from the highest priority to the lowest.
+     * @throws RegexError if a pattern can't be compiled, the message names
+     * the pattern.
+     */
+    explicit LexerAutomaton(const std::vector<std::string> &patterns);
+
+    /**
+     * @brief Returns the number of states, counting the dead state.
+     */
+    size_t GetStateCount() const;
+    /**
+     * @brief Returns the number of byte equivalence classes.
+     */
+    size_t GetClassCount() const;
+    /**
+     * @brief Returns the equivalence class of every byte, the bytes in a class
+     * lead to the same state from every state.
+     */
+    const std::vector<uint32_t> &GetClasses() const;
+    /**
+     * @brief Returns the transitions of all states, row by row, with a column
+     * per class.
+     */
+    const std::vector<uint32_t> &GetTransitions() const;
+    /**
+     * @brief Returns the state to go to from the state on the class.
+     */
+    size_t GetNext(size_t state, size_t cls) const;
+    /**
+     * @brief Returns the pattern the state accepts, `std::nullopt` if it
+     * doesn't accept.
+     */
+    std::optional<size_t> GetAccept(size_t state) const;
+    /**
+     * @brief Returns the bytes on which the state goes back to itself, in
+     * ascending order.
+     */
+    std::vector<unsigned char> GetLoopBytes(size_t state) const;
+    /**
+     * @brief Returns the number of states, other than the dead and the start
+     * ones, a match goes on from with the byte.
+     * @details If it is 0, every match ends before the byte, so the lexer
+     * starts a match right at it wherever it started lexing before.
+     */
+    size_t CountContinuing(unsigned char byte) const;
+    /**
+     * @brief Finds the longest match at the start of the input.
+     * @return The pattern and the length of the match, `std::nullopt` if no
+     * pattern matches a non-empty prefix.
+     */
+    std::optional<std::pair<size_t, size_t>> Match(std::string_view input
+    ) const;
+
+private:
+    size_t class_count_ = 0;
+    std::vector<uint32_t> classes_;
+    std::vector<uint32_t> transitions_;
+    std::vector<std::optional<size_t>> accept_;
+};
@@ -6,9 +6,31 @@
  */
 #pragma once
 
+#include <optional>
+#include <ostream>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "Entities.h"
+#include "LexerAutomaton.h"
+
+/**
+ * @enum KeywordMode
+ * @brief Selects how the generated lexer recognizes the quote terminals that
+ * a regex terminal, like an identifier, also matches.
+ */
+enum class KeywordMode {
+    /**
+     * @brief Every quote terminal is a pattern of the automaton.
+     */
+    RULES,
+    /**
+     * @brief The regex terminal lexes them, and a perfect hash of the lexeme
+     * tells them apart, so the automaton gets smaller.
+     */
+    HASH
+};
 
 /**
  * @class LexerGeneratorError
@@ -33,9 +55,52 @@ private:
     std::string msg_;
 };
 
+/**
+ * @enum ScannerKind
+ * @brief Selects how the generated lexer runs its automaton.
+ */
+enum class ScannerKind {
+    /**
+     * @brief The transitions are looked up in a table indexed by the state and
+     * the class of the byte.
+     */
+    TABLE,
+    /**
+     * @brief Every state is a block of code that jumps to the next one.
+     */
+    DIRECT
+};
+
 /**
  * @class LexerGenerator
  * @brief A class for generating a lexer based on the provided grammar.
+ * @details The quote terminals, the regex terminals and the `IGNORE` patterns
+ * are compiled into a single LexerAutomaton in this order, which is also the
+ * priority of the ones matching the same longest prefix. Bytes nothing
+ * matches are skipped. The states looping on a few bytes, or on all but a few,
+ * like the ones inside whitespace, comments and strings, skip the loop with
+ * vector compares. The loops over UTF-8 characters skip their runs of ASCII
+ * bytes that way, which is the whole input when it is pure ASCII.
+ *
+ * With KeywordMode::HASH, the quote terminals a regex terminal matches in full
+ * are left out of the automaton. The lexer looks the lexemes of the regex
+ * terminal up in a perfect hash of them instead, which gives the same tokens:
+ * a keyword only wins when the regex terminal matches nothing longer.
+ *
+ * A `p::Lexer` lexes a buffer owned by the caller, a file, a descriptor or a
+ * `FILE*`; regular files are mapped into memory. It returns compact tokens:
+ * the id of the terminal, the same one the LR tables use, and the offset and
+ * the length of the lexeme in the input, which is not copied. A
+ * `p::TokenStream` lets the parser pull the same tokens one at a time instead,
+ * and a `p::TokenPipe` runs a stream on a thread of its own, so the parser
+ * works on the tokens while the rest of the input is lexed.
+ * `LexParallel()` splits a large input into chunks that threads lex from a
+ * byte few or no matches go on with, and re-lexes from the end of a chunk
+ * until its tokens meet the ones of the next chunk, so the tokens are the same.
+ * The generated lexer has no global state, so threads can lex at the same
+ * time, and it throws `p::LexerError` if the input can't be read. The free
+ * functions `LexInput()`, `StreamInput()` and `Lex()` are kept for the
+ * existing callers, `Lex()` returns the tokens as `p::Terminal` objects.
  */
 class LexerGenerator {
 public:
@@ -43,19 +108,67 @@ public:
      * @brief Constructs a LexerGenerator object.
      * @param folder A folder that the lexer is generated to.
      * @param g The grammar to generated the lexer for.
+     * @param scanner How the lexer runs its automaton.
+     * @param keywords How the lexer recognizes the keywords.
      */
-    LexerGenerator(const std::string &folder, const Grammar &g);
+    LexerGenerator(
+        const std::string &folder, const Grammar &g,
+        ScannerKind scanner = ScannerKind::TABLE,
+        KeywordMode keywords = KeywordMode::RULES
+    );
 
     /**
      * @brief Generates the lexer.
-     * @throws LexerGeneratorError if an error occurs during the generation of
-     * the lexer.
-     * @note The lexer is generated using `flex` utility that often comes
-     * preinstalled with UNIX-based systems.
+     * @throws LexerGeneratorError if a terminal can't be compiled.
      */
     void Generate();
 
 private:
+    /**
+     * @brief Generates the function running the automaton from a table.
+     */
+    void GenerateTableScanner(std::ostream &out, const LexerAutomaton &dfa)
+        const;
+    /**
+     * @brief Generates the function running the automaton as code, a label per
+     * state.
+     */
+    void GenerateDirectScanner(std::ostream &out, const LexerAutomaton &dfa)
+        const;
+    /**
+     * @brief Generates the bytes the chunks of a parallel lex start at, the
+     * ones the fewest states of the automaton go on with.
+     */
+    void GenerateSyncBytes(std::ostream &out, const LexerAutomaton &dfa)
+        const;
+    /**
+     * @brief Generates the perfect hash of the keywords the regex terminals
+     * lex and the function telling their matches apart.
+     */
+    void GenerateKeywords(std::ostream &out) const;
+    /**
+     * @brief Generates the functions skipping the bytes of a loop with SSE2 or
+     * AVX2, whichever the CPU supports, and a scalar fallback.
+     */
+    void GenerateSkip(std::ostream &out) const;
+    /**
+     * @brief Generates `LexerFwd.hpp` with the token types and the terminal
+     * ids shared with the parser.
+     */
+    void GenerateFwd() const;
+
     std::string folder_;
     const Grammar &g_;
+    ScannerKind scanner_ = ScannerKind::TABLE;
+    KeywordMode keywords_ = KeywordMode::RULES;
+    /**
+     * @brief The terminals of the patterns of the automaton, `std::nullopt`
+     * for the `IGNORE` ones.
+     */
+    std::vector<std::optional<Terminal>> rules_;
+    /**
+     * @brief The quote terminals lexed by a regex terminal, with the pattern
+     * of the regex terminal.
+     */
+    std::vector<std::pair<Terminal, size_t>> hashed_;
 };
\ No newline at end of file
@@ -7,13 +7,18 @@
  */
 #pragma once
 
+#include <ostream>
+
+#include "CombTables.h"
+#include "DenseTables.h"
 #include "Entities.h"
+#include "ExpressionAnalyzer.h"
+#include "LLTableBuilder.h"
 
 /**
  * @class ParserGeneratorError
  * @brief Exception class for reporting errors in the process of generating a
  * parser.
- * @note This error is currently not thrown anywhere in the code.
  */
 class ParserGeneratorError : public std::exception {
 public:
@@ -42,8 +47,35 @@ public:
      * @brief Constructs a ParserGenerator object with the specified grammar.
      * @param folder The folder to generate the parser to.
      * @param g The grammar to generate the parser for.
-     * @param at The action table to use for the generated parser.
-     * @param gt The goto table to use for the generated parser.
+     * @param tables The parser tables to use for the generated parser.
+     * @param fs The FOLLOW sets to use for the generated parser.
+     * @param add_json_generator Whether to add a JSON parse tree generator to
+     * the generated parser.
+     * @param json_indents The number of indents to use for the JSON parse tree
+     * (if it is generated).
+     * @param comb The compressed tables to emit as static integer arrays
+     * instead of the maps keyed by names, or `nullptr` to emit the maps.
+     * @param bundle Whether to also write the tables to `tables.bin` and a
+     * parser loading them at run time to `BundleParser.hpp`.
+     * @param profile Whether to make the parser count the visits of the states
+     * and the shifts of the terminals and write them out with
+     * `WriteProfile()`, see LayoutProfile.
+     * @param expressions The expressions to parse with precedence-climbing
+     * sub-parsers instead of reducing every level, see ExpressionAnalyzer.
+     */
+    ParserGenerator(
+        const std::string &folder, const Grammar &g, const DenseTables &tables,
+        const FollowSets &fs, bool add_json_generator, size_t json_indents,
+        const CombTables *comb = nullptr, bool bundle = false,
+        bool profile = false, std::vector<Expression> expressions = {}
+    );
+
+    /**
+     * @brief Constructs a ParserGenerator object that generates a predictive
+     * (LL(1)) parser with the same interface as the LR(1) one.
+     * @param folder The folder to generate the parser to.
+     * @param g The grammar to generate the parser for.
+     * @param pt The predictive parsing table to use for the generated parser.
      * @param fs The FOLLOW sets to use for the generated parser.
      * @param add_json_generator Whether to add a JSON parse tree generator to
      * the generated parser.
@@ -51,24 +83,130 @@ public:
      * (if it is generated).
      */
     ParserGenerator(
-        const std::string &folder, const Grammar &g, const ActionTable &at,
-        const GotoTable &gt, const FollowSets &fs, bool add_json_generator,
-        size_t json_indents
+        const std::string &folder, const Grammar &g, const PredictTable &pt,
+        const FollowSets &fs, bool add_json_generator, size_t json_indents
     );
 
     /**
      * @brief Generates the parser.
      * @throws ParserGeneratorError if an error occurs during the generation of
-     * the parser. Check note for the ParserGeneratorError class for more.
+     * the parser, e.g. if the table bundle can't be written.
      */
     void Generate();
 
 private:
+    /**
+     * @brief Generates the includes and the definitions of grammar entities.
+     * @param bundle_runtime Whether to also include the headers needed to map
+     * a table bundle into memory.
+     */
+    void GeneratePrelude(std::ostream &out, bool bundle_runtime = false) const;
+    /**
+     * @brief Generates the `ActionType` enum and the `Action` struct.
+     */
+    void GenerateActionType(std::ostream &out) const;
+    /**
+     * @brief Generates the `ParserTables` class holding the LR(1) tables.
+     */
+    void GenerateLRTables(std::ostream &out) const;
+    /**
+     * @brief Generates the LR(1) tables as maps keyed by names and the lookup
+     * functions over them.
+     */
+    void GenerateMapTables(std::ostream &out) const;
+    /**
+     * @brief Generates the LR(1) tables as comb vectors and the lookup
+     * functions over them.
+     */
+    void GenerateCombTables(std::ostream &out) const;
+    /**
+     * @brief Generates the lookup of the non-terminals of the bypassed unit
+     * reductions, if there are any.
+     */
+    void GenerateUnitChains(std::ostream &out) const;
+    /**
+     * @brief Generates the `ParserTables` class holding the predictive table.
+     */
+    void GenerateLLTables(std::ostream &out) const;
+    /**
+     * @brief Generates the FOLLOW set accessors of the `ParserTables` class and
+     * closes the class.
+     */
+    void GenerateFollowSets(std::ostream &out) const;
+    /**
+     * @brief Generates the parse tree, its visitors and the JSON generator.
+     */
+    void GenerateParseTree(std::ostream &out) const;
+    /**
+     * @brief Generates the `VisitLexeme()` member function of the parse tree
+     * visitors.
+     */
+    void GenerateLexemeVisit(std::ostream &out) const;
+    /**
+     * @brief Generates the shift-reduce `Parser` class.
+     */
+    void GenerateLRParser(std::ostream &out) const;
+    /**
+     * @brief Generates the `Run()` member function of the LR(1) parser, the
+     * shift-reduce loop over the current input.
+     */
+    void GenerateLRLoop(std::ostream &out) const;
+    /**
+     * @brief Generates the `BundleTables` class mapping a table bundle into
+     * memory and the `BundleParser` class parsing with it. Nothing in them
+     * depends on the grammar.
+     */
+    void GenerateBundleParser(std::ostream &out) const;
+    /**
+     * @brief Generates the `WriteProfile()` member function of the profiling
+     * LR(1) parser.
+     */
+    void GenerateProfileWriter(std::ostream &out) const;
+    /**
+     * @brief Generates the part of the `Goto()` member function of the LR(1)
+     * parser that pushes the target state and the node.
+     */
+    void GenerateGotoPush(std::ostream &out) const;
+    /**
+     * @brief Generates the hand-off from the reductions of the LR(1) parser to
+     * the sub-parsers of the expressions and the tree builders shared by them.
+     */
+    void GenerateClimbing(std::ostream &out) const;
+    /**
+     * @brief Generates the sub-parser of the expression, which reads the
+     * operator after an operand and either continues the expression or
+     * builds its levels and hands the tree back to the LR(1) parser.
+     * @param e The index of the expression.
+     */
+    void GenerateClimber(std::ostream &out, size_t e) const;
+    /**
+     * @brief Generates the predictive `Parser` class.
+     */
+    void GenerateLLParser(std::ostream &out) const;
+    /**
+     * @brief Generates the `Parse()` overloads of the LL(1) and the bundle
+     * parsers taking the compact tokens of the lexer, which are converted
+     * to terminals first.
+     */
+    void GenerateLexedInputParse(std::ostream &out) const;
+    /**
+     * @brief Generates the `g_` member holding the rules of the grammar.
+     */
+    void GenerateGrammar(std::ostream &out) const;
+    /**
+     * @brief Generates the `QualName` helper member function.
+     */
+    void GenerateQualName(std::ostream &out) const;
+
     std::string folder_;
     const Grammar &g_;
-    const ActionTable &at_;
-    const GotoTable &gt_;
+    const DenseTables *tables_ = nullptr;
+    const CombTables *comb_ = nullptr;
+    const PredictTable *pt_ = nullptr;
     const FollowSets &fs_;
     bool add_json_generator_;
     size_t json_indents_;
+    bool bundle_ = false;
+    bool profile_ = false;
+    std::vector<Expression> expressions_;
 };
\ No newline at end of file
@@ -9,12 +9,67 @@
 
 #include <boost/bimap.hpp>
 #include <cstddef>
+#include <functional>
+#include <map>
 #include <optional>
 #include <set>
+#include <string>
+#include <utility>
+#include <vector>
 
 #include "Entities.h"
 #include "GrammarAnalyzer.h"
 
+/**
+ * @class AutomatonBudgetError
+ * @brief An exception class for reporting that building the automaton exceeded
+ * its budget.
+ */
+class AutomatonBudgetError : public std::exception {
+public:
+    /**
+     * @brief Constructs an AutomatonBudgetError object with the specified
+     * error.
+     * @param msg The error message.
+     */
+    explicit AutomatonBudgetError(const std::string &msg);
+    /**
+     * @brief Returns the error message.
+     * @return The error message.
+     */
+    const char *what() const noexcept override;
+
+private:
+    std::string msg_;
+};
+
+/**
+ * @struct AutomatonLimits
+ * @brief Limits and progress reporting for building the automaton.
+ */
+struct AutomatonLimits {
+    /**
+     * @brief The maximum number of states, 0 for no limit.
+     */
+    size_t max_states_ = 0;
+    /**
+     * @brief The maximum estimated memory in bytes taken by the states and
+     * the closure cache, 0 for no limit.
+     */
+    size_t max_memory_ = 0;
+    /**
+     * @brief The number of states between two calls of `on_progress_`, 0
+     * to disable progress reporting.
+     */
+    size_t report_every_ = 0;
+    /**
+     * @brief Called with the number of states built so far, the number of
+     * states whose transitions are not computed yet and the estimated
+     * memory in bytes.
+     */
+    std::function<void(size_t, size_t, size_t)> on_progress_;
+};
+
 /**
  * @class Automaton
  * @brief Represents an automaton, built by the production of the provided
@@ -80,12 +135,68 @@ public:
      */
     using StateMap = boost::bimap<size_t, State>;
 
+    /**
+     * @brief An alias for the transitions of the automaton, maps a state
+     * number and a token to the number of the state to go to.
+     */
+    using Transitions = std::vector<std::map<Token, size_t>>;
+
+    /**
+     * @struct CoreSplit
+     * @brief Describes an LR(0) core shared by several LR(1) states, i.e. the
+     * states that differ only in their lookaheads.
+     */
+    struct CoreSplit {
+        /**
+         * @brief The kernel items of the core as pairs of a rule number and a
+         * dot position.
+         */
+        std::vector<std::pair<size_t, size_t>> core_;
+        /**
+         * @brief The numbers of the states sharing the core.
+         */
+        std::vector<size_t> states_;
+        /**
+         * @brief The lookaheads of the kernel items that are not shared by all
+         * of the states, i.e. the ones that caused the split.
+         */
+        std::set<Terminal> lookaheads_;
+    };
+
     /**
      * @brief Constructs an Automaton object from Grammar and GrammarAnalyzer.
      * @param g The grammar.
      * @param ga The grammar analyzer.
+     * @param limits The limits for building the automaton.
+     * @throws AutomatonBudgetError if the automaton exceeds the limits. The
+     * message contains the report of the most split cores.
+     */
+    Automaton(
+        const Grammar &g, const GrammarAnalyzer &ga,
+        const AutomatonLimits &limits = {}
+    );
+
+    /**
+     * @brief Constructs an Automaton object from Grammar and GrammarAnalyzer,
+     * reusing the states of an automaton built for a previous version of the
+     * grammar.
+     * @details `ga` must have been constructed incrementally from the previous
+     * version of the grammar. Closures of the previous states that don't
+     * involve any changed non-terminal are reused as they are, and their
+     * transitions are only followed on tokens they had transitions on before.
+     * The resulting automaton is identical to the one built from scratch.
+     * @param g The grammar.
+     * @param ga The grammar analyzer.
+     * @param prev_states The states of the previous automaton.
+     * @param prev_transitions The transitions of the previous automaton.
+     * @param limits The limits for building the automaton.
+     * @throws AutomatonBudgetError if the automaton exceeds the limits.
      */
-    Automaton(const Grammar &g, const GrammarAnalyzer &ga);
+    Automaton(
+        const Grammar &g, const GrammarAnalyzer &ga,
+        const StateMap &prev_states, const Transitions &prev_transitions,
+        const AutomatonLimits &limits = {}
+    );
 
     /**
      * @brief Based on whether the current closure has already been computed,
@@ -111,6 +222,42 @@ public:
      */
     const StateMap &GetStates() const;
 
+    /**
+     * @brief Returns the transitions of the automaton.
+     * @return The transitions of the automaton.
+     */
+    const Transitions &GetTransitions() const;
+
+    /**
+     * @brief Returns the number of states whose closures were reused from the
+     * previous automaton.
+     * @return The number of reused states, 0 if the automaton was built from
+     * scratch.
+     */
+    size_t GetReusedStates() const;
+
+    /**
+     * @brief Returns the number of distinct LR(0) cores of the states.
+     */
+    size_t GetCoreCount() const;
+    /**
+     * @brief Returns the estimated memory in bytes taken by the states and the
+     * closure cache.
+     */
+    size_t GetEstimatedMemory() const;
+    /**
+     * @brief Returns the LR(0) cores split into the most LR(1) states.
+     * @param count The maximum number of cores to return.
+     * @return The cores shared by more than one state, most split first.
+     */
+    std::vector<CoreSplit> GetCoreSplits(size_t count) const;
+    /**
+     * @brief Formats the most split cores in a human-readable way.
+     * @param count The maximum number of cores to describe.
+     * @return The report, empty if no core is split.
+     */
+    std::string DescribeCoreSplits(size_t count) const;
+
     /**
      * @brief Returns the next token (if exists).
      * @param item The item to get the next token from.
@@ -136,17 +283,50 @@ private:
      * @return The closure of the given set of items.
      */
     std::set<Item> InternalClosure(const std::set<Item> &items) const;
+    /**
+     * @brief Seeds the closure cache with the previous states that are not
+     * affected by the changes in the grammar.
+     * @param prev_states The states of the previous automaton.
+     * @param prev_transitions The transitions of the previous automaton.
+     */
+    void ReuseStates(
+        const StateMap &prev_states, const Transitions &prev_transitions
+    );
     /**
      * @brief Computes the canonical collection (all possible states of the
      * automaton) for the grammar.
+     * @throws AutomatonBudgetError if the automaton exceeds the limits.
      */
     void BuildCanonicalCollection();
+    /**
+     * @brief Registers a new state, records its core and checks the limits.
+     * @param idx The number of the state.
+     * @param state The state.
+     * @param pending The number of states whose transitions are not computed
+     * yet.
+     * @throws AutomatonBudgetError if the automaton exceeds the limits.
+     */
+    void AddState(size_t idx, const State &state, size_t pending);
 
     const Grammar &g_;
     GrammarAnalyzer ga_;
 
     std::unordered_map<ItemSetKey, std::set<Item>, ItemSetKeyHash>
         closure_cache_;
+    /**
+     * @brief Maps the reused states to the tokens they had transitions on.
+     */
+    std::map<State, std::vector<Token>> reused_;
 
     StateMap states_;
+    Transitions transitions_;
+    size_t reused_states_ = 0;
+
+    AutomatonLimits limits_;
+    /**
+     * @brief Maps the LR(0) cores to the states sharing them.
+     */
+    std::map<std::vector<std::pair<size_t, size_t>>, std::vector<size_t>>
+        cores_;
+    size_t memory_ = 0;
 };
\ No newline at end of file
@@ -0,0 +1,137 @@
+/**
+ * @file CombTables.h
+ * @brief Provides a class for compressing the parser tables into displacement
+ * (comb-vector) arrays.
+ * @author Vadim Melnikov
+ * @version 1.0
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include "DenseTables.h"
+#include "Entities.h"
+
+/**
+ * @class CombTables
+ * @brief Packs the action and the goto tables into a single pair of comb
+ * vectors (Tarjan–Yao row displacement).
+ * @details Columns `0 .. T - 1` of a row are the terminals and columns `T ..
+ * T + N - 1` are the non-terminals. The non-empty cells of every row are
+ * placed into `next_` starting at `base_[state]`, so the cell of a state and a
+ * column is `next_[base_[state] + column]` if `check_` at that index equals the
+ * state, and empty otherwise. The unused slots are owned by the state with the
+ * number equal to the number of states, i.e. by none. Action cells store
+ * encoded actions (see DenseActionTable::Encode), goto cells store target
+ * states. Rows are placed first-fit, the densest ones first unless asked to
+ * keep the order of the states. The default actions of the states are kept in
+ * separate per-state arrays.
+ */
+class CombTables {
+public:
+    /**
+     * @brief Packs the tables.
+     * @param tables The tables to pack.
+     * @param in_order Whether to place the rows in the order of the states
+     * rather than the densest first, so that the rows of the states numbered
+     * close to each other end up close in the vectors (see
+     * TableOptimizer::ApplyProfile()).
+     */
+    explicit CombTables(const DenseTables &tables, bool in_order = false);
+
+    /**
+     * @brief Returns the action for the state and the terminal id, which is
+     * the default action of the state if the cell is empty.
+     */
+    Action GetAction(size_t state, size_t terminal) const;
+    /**
+     * @brief Returns the state to go to from the state on the non-terminal id.
+     * @return `std::nullopt` if there is no transition, the state otherwise.
+     */
+    std::optional<size_t> GetGoto(size_t state, size_t nonterminal) const;
+
+    /**
+     * @brief Returns the number of states (rows).
+     */
+    size_t GetStateCount() const;
+    /**
+     * @brief Returns the number of terminal columns, which is less than the
+     * number of terminals if some of them share a column.
+     */
+    size_t GetTerminalCount() const;
+    /**
+     * @brief Returns the number of non-terminal columns.
+     */
+    size_t GetNonTerminalCount() const;
+    /**
+     * @brief Returns the displacement of every state.
+     */
+    const std::vector<uint32_t> &GetBase() const;
+    /**
+     * @brief Returns the packed cells.
+     */
+    const std::vector<uint32_t> &GetNext() const;
+    /**
+     * @brief Returns the owner state of every packed cell.
+     */
+    const std::vector<uint32_t> &GetCheck() const;
+    /**
+     * @brief Returns the encoded default action of every state.
+     */
+    const std::vector<uint32_t> &GetDefaults() const;
+    /**
+     * @brief Returns 1 for every state that takes its default action without
+     * reading the lookahead, 0 for the others.
+     */
+    const std::vector<uint32_t> &GetDefaultOnly() const;
+    /**
+     * @brief Returns the terminal column of every terminal id.
+     */
+    const std::vector<uint32_t> &GetTerminalClasses() const;
+
+    /**
+     * @brief Returns the number of bytes of the smallest unsigned integer type
+     * (of 1, 2 and 4 bytes) that can hold the value.
+     */
+    static size_t WidthFor(uint64_t max_value);
+    /**
+     * @brief Returns the width of the elements of the emitted `base` array.
+     */
+    size_t GetBaseWidth() const;
+    /**
+     * @brief Returns the width of the elements of the emitted `next` array.
+     */
+    size_t GetNextWidth() const;
+    /**
+     * @brief Returns the width of the elements of the emitted `check` array.
+     */
+    size_t GetCheckWidth() const;
+    /**
+     * @brief Returns the width of the elements of the emitted array of the
+     * default actions.
+     */
+    size_t GetDefaultWidth() const;
+    /**
+     * @brief Returns the size in bytes of all arrays as emitted.
+     */
+    size_t GetByteSize() const;
+
+private:
+    /**
+     * @brief Returns the packed cell for the state and the column.
+     * @return `std::nullopt` if the cell is empty, its value otherwise.
+     */
+    std::optional<uint32_t> Lookup(size_t state, size_t column) const;
+
+    size_t terminal_count_;
+    size_t nonterminal_count_;
+    std::vector<uint32_t> base_;
+    std::vector<uint32_t> next_;
+    std::vector<uint32_t> check_;
+    std::vector<uint32_t> defaults_;
+    std::vector<uint32_t> default_only_;
+    std::vector<uint32_t> terminal_classes_;
+};
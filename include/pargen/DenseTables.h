@@ -0,0 +1,340 @@
+/**
+ * @file DenseTables.h
+ * @brief Provides dense, integer-indexed representations of the parser tables.
+ * @author Vadim Melnikov
+ * @version 1.0
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "Entities.h"
+
+/**
+ * @class SymbolIds
+ * @brief Assigns consecutive ids to the terminals and to the non-terminals of
+ * a grammar, which are used as column indices of the dense tables.
+ * @details Terminals are identified by their qualified names, so a regex
+ * terminal gets a single id whatever its `repr_` is. The end of input marker
+ * always gets the terminal id 0, the epsilon terminal gets no id.
+ */
+class SymbolIds {
+public:
+    /**
+     * @brief Constructs an empty SymbolIds object.
+     */
+    SymbolIds() = default;
+    /**
+     * @brief Assigns ids to the symbols of the grammar.
+     * @param g The grammar.
+     */
+    explicit SymbolIds(const Grammar &g);
+
+    /**
+     * @brief Assigns the next id to the terminal if it has none yet.
+     * @param t The terminal.
+     * @return The id of the terminal.
+     */
+    size_t AddTerminal(const Terminal &t);
+    /**
+     * @brief Assigns the next id to the non-terminal if it has none yet.
+     * @param nt The non-terminal.
+     * @return The id of the non-terminal.
+     */
+    size_t AddNonTerminal(const NonTerminal &nt);
+
+    /**
+     * @brief Returns the number of terminals.
+     */
+    size_t GetTerminalCount() const;
+    /**
+     * @brief Returns the number of non-terminals.
+     */
+    size_t GetNonTerminalCount() const;
+
+    /**
+     * @brief Looks up the id of the terminal.
+     * @return `std::nullopt` if the terminal has no id, the id otherwise.
+     */
+    std::optional<size_t> FindTerminal(const Terminal &t) const;
+    /**
+     * @brief Looks up the id of the non-terminal.
+     * @return `std::nullopt` if the non-terminal has no id, the id otherwise.
+     */
+    std::optional<size_t> FindNonTerminal(const NonTerminal &nt) const;
+    /**
+     * @brief Returns the id of the terminal.
+     * @throws std::out_of_range if the terminal has no id.
+     */
+    size_t GetTerminalId(const Terminal &t) const;
+    /**
+     * @brief Returns the id of the non-terminal.
+     * @throws std::out_of_range if the non-terminal has no id.
+     */
+    size_t GetNonTerminalId(const NonTerminal &nt) const;
+
+    /**
+     * @brief Returns the terminal with the given id.
+     */
+    const Terminal &GetTerminal(size_t id) const;
+    /**
+     * @brief Returns the qualified name of the terminal with the given id.
+     */
+    const std::string &GetTerminalName(size_t id) const;
+    /**
+     * @brief Returns the non-terminal with the given id.
+     */
+    const NonTerminal &GetNonTerminal(size_t id) const;
+
+private:
+    std::vector<Terminal> terminals_;
+    std::vector<std::string> terminal_names_;
+    std::vector<NonTerminal> nonterminals_;
+    // `Terminal::operator<` orders terminals the same way their qualified
+    // names do, so no string has to be built for a lookup
+    std::map<Terminal, size_t> terminal_ids_;
+    std::unordered_map<NonTerminal, size_t> nonterminal_ids_;
+};
+
+/**
+ * @class DenseActionTable
+ * @brief An action table stored as a row-major states × terminals matrix of
+ * encoded actions.
+ * @details An action is encoded into a 32-bit cell: the lower `kTypeBits` bits
+ * store the type, the rest stores the value. An empty cell is an ERROR action,
+ * so a freshly constructed table rejects everything. Every state may also have
+ * a default action which replaces the empty cells of its row. The table is
+ * move-only, use `Clone()` to copy it explicitly.
+ */
+class DenseActionTable {
+public:
+    /**
+     * @brief The type of an encoded action.
+     */
+    using Cell = uint32_t;
+    /**
+     * @brief The number of lower bits of a cell that store the action type.
+     */
+    static constexpr unsigned kTypeBits = 3;
+
+    /**
+     * @brief Constructs an empty table.
+     */
+    DenseActionTable() = default;
+    /**
+     * @brief Constructs a table of ERROR actions.
+     * @param states The number of states (rows).
+     * @param terminals The number of terminals (columns).
+     */
+    DenseActionTable(size_t states, size_t terminals);
+
+    DenseActionTable(const DenseActionTable &) = delete;
+    DenseActionTable &operator=(const DenseActionTable &) = delete;
+    DenseActionTable(DenseActionTable &&) = default;
+    DenseActionTable &operator=(DenseActionTable &&) = default;
+
+    /**
+     * @brief Returns a copy of the table.
+     */
+    DenseActionTable Clone() const;
+
+    /**
+     * @brief Encodes an action into a cell.
+     * @throws std::out_of_range if the value of the action doesn't fit.
+     */
+    static Cell Encode(const Action &action);
+    /**
+     * @brief Decodes an action from a cell.
+     */
+    static Action Decode(Cell cell);
+
+    /**
+     * @brief Returns the number of states (rows).
+     */
+    size_t GetStateCount() const;
+    /**
+     * @brief Returns the number of terminals (columns).
+     */
+    size_t GetTerminalCount() const;
+
+    /**
+     * @brief Returns the action for the state and the terminal id.
+     */
+    Action Get(size_t state, size_t terminal) const;
+    /**
+     * @brief Sets the action for the state and the terminal id.
+     */
+    void Set(size_t state, size_t terminal, const Action &action);
+    /**
+     * @brief Returns the encoded actions of the state.
+     */
+    std::span<const Cell> GetRow(size_t state) const;
+    /**
+     * @brief Returns all encoded actions, row by row.
+     */
+    const std::vector<Cell> &GetCells() const;
+
+    /**
+     * @brief Returns the action taken by the state on the terminal id, which is
+     * the default action of the state if the cell is empty.
+     */
+    Action Resolve(size_t state, size_t terminal) const;
+    /**
+     * @brief Returns the default action of the state, ERROR if it has none.
+     */
+    Action GetDefault(size_t state) const;
+    /**
+     * @brief Sets the default action of the state.
+     */
+    void SetDefault(size_t state, const Action &action);
+    /**
+     * @brief Returns whether the state takes its default action on every
+     * terminal, i.e. has a default action and an empty row.
+     */
+    bool IsDefaultOnly(size_t state) const;
+    /**
+     * @brief Returns the encoded default actions of all states.
+     */
+    const std::vector<Cell> &GetDefaults() const;
+
+private:
+    size_t terminals_ = 0;
+    std::vector<Cell> cells_;
+    std::vector<Cell> defaults_;
+};
+
+/**
+ * @class DenseGotoTable
+ * @brief A goto table stored as a row-major states × non-terminals matrix of
+ * target states.
+ * @details Cells without a transition store `kNone`. The table is move-only,
+ * use `Clone()` to copy it explicitly.
+ */
+class DenseGotoTable {
+public:
+    /**
+     * @brief The type of a cell.
+     */
+    using Cell = uint32_t;
+    /**
+     * @brief The value of a cell without a transition.
+     */
+    static constexpr Cell kNone = UINT32_MAX;
+
+    /**
+     * @brief Constructs an empty table.
+     */
+    DenseGotoTable() = default;
+    /**
+     * @brief Constructs a table without transitions.
+     * @param states The number of states (rows).
+     * @param nonterminals The number of non-terminals (columns).
+     */
+    DenseGotoTable(size_t states, size_t nonterminals);
+
+    DenseGotoTable(const DenseGotoTable &) = delete;
+    DenseGotoTable &operator=(const DenseGotoTable &) = delete;
+    DenseGotoTable(DenseGotoTable &&) = default;
+    DenseGotoTable &operator=(DenseGotoTable &&) = default;
+
+    /**
+     * @brief Returns a copy of the table.
+     */
+    DenseGotoTable Clone() const;
+
+    /**
+     * @brief Returns the number of states (rows).
+     */
+    size_t GetStateCount() const;
+    /**
+     * @brief Returns the number of non-terminals (columns).
+     */
+    size_t GetNonTerminalCount() const;
+
+    /**
+     * @brief Returns the state to go to from the state on the non-terminal id.
+     * @return `std::nullopt` if there is no transition, the state otherwise.
+     */
+    std::optional<size_t> Get(size_t state, size_t nonterminal) const;
+    /**
+     * @brief Sets the state to go to from the state on the non-terminal id.
+     * @throws std::out_of_range if the target doesn't fit into a cell.
+     */
+    void Set(size_t state, size_t nonterminal, size_t target);
+    /**
+     * @brief Returns the cells of the state.
+     */
+    std::span<const Cell> GetRow(size_t state) const;
+    /**
+     * @brief Returns all cells, row by row.
+     */
+    const std::vector<Cell> &GetCells() const;
+
+private:
+    size_t nonterminals_ = 0;
+    std::vector<Cell> cells_;
+};
+
+/**
+ * @struct DenseTables
+ * @brief Owns both dense parser tables and the ids of their columns.
+ */
+struct DenseTables {
+    /**
+     * @brief The ids of the symbols indexing the columns of the tables.
+     */
+    SymbolIds symbols_;
+    /**
+     * @brief The action table.
+     */
+    DenseActionTable action_;
+    /**
+     * @brief The goto table.
+     */
+    DenseGotoTable goto_;
+    /**
+     * @brief The column of the action table of every terminal id, empty if
+     * every terminal has a column of its own.
+     * @details Terminals with equal columns share a single one, so the columns
+     * of the action table are the classes of such terminals.
+     */
+    std::vector<uint32_t> terminal_classes_;
+
+    /**
+     * @brief The non-terminals of the unit reductions bypassed by the goto
+     * transitions, keyed by the state and the non-terminal id of the
+     * transition.
+     * @details The ids are listed in the order the reductions were taken in,
+     * so wrapping the node of the transition into nodes of these non-terminals
+     * one by one restores the skipped part of the tree. Empty if no reduction
+     * was bypassed or the skipped nodes are dropped.
+     */
+    std::map<std::pair<size_t, size_t>, std::vector<size_t>> unit_chains_;
+
+    /**
+     * @brief Returns a copy of the tables.
+     */
+    DenseTables Clone() const;
+
+    /**
+     * @brief Returns the column of the action table of the terminal id.
+     */
+    size_t GetTerminalColumn(size_t terminal) const;
+
+    /**
+     * @brief Converts the action table to a map keyed by qualified names.
+     */
+    ActionTable ToActionTable() const;
+    /**
+     * @brief Converts the goto table to a map keyed by non-terminals.
+     */
+    GotoTable ToGotoTable() const;
+};
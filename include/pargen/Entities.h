@@ -194,8 +194,11 @@ using FollowSets = std::unordered_map<NonTerminal, std::set<Terminal>>;
 /**
  * @enum ActionType
  * @brief Enum for the type of action in a generated action table.
+ * @details SHIFT_REDUCE shifts a terminal and immediately reduces by a rule
+ * ending with it, without pushing the state the shift leads to. It is only
+ * produced by TableOptimizer::FuseShiftReduce().
  */
-enum class ActionType { SHIFT, REDUCE, ACCEPT, ERROR };
+enum class ActionType { SHIFT, REDUCE, ACCEPT, ERROR, SHIFT_REDUCE };
 
 /**
  * @struct Action
@@ -209,8 +212,8 @@ struct Action {
     /**
      * @brief Stores the value related to the action.
      * @details For SHIFT actions, stores the state number to shift to. For
-     * REDUCE actions, stores the production number to reduce with. Stores 0 for
-     * other ones.
+     * REDUCE and SHIFT_REDUCE actions, stores the production number to reduce
+     * with. Stores 0 for other ones.
      */
     size_t value_ = 0;
 };
@@ -218,6 +221,7 @@ struct Action {
 /**
  * @brief Alias for an action table, maps a state number and a qualified name of
  * a terminal to an action.
+ * @see DenseActionTable for the representation the generator works with.
  */
 using ActionTable = std::vector<std::unordered_map<std::string, Action>>;
 /**
@@ -225,6 +229,7 @@ using ActionTable = std::vector<std::unordered_map<std::string, Action>>;
  * state number.
  * @details Unlike the action table, the goto table is a map of maps, as goto
  * tables tend to be much sparser than action tables.
+ * @see DenseGotoTable for the representation the generator works with.
  */
 using GotoTable =
     std::unordered_map<size_t, std::unordered_map<NonTerminal, size_t>>;
\ No newline at end of file
@@ -0,0 +1,144 @@
+/**
+ * @file ExpressionAnalyzer.h
+ * @brief Provides a class for recognizing the precedence levels of binary
+ * expressions in a grammar, which lets the generated parser handle them with
+ * a precedence-climbing sub-parser.
+ * @author Vadim Melnikov
+ * @version 1.0
+ */
+#pragma once
+
+#include <optional>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "Entities.h"
+
+/**
+ * @class ExpressionError
+ * @brief An exception class for reporting a non-terminal that can't be parsed
+ * as an expression.
+ */
+class ExpressionError : public std::exception {
+public:
+    /**
+     * @brief Constructs an ExpressionError object with the specified error.
+     * @param msg The error message.
+     */
+    explicit ExpressionError(const std::string &msg);
+
+    /**
+     * @brief Returns the error message.
+     * @return The error message.
+     */
+    const char *what() const noexcept override;
+
+private:
+    std::string msg_;
+};
+
+/**
+ * @struct ExpressionLevel
+ * @brief Describes a precedence level of an expression, a sequence of
+ * operands of the next level separated by left-associative operators.
+ * @details A level is either left-recursive:
+ * `<E> = <E> '+' <T> | <E> '-' <T> | <T>`, or written with a right-recursive
+ * tail: `<E> = <T> <ETail>`, `<ETail> = '+' <T> <ETail> | EPSILON`.
+ */
+struct ExpressionLevel {
+    /**
+     * @brief The non-terminal of the level.
+     */
+    NonTerminal lhs_;
+    /**
+     * @brief The tail non-terminal of a level written with one,
+     * `std::nullopt` for a left-recursive level.
+     */
+    std::optional<NonTerminal> tail_;
+    /**
+     * @brief The operators of the level.
+     */
+    std::vector<Terminal> operators_;
+    /**
+     * @brief The non-terminal of the next level, or the operand of the
+     * expression for the last level.
+     */
+    NonTerminal next_;
+};
+
+/**
+ * @struct Expression
+ * @brief Describes an expression non-terminal and its precedence levels.
+ */
+struct Expression {
+    /**
+     * @brief The levels from the loosest to the tightest one, the first level
+     * is the expression non-terminal itself.
+     */
+    std::vector<ExpressionLevel> levels_;
+    /**
+     * @brief The non-terminal of the operands of the tightest level, parsed by
+     * the LR parser.
+     */
+    NonTerminal operand_;
+};
+
+/**
+ * @class ExpressionAnalyzer
+ * @brief Finds the precedence levels of an expression non-terminal and checks
+ * that a precedence-climbing sub-parser builds the same tree for it as the LR
+ * parser.
+ */
+class ExpressionAnalyzer {
+public:
+    /**
+     * @brief Constructs an ExpressionAnalyzer object for the grammar.
+     * @param g The grammar.
+     */
+    explicit ExpressionAnalyzer(const Grammar &g);
+
+    /**
+     * @brief Finds the levels of the expression.
+     * @details The levels are followed from the expression as long as the
+     * next non-terminal has the shape of a level, the first one that doesn't
+     * is the operand. The sub-parser takes every operator after an operand
+     * as a part of the expression and only hands the operands to the LR
+     * parser, so the operators may only appear in the rules of the levels,
+     * the levels but the first one and the operand may only be used by the
+     * levels, and the operand may not be empty or start with a level.
+     * @param root The expression non-terminal.
+     * @return The expression.
+     * @throws ExpressionError if the non-terminal is not an expression or
+     * can't be parsed by the sub-parser.
+     */
+    Expression Analyze(const NonTerminal &root) const;
+    /**
+     * @brief Finds the levels of several expressions.
+     * @param roots The expression non-terminals, repeated ones are analyzed
+     * once.
+     * @return The expressions in the order of the roots.
+     * @throws ExpressionError if a non-terminal is not an expression, can't be
+     * parsed by the sub-parser or is a level of another expression.
+     */
+    std::vector<Expression> Analyze(const std::vector<NonTerminal> &roots
+    ) const;
+
+private:
+    /**
+     * @brief Returns the level with the non-terminal, `std::nullopt` if the
+     * non-terminal doesn't have the shape of a level.
+     */
+    std::optional<ExpressionLevel> MatchLevel(const NonTerminal &nt) const;
+    /**
+     * @brief Returns the rules with the left-hand side.
+     */
+    std::vector<const Rule *> RulesOf(const NonTerminal &nt) const;
+    /**
+     * @brief Returns the names of the non-terminals that derive the empty
+     * string.
+     */
+    std::set<std::string> FindNullable() const;
+
+    const Grammar &g_;
+};
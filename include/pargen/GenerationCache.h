@@ -0,0 +1,153 @@
+/**
+ * @file GenerationCache.h
+ * @brief Provides a persistent on-disk cache for the results of the generation
+ * pipeline (grammar, FIRST/FOLLOW sets, automaton and parser tables).
+ * @author Vadim Melnikov
+ * @version 1.0
+ */
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+
+#include "Automaton.h"
+#include "DenseTables.h"
+#include "Entities.h"
+
+/**
+ * @class GenerationCacheError
+ * @brief An exception class for reporting errors while reading or writing a
+ * cache entry.
+ */
+class GenerationCacheError : public std::exception {
+public:
+    /**
+     * @brief Constructs a GenerationCacheError object with the specified error.
+     * @param msg The error message.
+     */
+    explicit GenerationCacheError(const std::string &msg);
+
+    /**
+     * @brief Returns the error message.
+     * @return The error message.
+     */
+    const char *what() const noexcept override;
+
+private:
+    std::string msg_;
+};
+
+/**
+ * @struct CacheEntry
+ * @brief Stores everything computed for a grammar before the code generation
+ * stage.
+ * @details The entry is move-only, as the tables it owns are.
+ */
+struct CacheEntry {
+    /**
+     * @brief The parsed and augmented grammar.
+     */
+    Grammar grammar_;
+    /**
+     * @brief The FIRST sets of the grammar.
+     */
+    FirstSets first_;
+    /**
+     * @brief The FOLLOW sets of the grammar.
+     */
+    FollowSets follow_;
+    /**
+     * @brief The states of the LR(1) automaton built for the grammar.
+     */
+    Automaton::StateMap states_;
+    /**
+     * @brief The transitions of the LR(1) automaton built for the grammar.
+     */
+    Automaton::Transitions transitions_;
+    /**
+     * @brief The parser tables built for the grammar.
+     */
+    DenseTables tables_;
+};
+
+/**
+ * @class GenerationCache
+ * @brief A directory of cache entries, each stored in a compact binary format
+ * under the content hash of the grammar it was produced from.
+ */
+class GenerationCache {
+public:
+    /**
+     * @brief Constructs a GenerationCache object. The folder is created if it
+     * does not exist.
+     * @param folder The folder the cache entries are stored in.
+     * @throws GenerationCacheError if the folder can't be created.
+     */
+    explicit GenerationCache(const std::string &folder);
+
+    /**
+     * @brief Computes the key of a grammar.
+     * @details The key is a 64-bit FNV-1a hash of the cache format version,
+     * the generation options and the raw text of the grammar file, so any
+     * change to either of them invalidates the entry.
+     * @param grammar_text The contents of the grammar file.
+     * @param options The options that affect the contents of the entry.
+     * @return The key of the grammar.
+     */
+    static uint64_t Key(
+        const std::string &grammar_text, const std::string &options = ""
+    );
+
+    /**
+     * @brief Looks up the entry stored under the given key.
+     * @details The FNV-1a checksum of the entry is checked before it is
+     * decoded, and every table cell has to refer to an existing state or
+     * rule.
+     * @param key The key of the grammar.
+     * @return `std::nullopt` if there is no entry for the key or it was written
+     * by an incompatible version, the entry otherwise.
+     * @throws GenerationCacheError if the entry exists but is corrupted.
+     */
+    std::optional<CacheEntry> Load(uint64_t key) const;
+
+    /**
+     * @brief Stores the entry under the given key, replacing the existing one.
+     * @details The entry is written to a temporary file first and then renamed,
+     * so concurrent readers never observe a partially written entry.
+     * @param key The key of the grammar.
+     * @param entry The entry to store.
+     * @throws GenerationCacheError if the entry can't be written.
+     */
+    void Store(uint64_t key, const CacheEntry &entry) const;
+
+    /**
+     * @brief Remembers the key of the latest entry generated from the given
+     * grammar file.
+     * @param source The path to the grammar file.
+     * @param key The key of the entry.
+     */
+    void MarkLatest(const std::string &source, uint64_t key) const;
+
+    /**
+     * @brief Looks up the latest entry generated from the given grammar file,
+     * which may have been generated from an older version of the file.
+     * @param source The path to the grammar file.
+     * @return `std::nullopt` if there is no such entry, the entry otherwise.
+     * @throws GenerationCacheError if the entry exists but is corrupted.
+     */
+    std::optional<CacheEntry> LoadLatest(const std::string &source) const;
+
+private:
+    /**
+     * @brief Returns the path of the file storing the entry for the given key.
+     */
+    std::string PathFor(uint64_t key) const;
+    /**
+     * @brief Returns the path of the file storing the key of the latest entry
+     * for the given grammar file.
+     */
+    std::string LatestPathFor(const std::string &source) const;
+
+    std::string folder_;
+};
@@ -7,11 +7,38 @@
  */
 #pragma once
 
+#include <optional>
 #include <set>
+#include <unordered_set>
 #include <vector>
 
 #include "Entities.h"
 
+/**
+ * @struct GrammarDiff
+ * @brief Describes how a grammar differs from its previous version.
+ */
+struct GrammarDiff {
+    /**
+     * @brief Maps a rule number in the previous grammar to the number of the
+     * same rule in the current grammar, `std::nullopt` if the rule was removed.
+     */
+    std::vector<std::optional<size_t>> rule_mapping_;
+    /**
+     * @brief Stores the non-terminals whose set of productions or FIRST set
+     * differs from the previous grammar.
+     */
+    std::unordered_set<NonTerminal> changed_;
+    /**
+     * @brief The number of FIRST sets that had to be recomputed.
+     */
+    size_t recomputed_first_ = 0;
+    /**
+     * @brief The number of FOLLOW sets that had to be recomputed.
+     */
+    size_t recomputed_follow_ = 0;
+};
+
 /**
  * @class GrammarAnalyzer
  * @brief A class for computing FIRST and FOLLOW sets for a given grammar.
@@ -24,6 +51,25 @@ public:
      */
     explicit GrammarAnalyzer(const Grammar &g);
 
+    /**
+     * @brief Constructs a GrammarAnalyzer object, reusing the sets computed for
+     * a previous version of the grammar.
+     * @details Only the FIRST sets of the non-terminals that (transitively)
+     * depend on a changed rule through the nullable prefixes of their rules
+     * and the FOLLOW sets of the non-terminals that occur in a changed rule
+     * or before such a non-terminal with only nullable symbols in between
+     * are recomputed, the rest are taken from the previous sets. The result is identical to the
+     * one computed from scratch.
+     * @param g The grammar to construct GrammarAnalyzer from and analyze.
+     * @param prev_g The previous version of the grammar.
+     * @param prev_first The FIRST sets computed for the previous grammar.
+     * @param prev_follow The FOLLOW sets computed for the previous grammar.
+     */
+    GrammarAnalyzer(
+        const Grammar &g, const Grammar &prev_g, const FirstSets &prev_first,
+        const FollowSets &prev_follow
+    );
+
     /**
      * @brief Using precomputed FIRST sets, computes the FIRST set for a
      * sequence of tokens.
@@ -42,20 +88,48 @@ public:
      * @return Const reference to the FOLLOW sets.
      */
     const FollowSets &GetFollow() const;
+    /**
+     * @brief Returns the difference from the previous grammar.
+     * @return `std::nullopt` if the sets were computed from scratch, the
+     * difference otherwise.
+     */
+    const std::optional<GrammarDiff> &GetDiff() const;
 
 private:
     /**
      * @brief Computes the FIRST sets for the grammar.
+     * @param prev_first The sets to start from for the non-terminals that are
+     * not in `affected`.
+     * @param affected The non-terminals whose FIRST sets are recomputed.
      */
-    void ComputeFirst();
+    void ComputeFirst(
+        const FirstSets &prev_first,
+        const std::unordered_set<NonTerminal> &affected
+    );
 
     /**
      * @brief Computes the FOLLOW sets for the grammar.
+     * @param prev_follow The sets to start from for the non-terminals that are
+     * not in `affected`.
+     * @param affected The non-terminals whose FOLLOW sets are recomputed.
+     */
+    void ComputeFollow(
+        const FollowSets &prev_follow,
+        const std::unordered_set<NonTerminal> &affected
+    );
+
+    /**
+     * @brief Matches the rules of the grammar against the rules of its
+     * previous version and fills in `diff_`.
+     * @param prev_g The previous version of the grammar.
+     * @return The rules of either grammar that have no counterpart in the
+     * other one.
      */
-    void ComputeFollow();
+    std::vector<Rule> Diff(const Grammar &prev_g);
 
     const Grammar &g_;
 
     FirstSets first_;
     FollowSets follow_;
+    std::optional<GrammarDiff> diff_;
 };
\ No newline at end of file
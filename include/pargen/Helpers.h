@@ -6,6 +6,9 @@
  */
 #pragma once
 
+#include <optional>
+#include <string>
+
 #include "Entities.h"
 
 /**
@@ -37,4 +40,22 @@ bool IsNonTerminal(const Token &token);
  * @param token The token to get the qualified name for.
  * @return The qualified name of the token.
  */
-std::string QualName(Token token);
\ No newline at end of file
+std::string QualName(Token token);
+
+/**
+ * @brief Formats the token the way it is written in a grammar file.
+ * @param token The token to format.
+ * @return `<name>` for a non-terminal, `'name'` for a quote terminal, `name`
+ * for a regex terminal and `EPSILON` for the empty string.
+ */
+std::string DescribeToken(const Token &token);
+/**
+ * @brief Formats the rule the way it is written in a grammar file.
+ * @param rule The rule to format.
+ * @param dot If set, the position of the dot to mark in the production (as in
+ * an automaton item).
+ * @return The formatted rule.
+ */
+std::string DescribeRule(
+    const Rule &rule, std::optional<size_t> dot = std::nullopt
+);
@@ -0,0 +1,98 @@
+/**
+ * @file LLTableBuilder.h
+ * @brief Provides a class for checking whether a grammar is LL(1) and building
+ * a predictive parsing table for it.
+ * @author Vadim Melnikov
+ * @version 1.0
+ */
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Entities.h"
+#include "GrammarAnalyzer.h"
+
+/**
+ * @brief Alias for a predictive parsing table, maps a non-terminal and a
+ * qualified name of a lookahead terminal to the number of the rule to expand
+ * the non-terminal with.
+ */
+using PredictTable = std::unordered_map<
+    NonTerminal, std::unordered_map<std::string, size_t>>;
+
+/**
+ * @struct LLConflict
+ * @brief Describes a cell of the predictive parsing table claimed by two rules.
+ */
+struct LLConflict {
+    /**
+     * @brief The non-terminal being expanded.
+     */
+    NonTerminal nt_;
+    /**
+     * @brief The lookahead terminal both rules are predicted on.
+     */
+    Terminal lookahead_;
+    /**
+     * @brief The number of the rule that claimed the cell first.
+     */
+    size_t first_rule_;
+    /**
+     * @brief The number of the rule that claimed the cell second.
+     */
+    size_t second_rule_;
+};
+
+/**
+ * @class LLParserTables
+ * @brief A class for building a predictive (LL(1)) parsing table.
+ * @details The table is built from the FIRST and FOLLOW sets alone, without
+ * constructing an automaton: a rule `A = α` is predicted on every terminal of
+ * FIRST(α) and, if α derives the empty string, on every terminal of
+ * FOLLOW(A). The grammar is LL(1) iff no cell is claimed by two rules.
+ */
+class LLParserTables {
+public:
+    /**
+     * @brief Constructs an LLParserTables object.
+     * @param g The grammar to build the table for.
+     * @param ga The GrammarAnalyzer that provides pregenerated sets for the
+     * grammar.
+     */
+    LLParserTables(const Grammar &g, const GrammarAnalyzer &ga);
+
+    /**
+     * @brief Builds the predictive parsing table and collects the conflicts.
+     */
+    void Generate();
+
+    /**
+     * @brief Checks whether the grammar is LL(1).
+     * @return `true` if the table has no conflicts, `false` otherwise.
+     */
+    bool IsLL1() const;
+
+    /**
+     * @brief Returns the conflicts found while building the table.
+     */
+    const std::vector<LLConflict> &GetConflicts() const;
+
+    /**
+     * @brief Formats the conflicts in a human-readable way, one per line.
+     */
+    std::string DescribeConflicts() const;
+
+    /**
+     * @brief Returns the predictive parsing table.
+     */
+    const PredictTable &GetTable() const;
+
+private:
+    const Grammar &g_;
+    const GrammarAnalyzer &ga_;
+
+    PredictTable table_;
+    std::vector<LLConflict> conflicts_;
+};
@@ -0,0 +1,115 @@
+/**
+ * @file LayoutProfile.h
+ * @brief Provides the transition-frequency profile gathered by running an
+ * instrumented generated parser over a corpus, used to lay out the tables.
+ * @author Vadim Melnikov
+ * @version 1.0
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "DenseTables.h"
+
+/**
+ * @class LayoutProfileError
+ * @brief An exception class for reporting errors while reading a profile or
+ * applying it to tables it wasn't gathered with.
+ */
+class LayoutProfileError : public std::exception {
+public:
+    /**
+     * @brief Constructs a LayoutProfileError object with the specified error.
+     * @param msg The error message.
+     */
+    explicit LayoutProfileError(const std::string &msg);
+
+    /**
+     * @brief Returns the error message.
+     * @return The error message.
+     */
+    const char *what() const noexcept override;
+
+private:
+    std::string msg_;
+};
+
+/**
+ * @class LayoutProfile
+ * @brief Counts how many times the generated parser visited every state and
+ * shifted every terminal.
+ * @details The profile is written by `Parser::WriteProfile()` of a parser
+ * generated with the profile hooks. The first line is
+ * `pargen-profile <version> <fingerprint> <states>`, followed by a
+ * `state <state> <count>` line for every visited state and a
+ * `terminal <count> <qualified name>` line for every shifted terminal. The
+ * fingerprint identifies the tables the parser was generated from, see
+ * Fingerprint().
+ */
+class LayoutProfile {
+public:
+    /**
+     * @brief The format version, bumped on every incompatible change.
+     */
+    static constexpr uint32_t kVersion = 1;
+
+    /**
+     * @brief Constructs an empty profile for the tables.
+     * @param fingerprint The fingerprint of the tables.
+     * @param states The number of states of the tables.
+     */
+    LayoutProfile(uint64_t fingerprint, size_t states);
+
+    /**
+     * @brief Reads a profile written by a generated parser.
+     * @param in The stream to read from.
+     * @return The profile.
+     * @throws LayoutProfileError if the stream is not a profile of this
+     * version or is malformed.
+     */
+    static LayoutProfile Read(std::istream &in);
+    /**
+     * @brief Computes the fingerprint of the tables, an FNV-1a hash of their
+     * cells, default actions and terminal classes.
+     */
+    static uint64_t Fingerprint(const DenseTables &tables);
+
+    /**
+     * @brief Returns the fingerprint of the tables the profile was gathered
+     * with.
+     */
+    uint64_t GetFingerprint() const;
+    /**
+     * @brief Returns the number of states of the tables the profile was
+     * gathered with.
+     */
+    size_t GetStateCount() const;
+    /**
+     * @brief Returns the number of visits of the state.
+     */
+    size_t GetStateVisits(size_t state) const;
+    /**
+     * @brief Returns the number of shifts of the terminal with the qualified
+     * name.
+     */
+    size_t GetTerminalShifts(const std::string &name) const;
+    /**
+     * @brief Adds visits of the state.
+     * @throws LayoutProfileError if there is no such state.
+     */
+    void AddStateVisits(size_t state, size_t count);
+    /**
+     * @brief Adds shifts of the terminal with the qualified name.
+     */
+    void AddTerminalShifts(const std::string &name, size_t count);
+
+private:
+    uint64_t fingerprint_;
+    std::vector<size_t> state_visits_;
+    std::map<std::string, size_t> terminal_shifts_;
+};
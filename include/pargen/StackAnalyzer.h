@@ -0,0 +1,177 @@
+/**
+ * @file StackAnalyzer.h
+ * @brief Provides a class for estimating how the stack of the generated LR
+ * parser grows with the size of the input.
+ * @author Vadim Melnikov
+ * @version 1.0
+ */
+#pragma once
+
+#include <cstddef>
+#include <optional>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "Automaton.h"
+#include "Entities.h"
+#include "GrammarAnalyzer.h"
+
+/**
+ * @enum RecursionKind
+ * @brief Describes how a non-terminal refers to itself.
+ */
+enum class RecursionKind {
+    /**
+     * @brief The non-terminal is not recursive, the stack it needs is bounded.
+     */
+    NONE,
+    /**
+     * @brief The non-terminal is only left-recursive. An LR parser reduces
+     * every element before reading the next one, so the stack is bounded.
+     */
+    LEFT,
+    /**
+     * @brief The non-terminal is right-recursive. Every element stays on the
+     * stack until the end of the list is reached.
+     */
+    RIGHT,
+    /**
+     * @brief The non-terminal is self-embedding (e.g. `<E> = '(' <E> ')'`).
+     * The stack grows with the nesting depth.
+     */
+    NESTED
+};
+
+/**
+ * @struct GrowthSite
+ * @brief Describes an occurrence of a non-terminal in a rule that lies on a
+ * cycle of the grammar.
+ */
+struct GrowthSite {
+    /**
+     * @brief The number of the rule.
+     */
+    size_t rule_;
+    /**
+     * @brief The position of the recursive occurrence in the production.
+     */
+    size_t pos_;
+    /**
+     * @brief The position of the occurrence: LEFT if it starts the
+     * production, RIGHT if the rest of the production is nullable, NESTED
+     * otherwise.
+     */
+    RecursionKind kind_;
+    /**
+     * @brief The number of stack entries left behind by every repetition,
+     * i.e. the number of symbols preceding the occurrence.
+     */
+    size_t entries_per_element_;
+};
+
+/**
+ * @struct RecursionInfo
+ * @brief Describes a recursive non-terminal.
+ */
+struct RecursionInfo {
+    /**
+     * @brief The non-terminal.
+     */
+    NonTerminal nt_;
+    /**
+     * @brief The worst kind among the derivations of the non-terminal from
+     * itself, which may go through other non-terminals.
+     */
+    RecursionKind kind_;
+    /**
+     * @brief The recursive occurrences in its rules.
+     */
+    std::vector<GrowthSite> sites_;
+};
+
+/**
+ * @struct StackCycle
+ * @brief Describes a strongly connected component of the automaton, i.e. a
+ * set of states the parser can go through again and again without popping
+ * the stack.
+ */
+struct StackCycle {
+    /**
+     * @brief The states of the component.
+     */
+    std::vector<size_t> states_;
+    /**
+     * @brief The tokens labelling the transitions inside the component.
+     */
+    std::set<Token> tokens_;
+    /**
+     * @brief The length of the shortest cycle of the component, which is the
+     * least number of entries pushed per repetition.
+     */
+    size_t min_growth_;
+};
+
+/**
+ * @class StackAnalyzer
+ * @brief A class for the static analysis of the parser stack depth.
+ * @details Every transition of the automaton pushes one entry on the state and
+ * node stacks of the generated LR parser, so the stack depth is bounded iff
+ * the transition graph is acyclic, in which case the bound is the length of
+ * the longest path. Otherwise the cycles of the graph are reported along with
+ * the recursive non-terminals of the grammar that cause them.
+ */
+class StackAnalyzer {
+public:
+    /**
+     * @brief Constructs a StackAnalyzer object and runs the analysis.
+     * @param g The grammar.
+     * @param ga The GrammarAnalyzer that provides pregenerated sets for the
+     * grammar.
+     * @param transitions The transitions of the automaton built for the
+     * grammar.
+     */
+    StackAnalyzer(
+        const Grammar &g, const GrammarAnalyzer &ga,
+        const Automaton::Transitions &transitions
+    );
+
+    /**
+     * @brief Returns the recursive non-terminals of the grammar.
+     */
+    const std::vector<RecursionInfo> &GetRecursion() const;
+    /**
+     * @brief Returns the cycles of the automaton.
+     */
+    const std::vector<StackCycle> &GetCycles() const;
+    /**
+     * @brief Returns the maximum stack depth.
+     * @return `std::nullopt` if the stack can grow with the input, the maximum
+     * number of entries otherwise.
+     */
+    std::optional<size_t> GetMaxDepth() const;
+
+    /**
+     * @brief Formats the results of the analysis in a human-readable way.
+     */
+    std::string Describe() const;
+
+private:
+    /**
+     * @brief Classifies the recursive non-terminals of the grammar.
+     */
+    void AnalyzeGrammar();
+    /**
+     * @brief Finds the cycles of the automaton or the longest path if there
+     * are none.
+     */
+    void AnalyzeAutomaton();
+
+    const Grammar &g_;
+    const GrammarAnalyzer &ga_;
+    const Automaton::Transitions &transitions_;
+
+    std::vector<RecursionInfo> recursion_;
+    std::vector<StackCycle> cycles_;
+    std::optional<size_t> max_depth_;
+};
@@ -7,6 +7,7 @@
 #pragma once
 
 #include "Automaton.h"
+#include "DenseTables.h"
 #include "Entities.h"
 #include "GrammarAnalyzer.h"
 
@@ -44,8 +45,33 @@ public:
      * @param g The grammar to generate tables for.
      * @param ga The GrammarAnalyzer that provides pregenerated sets for the
      * grammar.
+     * @param limits The limits for building the automaton.
+     * @throws AutomatonBudgetError if the automaton exceeds the limits.
      */
-    ParserTables(const Grammar &g, const GrammarAnalyzer &ga);
+    ParserTables(
+        const Grammar &g, const GrammarAnalyzer &ga,
+        const AutomatonLimits &limits = {}
+    );
+
+    /**
+     * @brief Constructs a ParserTables object, reusing the automaton built for
+     * a previous version of the grammar.
+     * @param g The grammar to generate tables for.
+     * @param ga The GrammarAnalyzer constructed incrementally from the previous
+     * version of the grammar.
+     * @param prev_states The states of the previous automaton.
+     * @param prev_transitions The transitions of the previous automaton.
+     * @param limits The limits for building the automaton.
+     * @throws AutomatonBudgetError if the automaton exceeds the limits.
+     * @see Automaton::Automaton(const Grammar &, const GrammarAnalyzer &, const
+     * Automaton::StateMap &, const Automaton::Transitions &)
+     */
+    ParserTables(
+        const Grammar &g, const GrammarAnalyzer &ga,
+        const Automaton::StateMap &prev_states,
+        const Automaton::Transitions &prev_transitions,
+        const AutomatonLimits &limits = {}
+    );
 
     /**
      * @brief Generates both parser tables.
@@ -53,13 +79,41 @@ public:
     void Generate();
 
     /**
-     * @brief Returns the action table.
+     * @brief Returns the dense parser tables.
+     */
+    const DenseTables &GetTables() const;
+    /**
+     * @brief Moves the dense parser tables out of the object.
+     */
+    DenseTables TakeTables();
+
+    /**
+     * @brief Returns the action table as a map keyed by qualified names.
+     * @details The map is built from the dense table on every call.
      */
     ActionTable GetActionTable() const;
     /**
-     * @brief Returns the goto table.
+     * @brief Returns the goto table as a map keyed by non-terminals.
+     * @details The map is built from the dense table on every call.
      */
     GotoTable GetGotoTable() const;
+    /**
+     * @brief Returns the states of the automaton the tables were built from.
+     */
+    const Automaton::StateMap &GetStates() const;
+    /**
+     * @brief Returns the transitions of the automaton the tables were built
+     * from.
+     */
+    const Automaton::Transitions &GetTransitions() const;
+    /**
+     * @brief Returns the number of states reused from the previous automaton.
+     */
+    size_t GetReusedStates() const;
+    /**
+     * @brief Returns the automaton the tables were built from.
+     */
+    const Automaton &GetAutomaton() const;
 
 private:
     /**
@@ -75,9 +129,7 @@ private:
     void BuildGotoTable();
 
     Automaton automaton_;
-    Automaton::StateMap states_;
     const Grammar &g_;
 
-    ActionTable action_;
-    GotoTable goto_;
+    DenseTables tables_;
 };
\ No newline at end of file
@@ -0,0 +1,237 @@
+/**
+ * @file TableBundle.h
+ * @brief Provides a relocatable binary format for the LR(1) tables, which lets
+ * a parser load the tables of a grammar at run time instead of compiling them
+ * in.
+ * @author Vadim Melnikov
+ * @version 1.0
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "DenseTables.h"
+#include "Entities.h"
+
+/**
+ * @class TableBundleError
+ * @brief An exception class for reporting errors while writing or reading a
+ * table bundle.
+ */
+class TableBundleError : public std::exception {
+public:
+    /**
+     * @brief Constructs a TableBundleError object with the specified error.
+     * @param msg The error message.
+     */
+    explicit TableBundleError(const std::string &msg);
+
+    /**
+     * @brief Returns the error message.
+     * @return The error message.
+     */
+    const char *what() const noexcept override;
+
+private:
+    std::string msg_;
+};
+
+/**
+ * @enum BundleSection
+ * @brief The sections of a table bundle in the order of the section table.
+ * @details Every section but `STRINGS` is an array of 32-bit words. Entries
+ * of several words are stored one after another.
+ */
+enum class BundleSection : uint32_t {
+    /**
+     * @brief The names of the symbols, not terminated.
+     */
+    STRINGS,
+    /**
+     * @brief The qualified name of every terminal id as its offset and length
+     * in `STRINGS`.
+     */
+    TERMINALS,
+    /**
+     * @brief The terminal ids sorted by their qualified names.
+     */
+    TERMINAL_ORDER,
+    /**
+     * @brief The name of every non-terminal id as its offset and length in
+     * `STRINGS`.
+     */
+    NONTERMINALS,
+    /**
+     * @brief The left-hand side non-terminal id, the index of the first
+     * symbol in `SYMBOLS` and the number of symbols of every rule. Epsilon
+     * rules have no symbols.
+     */
+    RULES,
+    /**
+     * @brief The symbols of the rules, a terminal id `t` is stored as `2t`, a
+     * non-terminal id `nt` as `2nt + 1`.
+     */
+    SYMBOLS,
+    /**
+     * @brief The row offsets of the comb vector, see CombTables.
+     */
+    BASE,
+    /**
+     * @brief The encoded actions and goto targets of the comb vector.
+     */
+    NEXT,
+    /**
+     * @brief The owners of the slots of the comb vector.
+     */
+    CHECK,
+    /**
+     * @brief The encoded default action of every state.
+     */
+    DEFAULTS,
+    /**
+     * @brief 1 for the states that take their default action without reading
+     * the lookahead, 0 for the rest.
+     */
+    DEFAULT_ONLY,
+    /**
+     * @brief The column of the action table of every terminal id.
+     */
+    TERMINAL_CLASSES,
+    /**
+     * @brief The index of the first terminal in `FOLLOW` of every
+     * non-terminal id, followed by the size of `FOLLOW`.
+     */
+    FOLLOW_INDEX,
+    /**
+     * @brief The terminal ids of the FOLLOW sets.
+     */
+    FOLLOW,
+    /**
+     * @brief The key `state * nonterminals + nonterminal`, the index of the
+     * first non-terminal in `UNIT_SYMBOLS` and the length of every chain of
+     * bypassed unit reductions, sorted by the key. See
+     * `DenseTables::unit_chains_`.
+     */
+    UNIT_CHAINS,
+    /**
+     * @brief The non-terminal ids of the chains.
+     */
+    UNIT_SYMBOLS,
+    /**
+     * @brief The number of sections.
+     */
+    COUNT
+};
+
+/**
+ * @class TableBundle
+ * @brief Writes the grammar, the LR(1) tables and the FOLLOW sets into a
+ * single binary image that is used as is once mapped into memory.
+ * @details The image starts with a header of 32-bit words: the magic `PGTB`,
+ * the format version, the byte order mark `0x01020304` as written by the
+ * host, the size of the image in bytes, the number of columns of the action
+ * table and the number of sections. The section table follows, holding the
+ * offset from the start of the image and the length (in bytes for `STRINGS`,
+ * in words for the rest) of every section. Sections start at multiples of 4
+ * and only refer to each other by indices, so the image can be mapped at any
+ * address. The tables are stored packed by CombTables.
+ */
+class TableBundle {
+public:
+    /**
+     * @brief The format version, bumped on every incompatible change.
+     */
+    static constexpr uint32_t kVersion = 1;
+    /**
+     * @brief The byte order mark, reads differently on a host of the other
+     * byte order.
+     */
+    static constexpr uint32_t kByteOrderMark = 0x01020304;
+    /**
+     * @brief The number of words of the header before the section table.
+     */
+    static constexpr size_t kHeaderWords = 6;
+
+    /**
+     * @brief Builds the image.
+     * @param g The grammar the tables were built for.
+     * @param tables The tables.
+     * @param fs The FOLLOW sets used for the error recovery.
+     */
+    TableBundle(
+        const Grammar &g, const DenseTables &tables, const FollowSets &fs
+    );
+
+    /**
+     * @brief Returns the image.
+     */
+    const std::vector<uint8_t> &GetBytes() const;
+    /**
+     * @brief Writes the image to a file.
+     * @param path The path to the file.
+     * @throws TableBundleError if the file can't be written.
+     */
+    void Write(const std::string &path) const;
+
+private:
+    std::vector<uint8_t> bytes_;
+};
+
+/**
+ * @class TableBundleView
+ * @brief Reads the tables from an image built by TableBundle in place.
+ * @details Only the header is checked on construction, the lookups read the
+ * sections directly. The view doesn't own the image.
+ */
+class TableBundleView {
+public:
+    /**
+     * @brief Constructs a view of the image.
+     * @param bytes The image, aligned to 4 bytes.
+     * @throws TableBundleError if the image is not a table bundle of this
+     * version and byte order or is truncated.
+     */
+    explicit TableBundleView(std::span<const uint8_t> bytes);
+
+    /**
+     * @brief Returns the number of columns of the action table.
+     */
+    size_t GetColumns() const;
+    /**
+     * @brief Returns the words of a section.
+     * @details The `STRINGS` section is returned rounded down to whole words,
+     * use GetString() to read it.
+     */
+    std::span<const uint32_t> GetSection(BundleSection section) const;
+    /**
+     * @brief Returns a string stored in the `STRINGS` section.
+     */
+    std::string_view GetString(uint32_t offset, uint32_t length) const;
+    /**
+     * @brief Looks up the id of the terminal with the qualified name.
+     * @return `std::nullopt` if there is no such terminal, the id otherwise.
+     */
+    std::optional<size_t> FindTerminal(std::string_view name) const;
+    /**
+     * @brief Returns the action taken by the state on the column of the
+     * action table.
+     */
+    Action GetAction(size_t state, size_t column) const;
+    /**
+     * @brief Returns the state to go to from the state on the non-terminal id.
+     * @return `std::nullopt` if there is no transition, the state otherwise.
+     */
+    std::optional<size_t> GetGoto(size_t state, size_t nonterminal) const;
+
+private:
+    uint32_t Word(size_t i) const;
+
+    std::span<const uint8_t> bytes_;
+    size_t columns_ = 0;
+};
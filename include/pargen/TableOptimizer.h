@@ -0,0 +1,299 @@
+/**
+ * @file TableOptimizer.h
+ * @brief Provides a class for optimizing built parser tables before the code
+ * is generated from them.
+ * @author Vadim Melnikov
+ * @version 1.0
+ */
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "DenseTables.h"
+#include "Entities.h"
+#include "LayoutProfile.h"
+
+/**
+ * @enum DefaultReductions
+ * @brief Selects the states that get a default reduction.
+ */
+enum class DefaultReductions {
+    /**
+     * @brief No state gets a default reduction.
+     */
+    NONE,
+    /**
+     * @brief Only the states whose only action is a single reduction (the
+     * consistent states) get one. These states don't have to read the
+     * lookahead at all.
+     */
+    CONSISTENT,
+    /**
+     * @brief Every state that reduces gets its most frequent reduction as the
+     * default one, its cells are removed from the row.
+     */
+    ALL
+};
+
+/**
+ * @enum UnitRules
+ * @brief Selects what happens to the reductions by unit rules like
+ * `<T> = <F>`.
+ */
+enum class UnitRules {
+    /**
+     * @brief The reductions are kept.
+     */
+    KEEP,
+    /**
+     * @brief The reductions are bypassed, the generated parser restores the
+     * skipped nodes of the tree from a table.
+     */
+    SYNTHESIZE,
+    /**
+     * @brief The reductions are bypassed and their nodes are left out of the
+     * tree.
+     */
+    DROP
+};
+
+/**
+ * @struct DefaultReductionStats
+ * @brief Describes the result of adding the default reductions.
+ */
+struct DefaultReductionStats {
+    /**
+     * @brief The number of states that got a default reduction.
+     */
+    size_t states_ = 0;
+    /**
+     * @brief The number of states that reduce without reading the lookahead.
+     */
+    size_t default_only_ = 0;
+    /**
+     * @brief The number of cells removed from the action table.
+     */
+    size_t removed_ = 0;
+};
+
+/**
+ * @struct MinimizationStats
+ * @brief Describes the result of merging the equivalent states.
+ */
+struct MinimizationStats {
+    /**
+     * @brief The number of states before the merge.
+     */
+    size_t before_ = 0;
+    /**
+     * @brief The number of states after the merge.
+     */
+    size_t after_ = 0;
+};
+
+/**
+ * @struct TerminalClassStats
+ * @brief Describes the result of merging the equal columns of the action
+ * table.
+ */
+struct TerminalClassStats {
+    /**
+     * @brief The number of terminals.
+     */
+    size_t terminals_ = 0;
+    /**
+     * @brief The number of columns before the merge.
+     */
+    size_t before_ = 0;
+    /**
+     * @brief The number of columns after the merge.
+     */
+    size_t after_ = 0;
+};
+
+/**
+ * @struct ShiftReduceStats
+ * @brief Describes the result of fusing the shifts with the reductions that
+ * follow them.
+ */
+struct ShiftReduceStats {
+    /**
+     * @brief The number of shifts replaced with fused actions.
+     */
+    size_t fused_ = 0;
+    /**
+     * @brief The number of states that were only reached by the fused shifts
+     * and were removed.
+     */
+    size_t removed_states_ = 0;
+};
+
+/**
+ * @struct UnitRuleStats
+ * @brief Describes the result of bypassing the unit reductions.
+ */
+struct UnitRuleStats {
+    /**
+     * @brief The number of goto transitions redirected past unit reductions.
+     */
+    size_t bypassed_ = 0;
+    /**
+     * @brief The number of states that were only reached by the redirected
+     * transitions and were removed.
+     */
+    size_t removed_states_ = 0;
+};
+
+/**
+ * @struct ProfileLayoutStats
+ * @brief Describes the layout of the tables after applying a profile.
+ */
+struct ProfileLayoutStats {
+    /**
+     * @brief The number of states.
+     */
+    size_t states_ = 0;
+    /**
+     * @brief The number of the most visited states that take 90% of the
+     * visits.
+     */
+    size_t hot_states_ = 0;
+    /**
+     * @brief The number of columns of the action table.
+     */
+    size_t columns_ = 0;
+    /**
+     * @brief The number of the most shifted columns that take 90% of the
+     * shifts.
+     */
+    size_t hot_columns_ = 0;
+};
+
+/**
+ * @class TableOptimizer
+ * @brief Applies optimizations to the dense tables in place.
+ * @details The optimizations don't change the language accepted by the
+ * parser, but may change the point an error is detected at: a default
+ * reduction is also taken on a terminal the state has no action for, so the
+ * error is found after the reductions, which affects the recovery. The
+ * optimizations are applied after the tables are cached, so cached tables are
+ * always the plain ones.
+ */
+class TableOptimizer {
+public:
+    /**
+     * @brief Constructs a TableOptimizer object for the tables.
+     * @param g The grammar the tables were built for.
+     * @param tables The tables to optimize.
+     */
+    TableOptimizer(const Grammar &g, DenseTables &tables);
+
+    /**
+     * @brief Makes every reduction use the first rule with the same left-hand
+     * side and the same length.
+     * @details The generated parser only uses the left-hand side and the
+     * length of the rule it reduces by, and the children of the new node are
+     * the nodes on the stack, so such rules build the same trees. Rules like
+     * `<Op> = '+' | '-'` then lead to states that can be merged, which in turn
+     * makes the columns of their terminals equal.
+     * @return The number of cells changed.
+     */
+    size_t ShareReductions();
+    /**
+     * @brief Adds default reductions to the states selected by the mode.
+     * @param mode The states to add default reductions to.
+     * @return What was changed.
+     */
+    DefaultReductionStats AddDefaultReductions(DefaultReductions mode);
+    /**
+     * @brief Merges the states that behave the same way and renumbers the
+     * tables.
+     * @details Two states are equivalent if their action and goto rows and
+     * their default actions are equal once the targets of the transitions are
+     * replaced with the classes of the target states. The classes are found
+     * by partition refinement, starting from a single class. The initial
+     * state stays state 0, the other classes are numbered in the order of
+     * their first states.
+     * @return The number of states before and after the merge.
+     */
+    MinimizationStats MinimizeStates();
+    /**
+     * @brief Merges the terminals whose columns of the action table are equal
+     * in every state into classes with a single column each.
+     * @details Every terminal leads to states of its own, so the columns only
+     * become equal after ShareReductions() and MinimizeStates(). The columns
+     * of the classes are numbered in the order of their first terminals, the
+     * class of every terminal is stored in `DenseTables::terminal_classes_`.
+     * @return The number of terminals and of columns before and after the
+     * merge.
+     */
+    TerminalClassStats MergeTerminals();
+    /**
+     * @brief Replaces the shifts into the states that only reduce by a default
+     * reduction with SHIFT_REDUCE actions and removes the states no longer
+     * reached.
+     * @details Such a state is pushed onto the stack only to be popped by the
+     * reduction right away, so the generated parser reduces in the same step
+     * instead. Reductions by epsilon rules aren't fused, since their gotos
+     * are taken from the state being skipped. Only makes a difference after
+     * AddDefaultReductions(). The remaining states keep their order.
+     * @return The number of fused shifts and removed states.
+     */
+    ShiftReduceStats FuseShiftReduce();
+    /**
+     * @brief Redirects the goto transitions into the states that only reduce
+     * by a unit rule `<A> = <B>` to the target of the transition on `<A>`.
+     * @details Such a state is entered right after a reduction to `<B>` and
+     * only replaces `<B>` with `<A>`, so the parser can go straight to where
+     * the reduction to `<A>` would lead, following chains like
+     * `<E> = <T>`, `<T> = <F>` to their end. A state that also continues the
+     * rule, like the one with `<E> = <T> .` and `<T> = <T> . '*' <F>`, isn't
+     * bypassed. Only makes a difference after AddDefaultReductions(), and has
+     * to be applied after MinimizeStates(), which doesn't know about the
+     * bypassed reductions.
+     * @param mode Whether to bypass the reductions and what happens to the
+     * nodes of the tree they build; with `UnitRules::SYNTHESIZE` the skipped
+     * non-terminals are stored in `DenseTables::unit_chains_`.
+     * @return The number of redirected transitions and removed states.
+     */
+    UnitRuleStats EliminateUnitRules(UnitRules mode);
+    /**
+     * @brief Renumbers the states and the columns of the action table in the
+     * order of the number of times the profiled parser used them.
+     * @details The initial state stays state 0, the other states are sorted
+     * by their visits and the columns by the shifts of their terminals, the
+     * most used first, keeping the order of the ties. The rows and the
+     * columns the parser touches the most then lie next to each other, and
+     * CombTables packs them together when placing the rows in order. The
+     * terminal ids don't change, the columns are reached through
+     * `DenseTables::terminal_classes_`. Has to be the last optimization, the
+     * profile refers to the states of the final tables.
+     * @param profile The profile gathered by a parser generated from these
+     * very tables.
+     * @return How concentrated the use of the tables is.
+     * @throws LayoutProfileError if the profile was gathered with other
+     * tables.
+     */
+    ProfileLayoutStats ApplyProfile(const LayoutProfile &profile);
+
+private:
+    /**
+     * @brief Removes the states not reached from the initial state and
+     * renumbers the rest keeping their order.
+     * @return The number of removed states.
+     */
+    size_t RemoveUnreachableStates();
+    /**
+     * @brief Rebuilds the tables from the rows of the given states.
+     * @param states The state that becomes every new state.
+     * @param number The new number of every old state, used for the targets
+     * of the transitions.
+     */
+    void RenumberStates(
+        const std::vector<size_t> &states, const std::vector<size_t> &number
+    );
+
+    const Grammar &g_;
+    DenseTables &tables_;
+};
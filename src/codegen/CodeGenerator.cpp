@@ -15,8 +15,11 @@ const char *CodeGeneratorError::what() const noexcept {
 }
 
 CodeGenerator::CodeGenerator(
-    const std::string &folder, ActionTable &at, GotoTable &gt, FollowSets &fs,
-    const Grammar &g, bool add_json_generator, size_t json_indents
+    const std::string &folder, const DenseTables &tables, FollowSets &fs,
+    const Grammar &g, bool add_json_generator, size_t json_indents,
+    const CombTables *comb, bool bundle, bool profile,
+    std::vector<Expression> expressions, ScannerKind scanner,
+    KeywordMode keywords
 )
     : folder_(
           folder.starts_with('/')
@@ -25,12 +28,43 @@ CodeGenerator::CodeGenerator(
                 )
               : folder
       ),
-      at_(at),
-      gt_(gt),
+      g_(g),
+      tables_(&tables),
+      comb_(comb),
       fs_(fs),
+      add_json_generator_(add_json_generator),
+      json_indents_(json_indents),
+      bundle_(bundle),
+      profile_(profile),
+      expressions_(std::move(expressions)),
+      scanner_(scanner),
+      keywords_(keywords) {
+    CreateFolder();
+}
+
+CodeGenerator::CodeGenerator(
+    const std::string &folder, const PredictTable &pt, FollowSets &fs,
+    const Grammar &g, bool add_json_generator, size_t json_indents,
+    ScannerKind scanner, KeywordMode keywords
+)
+    : folder_(
+          folder.starts_with('/')
+              ? throw CodeGeneratorError(
+                    "Preceding slashes are not allowed for folder name"
+                )
+              : folder
+      ),
       g_(g),
+      pt_(&pt),
+      fs_(fs),
       add_json_generator_(add_json_generator),
-      json_indents_(json_indents) {
+      json_indents_(json_indents),
+      scanner_(scanner),
+      keywords_(keywords) {
+    CreateFolder();
+}
+
+void CodeGenerator::CreateFolder() {
     bool created = std::filesystem::create_directories(folder_);
     if (!created) {
         throw CodeGeneratorError("Could not create directory " + folder_);
@@ -39,17 +73,25 @@ CodeGenerator::CodeGenerator(
 
 void CodeGenerator::Generate() {
     try {
-        LexerGenerator lexer_generator(folder_, g_);
+        LexerGenerator lexer_generator(folder_, g_, scanner_, keywords_);
         lexer_generator.Generate();
     } catch (const LexerGeneratorError &e) {
         std::rethrow_exception(std::current_exception());
     }
 
     try {
-        ParserGenerator parser_generator(
-            folder_, g_, at_, gt_, fs_, add_json_generator_, json_indents_
-        );
-        parser_generator.Generate();
+        if (pt_ != nullptr) {
+            ParserGenerator parser_generator(
+                folder_, g_, *pt_, fs_, add_json_generator_, json_indents_
+            );
+            parser_generator.Generate();
+        } else {
+            ParserGenerator parser_generator(
+                folder_, g_, *tables_, fs_, add_json_generator_, json_indents_,
+                comb_, bundle_, profile_, expressions_
+            );
+            parser_generator.Generate();
+        }
     } catch (const ParserGeneratorError &e) {
         std::rethrow_exception(std::current_exception());
     }
@@ -0,0 +1,19 @@
+#include "CodegenHelpers.h"
+
+std::string UnsignedType(size_t width) {
+    return "std::uint" + std::to_string(width * 8) + "_t";
+}
+
+void GenerateArray(
+    std::ostream &out, const std::vector<uint32_t> &values, size_t indent
+) {
+    for (size_t i = 0; i < values.size(); ++i) {
+        out << (i % 16 == 0 ? std::string(indent, ' ') : " ") << values[i];
+        if (i != values.size() - 1) {
+            out << ",";
+        }
+        if (i % 16 == 15 || i == values.size() - 1) {
+            out << "\n";
+        }
+    }
+}
@@ -0,0 +1,100 @@
+#include "KeywordHash.h"
+
+#include <algorithm>
+#include <numeric>
+
+namespace {
+/**
+ * @brief The most seeds tried for a bucket before the slots are doubled.
+ */
+const uint32_t kMaxSeed = 1 << 16;
+}  // namespace
+
+KeywordHash::KeywordHash(const std::vector<std::string> &keywords)
+    : keywords_(keywords) {
+    // a load factor of at most 0.8 keeps the search for the last buckets
+    // short
+    size_t slot_count = 1;
+    while (slot_count * 4 < keywords_.size() * 5) {
+        slot_count *= 2;
+    }
+    while (!Place(slot_count)) {
+        slot_count *= 2;
+    }
+}
+
+uint64_t KeywordHash::Hash(std::string_view s, uint64_t seed) {
+    uint64_t h = 0xcbf29ce484222325ull ^ (seed * 0x9e3779b97f4a7c15ull);
+    for (char c : s) {
+        h ^= static_cast<unsigned char>(c);
+        h *= 0x100000001b3ull;
+    }
+    h ^= h >> 29;
+    h *= 0xbf58476d1ce4e5b9ull;
+    h ^= h >> 32;
+    return h;
+}
+
+const std::vector<uint32_t> &KeywordHash::GetSeeds() const {
+    return seeds_;
+}
+
+const std::vector<uint32_t> &KeywordHash::GetSlots() const {
+    return slots_;
+}
+
+std::optional<size_t> KeywordHash::Find(std::string_view s) const {
+    uint64_t seed = seeds_[Hash(s, 0) % seeds_.size()];
+    uint32_t slot = slots_[Hash(s, seed) & (slots_.size() - 1)];
+    if (slot == 0 || keywords_[slot - 1] != s) {
+        return std::nullopt;
+    }
+    return slot - 1;
+}
+
+bool KeywordHash::Place(size_t slot_count) {
+    size_t bucket_count = std::max<size_t>(1, keywords_.size() / 2);
+    std::vector<std::vector<size_t>> buckets(bucket_count);
+    for (size_t k = 0; k < keywords_.size(); ++k) {
+        buckets[Hash(keywords_[k], 0) % bucket_count].push_back(k);
+    }
+    std::vector<size_t> order(bucket_count);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        return buckets[a].size() > buckets[b].size();
+    });
+
+    seeds_.assign(bucket_count, 0);
+    slots_.assign(slot_count, 0);
+    std::vector<size_t> taken;
+    for (size_t b : order) {
+        if (buckets[b].empty()) {
+            break;
+        }
+        bool placed = false;
+        for (uint32_t seed = 1; seed < kMaxSeed && !placed; ++seed) {
+            taken.clear();
+            placed = true;
+            for (size_t k : buckets[b]) {
+                size_t slot = Hash(keywords_[k], seed) & (slot_count - 1);
+                if (slots_[slot] != 0 ||
+                    std::find(taken.begin(), taken.end(), slot) !=
+                        taken.end()) {
+                    placed = false;
+                    break;
+                }
+                taken.push_back(slot);
+            }
+            if (placed) {
+                seeds_[b] = seed;
+                for (size_t i = 0; i < taken.size(); ++i) {
+                    slots_[taken[i]] = static_cast<uint32_t>(buckets[b][i] + 1);
+                }
+            }
+        }
+        if (!placed) {
+            return false;
+        }
+    }
+    return true;
+}
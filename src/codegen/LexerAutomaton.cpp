@@ -0,0 +1,1008 @@
+#include "LexerAutomaton.h"
+
+#include <algorithm>
+#include <bitset>
+#include <cctype>
+#include <map>
+#include <tuple>
+
+namespace {
+using ByteSet = std::bitset<256>;
+
+/**
+ * @brief The largest bound of a `{n,m}` repetition.
+ */
+const size_t kMaxRepeat = 1000;
+
+/**
+ * @brief A node of the syntax tree of a pattern. A concatenation without
+ * children matches the empty string, `*`, `+` and `?` are repetitions.
+ */
+struct RegexNode {
+    enum class Kind { SET, CONCAT, ALT, REPEAT };
+
+    Kind kind = Kind::SET;
+    ByteSet set;
+    std::vector<RegexNode> children;
+    size_t min = 0;
+    std::optional<size_t> max;
+};
+
+RegexNode MakeSet(const ByteSet &set) {
+    RegexNode node;
+    node.set = set;
+    return node;
+}
+
+RegexNode MakeByte(unsigned char c) {
+    ByteSet set;
+    set.set(c);
+    return MakeSet(set);
+}
+
+RegexNode MakeString(std::string_view bytes) {
+    if (bytes.size() == 1) {
+        return MakeByte(bytes[0]);
+    }
+    RegexNode concat;
+    concat.kind = RegexNode::Kind::CONCAT;
+    for (char c : bytes) {
+        concat.children.push_back(MakeByte(c));
+    }
+    return concat;
+}
+
+/**
+ * @brief Ranges of code points, the bounds included.
+ */
+using CodePoints = std::vector<std::pair<uint32_t, uint32_t>>;
+
+/**
+ * @brief The largest code point.
+ */
+const uint32_t kMaxCodePoint = 0x10FFFF;
+
+/**
+ * @brief Returns the UTF-8 encoding of the code point.
+ */
+std::string EncodeUtf8(uint32_t cp) {
+    std::string bytes;
+    if (cp < 0x80) {
+        bytes += static_cast<char>(cp);
+    } else if (cp < 0x800) {
+        bytes += static_cast<char>(0xC0 | (cp >> 6));
+        bytes += static_cast<char>(0x80 | (cp & 0x3F));
+    } else if (cp < 0x10000) {
+        bytes += static_cast<char>(0xE0 | (cp >> 12));
+        bytes += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        bytes += static_cast<char>(0x80 | (cp & 0x3F));
+    } else {
+        bytes += static_cast<char>(0xF0 | (cp >> 18));
+        bytes += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+        bytes += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        bytes += static_cast<char>(0x80 | (cp & 0x3F));
+    }
+    return bytes;
+}
+
+/**
+ * @brief Decodes the UTF-8 sequence at the start of the text.
+ * @return The code point and the length of the sequence, `std::nullopt` if
+ * the text doesn't start with a valid multibyte sequence.
+ */
+std::optional<std::pair<uint32_t, size_t>> DecodeUtf8(std::string_view text) {
+    unsigned char lead = static_cast<unsigned char>(text[0]);
+    size_t length = lead >= 0xF0 ? 4 : lead >= 0xE0 ? 3 : lead >= 0xC0 ? 2 : 0;
+    if (length == 0 || lead > 0xF4 || text.size() < length) {
+        return std::nullopt;
+    }
+    uint32_t cp = lead & (0x7F >> length);
+    for (size_t i = 1; i < length; ++i) {
+        unsigned char c = static_cast<unsigned char>(text[i]);
+        if ((c & 0xC0) != 0x80) {
+            return std::nullopt;
+        }
+        cp = (cp << 6) | (c & 0x3F);
+    }
+    // overlong encodings, surrogates and code points past the last one
+    static const uint32_t kMin[] = {0, 0, 0x80, 0x800, 0x10000};
+    if (cp < kMin[length] || (cp >= 0xD800 && cp <= 0xDFFF) ||
+        cp > kMaxCodePoint) {
+        return std::nullopt;
+    }
+    return std::make_pair(cp, length);
+}
+
+/**
+ * @brief Splits the range of code points into ranges whose encodings are the
+ * same number of bytes and differ in the last bytes only, so every range is a
+ * sequence of byte ranges.
+ */
+void SplitUtf8(
+    uint32_t lo, uint32_t hi,
+    std::vector<std::vector<std::pair<unsigned char, unsigned char>>> &out
+) {
+    static const uint32_t kLast[] = {0x7F, 0x7FF, 0xFFFF};
+    for (uint32_t last : kLast) {
+        if (lo <= last && hi > last) {
+            SplitUtf8(lo, last, out);
+            SplitUtf8(last + 1, hi, out);
+            return;
+        }
+    }
+    for (uint32_t i = 1; i < 4; ++i) {
+        uint32_t m = (1u << (6 * i)) - 1;
+        if ((lo & ~m) != (hi & ~m)) {
+            if ((lo & m) != 0) {
+                SplitUtf8(lo, lo | m, out);
+                SplitUtf8((lo | m) + 1, hi, out);
+                return;
+            }
+            if ((hi & m) != m) {
+                SplitUtf8(lo, (hi & ~m) - 1, out);
+                SplitUtf8(hi & ~m, hi, out);
+                return;
+            }
+        }
+    }
+    std::string first = EncodeUtf8(lo);
+    std::string last = EncodeUtf8(hi);
+    std::vector<std::pair<unsigned char, unsigned char>> sequence;
+    for (size_t i = 0; i < first.size(); ++i) {
+        sequence.emplace_back(first[i], last[i]);
+    }
+    out.push_back(std::move(sequence));
+}
+
+/**
+ * @brief Returns the node matching the UTF-8 encodings of the code points, an
+ * alternative per sequence of byte ranges. The DFA minimization merges their
+ * common suffixes.
+ */
+RegexNode MakeCodePoints(const CodePoints &ranges) {
+    std::vector<std::vector<std::pair<unsigned char, unsigned char>>> sequences;
+    for (auto [lo, hi] : ranges) {
+        SplitUtf8(lo, hi, sequences);
+    }
+    RegexNode alt;
+    alt.kind = RegexNode::Kind::ALT;
+    ByteSet ascii;
+    for (const auto &sequence : sequences) {
+        if (sequence.size() == 1) {
+            for (unsigned b = sequence[0].first; b <= sequence[0].second; ++b) {
+                ascii.set(b);
+            }
+            continue;
+        }
+        RegexNode concat;
+        concat.kind = RegexNode::Kind::CONCAT;
+        for (auto [lo, hi] : sequence) {
+            ByteSet set;
+            for (unsigned b = lo; b <= hi; ++b) {
+                set.set(b);
+            }
+            concat.children.push_back(MakeSet(set));
+        }
+        alt.children.push_back(std::move(concat));
+    }
+    if (ascii.any() || alt.children.empty()) {
+        alt.children.insert(alt.children.begin(), MakeSet(ascii));
+    }
+    if (alt.children.size() == 1) {
+        return std::move(alt.children[0]);
+    }
+    return alt;
+}
+
+/**
+ * @brief A recursive descent parser of the flex-like pattern syntax.
+ */
+class RegexParser {
+public:
+    explicit RegexParser(std::string_view pattern) : pattern_(pattern) {
+    }
+
+    RegexNode Parse() {
+        RegexNode node = ParseAlternation();
+        if (pos_ < pattern_.size() && pattern_[pos_] == ')') {
+            Fail("unmatched `)`");
+        }
+        // flex ends the pattern at the first whitespace and reads the action
+        // after it
+        while (pos_ < pattern_.size()) {
+            if (!std::isspace(static_cast<unsigned char>(pattern_[pos_]))) {
+                Fail("whitespace inside the pattern, quote it or put it in a "
+                     "class");
+            }
+            ++pos_;
+        }
+        return node;
+    }
+
+private:
+    [[noreturn]] void Fail(const std::string &msg) const {
+        throw RegexError(
+            "Can't compile `" + std::string(pattern_) + "`: " + msg +
+            " at position " + std::to_string(pos_)
+        );
+    }
+
+    bool AtEnd() const {
+        return pos_ == pattern_.size() ||
+               std::isspace(static_cast<unsigned char>(pattern_[pos_]));
+    }
+
+    char Peek() const {
+        return pattern_[pos_];
+    }
+
+    bool PeekDigit() const {
+        return pos_ < pattern_.size() &&
+               std::isdigit(static_cast<unsigned char>(Peek()));
+    }
+
+    RegexNode ParseAlternation() {
+        RegexNode first = ParseConcatenation();
+        if (AtEnd() || Peek() != '|') {
+            return first;
+        }
+        RegexNode alt;
+        alt.kind = RegexNode::Kind::ALT;
+        alt.children.push_back(std::move(first));
+        while (!AtEnd() && Peek() == '|') {
+            ++pos_;
+            alt.children.push_back(ParseConcatenation());
+        }
+        return alt;
+    }
+
+    RegexNode ParseConcatenation() {
+        RegexNode concat;
+        concat.kind = RegexNode::Kind::CONCAT;
+        while (!AtEnd() && Peek() != '|' && Peek() != ')') {
+            concat.children.push_back(ParseRepetition());
+        }
+        if (concat.children.size() == 1) {
+            return std::move(concat.children[0]);
+        }
+        return concat;
+    }
+
+    RegexNode ParseRepetition() {
+        RegexNode node = ParseAtom();
+        while (!AtEnd()) {
+            size_t min = 0;
+            std::optional<size_t> max;
+            if (Peek() == '*') {
+                ++pos_;
+            } else if (Peek() == '+') {
+                ++pos_;
+                min = 1;
+            } else if (Peek() == '?') {
+                ++pos_;
+                max = 1;
+            } else if (Peek() == '{') {
+                ++pos_;
+                ParseBounds(min, max);
+            } else {
+                break;
+            }
+            RegexNode repeat;
+            repeat.kind = RegexNode::Kind::REPEAT;
+            repeat.children.push_back(std::move(node));
+            repeat.min = min;
+            repeat.max = max;
+            node = std::move(repeat);
+        }
+        return node;
+    }
+
+    void ParseBounds(size_t &min, std::optional<size_t> &max) {
+        if (!PeekDigit()) {
+            Fail("definitions like `{name}` are not supported");
+        }
+        min = ParseNumber();
+        max = min;
+        if (pos_ < pattern_.size() && Peek() == ',') {
+            ++pos_;
+            max = std::nullopt;
+            if (PeekDigit()) {
+                max = ParseNumber();
+            }
+        }
+        if (pos_ == pattern_.size() || Peek() != '}') {
+            Fail("unterminated `{`");
+        }
+        ++pos_;
+        if (max.has_value() && max.value() < min) {
+            Fail("reversed repetition bounds");
+        }
+        if (min > kMaxRepeat || max.value_or(0) > kMaxRepeat) {
+            Fail(
+                "repetition bounds above " + std::to_string(kMaxRepeat) +
+                " are not supported"
+            );
+        }
+    }
+
+    size_t ParseNumber() {
+        size_t value = 0;
+        while (PeekDigit()) {
+            value = std::min(value * 10 + (Peek() - '0'), kMaxRepeat + 1);
+            ++pos_;
+        }
+        return value;
+    }
+
+    RegexNode ParseAtom() {
+        size_t start = pos_;
+        char c = pattern_[pos_++];
+        switch (c) {
+            case '(': {
+                RegexNode node = ParseAlternation();
+                if (AtEnd() || Peek() != ')') {
+                    Fail("unterminated `(`");
+                }
+                ++pos_;
+                return node;
+            }
+            case '[':
+                return ParseClass();
+            case '"':
+                return ParseString();
+            case '.': {
+                ByteSet set;
+                set.set();
+                set.reset('\n');
+                return MakeSet(set);
+            }
+            case '\\':
+                if (PeekCodePointEscape()) {
+                    return MakeString(EncodeUtf8(ParseCodePointEscape()));
+                }
+                return MakeByte(ParseEscape());
+            case '^':
+            case '$':
+                pos_ = start;
+                Fail("anchors are not supported");
+            case '/':
+                pos_ = start;
+                Fail("trailing context is not supported");
+            case '*':
+            case '+':
+            case '?':
+            case '{':
+                pos_ = start;
+                Fail(std::string("nothing to repeat before `") + c + "`");
+            case '<':
+                if (start == 0) {
+                    Fail("start conditions are not supported");
+                }
+                return MakeByte(c);
+            default: {
+                // a character is repeated as a whole, not its last byte
+                auto decoded = DecodeUtf8(pattern_.substr(start));
+                if (decoded.has_value()) {
+                    pos_ = start + decoded->second;
+                    return MakeString(pattern_.substr(start, decoded->second));
+                }
+                return MakeByte(c);
+            }
+        }
+    }
+
+    bool PeekCodePointEscape() const {
+        return pos_ < pattern_.size() && (Peek() == 'u' || Peek() == 'U');
+    }
+
+    /**
+     * @brief Parses `\u{1F600}`, `\u00e9` or `\U0001F600` after the
+     * backslash.
+     */
+    uint32_t ParseCodePointEscape() {
+        size_t digits = pattern_[pos_++] == 'U' ? 8 : 4;
+        bool braced = pos_ < pattern_.size() && Peek() == '{' && digits == 4;
+        if (braced) {
+            ++pos_;
+            digits = 6;
+        }
+        uint32_t cp = 0;
+        size_t read = 0;
+        while (read < digits && pos_ < pattern_.size() &&
+               std::isxdigit(static_cast<unsigned char>(Peek()))) {
+            char d = static_cast<char>(std::tolower(Peek()));
+            cp = cp * 16 + (std::isdigit(d) ? d - '0' : d - 'a' + 10);
+            ++pos_;
+            ++read;
+        }
+        if (braced) {
+            if (read == 0 || pos_ == pattern_.size() || Peek() != '}') {
+                Fail("`\\u{` without hex digits and `}`");
+            }
+            ++pos_;
+        } else if (read != digits) {
+            Fail("`\\u` and `\\U` take 4 and 8 hex digits");
+        }
+        if (cp > kMaxCodePoint || (cp >= 0xD800 && cp <= 0xDFFF)) {
+            Fail("escape of an invalid code point");
+        }
+        return cp;
+    }
+
+    unsigned char ParseEscape() {
+        if (pos_ == pattern_.size()) {
+            Fail("dangling `\\`");
+        }
+        char c = pattern_[pos_++];
+        switch (c) {
+            case 'n':
+                return '\n';
+            case 't':
+                return '\t';
+            case 'r':
+                return '\r';
+            case 'f':
+                return '\f';
+            case 'v':
+                return '\v';
+            case 'a':
+                return '\a';
+            case 'b':
+                return '\b';
+            case 'x': {
+                unsigned value = 0;
+                size_t digits = 0;
+                while (digits < 2 && pos_ < pattern_.size() &&
+                       std::isxdigit(static_cast<unsigned char>(Peek()))) {
+                    char d = static_cast<char>(std::tolower(Peek()));
+                    value = value * 16 +
+                            (std::isdigit(d) ? d - '0' : d - 'a' + 10);
+                    ++pos_;
+                    ++digits;
+                }
+                if (digits == 0) {
+                    Fail("`\\x` without hex digits");
+                }
+                return static_cast<unsigned char>(value);
+            }
+            default:
+                break;
+        }
+        if (c >= '0' && c <= '7') {
+            unsigned value = c - '0';
+            for (size_t digits = 1; digits < 3 && pos_ < pattern_.size() &&
+                                    Peek() >= '0' && Peek() <= '7';
+                 ++digits) {
+                value = value * 8 + (Peek() - '0');
+                ++pos_;
+            }
+            if (value > 255) {
+                Fail("octal escape above `\\377`");
+            }
+            return static_cast<unsigned char>(value);
+        }
+        return static_cast<unsigned char>(c);
+    }
+
+    /**
+     * @brief Parses a class after the `[`. A class with a non-ASCII character
+     * or a `\u` escape is a set of code points matching their UTF-8
+     * encodings, and its negation matches the encodings of all the other code
+     * points. Other classes, negated or not, are sets of bytes.
+     */
+    RegexNode ParseClass() {
+        ByteSet set;
+        CodePoints code_points;
+        bool unicode = false;
+        bool negate = pos_ < pattern_.size() && Peek() == '^';
+        if (negate) {
+            ++pos_;
+        }
+        // a `]` right after the opening bracket is a character
+        bool first = true;
+        while (true) {
+            if (pos_ == pattern_.size()) {
+                Fail("unterminated `[`");
+            }
+            if (Peek() == ']' && !first) {
+                ++pos_;
+                break;
+            }
+            first = false;
+            if (pattern_.substr(pos_, 2) == "[:") {
+                size_t end = pattern_.find(":]", pos_ + 2);
+                if (end == std::string_view::npos) {
+                    Fail("unterminated `[:`");
+                }
+                std::string name(pattern_.substr(pos_ + 2, end - pos_ - 2));
+                AddNamedClass(set, name);
+                pos_ = end + 2;
+                continue;
+            }
+            auto [lo, lo_unicode] = ParseClassMember();
+            uint32_t hi = lo;
+            bool hi_unicode = lo_unicode;
+            if (pos_ + 1 < pattern_.size() && Peek() == '-' &&
+                pattern_[pos_ + 1] != ']') {
+                ++pos_;
+                std::tie(hi, hi_unicode) = ParseClassMember();
+                if (hi < lo) {
+                    Fail("reversed range");
+                }
+            }
+            if (lo_unicode || hi_unicode) {
+                unicode = true;
+                code_points.emplace_back(lo, hi);
+            } else {
+                for (uint32_t b = lo; b <= hi; ++b) {
+                    set.set(b);
+                }
+            }
+        }
+        if (!unicode) {
+            if (negate) {
+                set.flip();
+            }
+            return MakeSet(set);
+        }
+        for (unsigned b = 0; b < 256; ++b) {
+            if (!set.test(b)) {
+                continue;
+            }
+            if (b >= 0x80) {
+                Fail("bytes above `\\x7f` in a class of code points");
+            }
+            code_points.emplace_back(b, b);
+        }
+        return MakeCodePoints(Normalize(std::move(code_points), negate));
+    }
+
+    /**
+     * @brief Parses a character of a class.
+     * @return The byte or the code point, and whether it is a code point.
+     */
+    std::pair<uint32_t, bool> ParseClassMember() {
+        if (Peek() == '\\' && pos_ + 1 < pattern_.size() &&
+            (pattern_[pos_ + 1] == 'u' || pattern_[pos_ + 1] == 'U')) {
+            ++pos_;
+            return {ParseCodePointEscape(), true};
+        }
+        auto decoded = DecodeUtf8(pattern_.substr(pos_));
+        if (decoded.has_value()) {
+            pos_ += decoded->second;
+            return {decoded->first, true};
+        }
+        return {ParseClassByte(), false};
+    }
+
+    /**
+     * @brief Sorts and merges the ranges, complements them if `negate` and
+     * leaves out the surrogates, which have no encoding.
+     */
+    static CodePoints Normalize(CodePoints ranges, bool negate) {
+        std::sort(ranges.begin(), ranges.end());
+        CodePoints merged;
+        for (auto [lo, hi] : ranges) {
+            if (!merged.empty() && lo <= merged.back().second + 1) {
+                merged.back().second = std::max(merged.back().second, hi);
+            } else {
+                merged.emplace_back(lo, hi);
+            }
+        }
+        if (negate) {
+            CodePoints complement;
+            uint32_t next = 0;
+            for (auto [lo, hi] : merged) {
+                if (lo > next) {
+                    complement.emplace_back(next, lo - 1);
+                }
+                next = hi + 1;
+            }
+            if (next <= kMaxCodePoint) {
+                complement.emplace_back(next, kMaxCodePoint);
+            }
+            merged = std::move(complement);
+        }
+        CodePoints encodable;
+        for (auto [lo, hi] : merged) {
+            if (lo < 0xD800 && hi >= 0xD800) {
+                encodable.emplace_back(lo, 0xD7FF);
+            }
+            if (lo <= 0xDFFF && hi > 0xDFFF) {
+                encodable.emplace_back(0xE000, hi);
+            }
+            if (hi < 0xD800 || lo > 0xDFFF) {
+                encodable.emplace_back(lo, hi);
+            }
+        }
+        return encodable;
+    }
+
+    unsigned char ParseClassByte() {
+        char c = pattern_[pos_++];
+        if (c == '\\') {
+            return ParseEscape();
+        }
+        return static_cast<unsigned char>(c);
+    }
+
+    void AddNamedClass(ByteSet &set, const std::string &name) {
+        static const std::map<std::string, int (*)(int)> kClasses = {
+            {"alnum", [](int b) { return std::isalnum(b); }},
+            {"alpha", [](int b) { return std::isalpha(b); }},
+            {"blank", [](int b) { return std::isblank(b); }},
+            {"cntrl", [](int b) { return std::iscntrl(b); }},
+            {"digit", [](int b) { return std::isdigit(b); }},
+            {"graph", [](int b) { return std::isgraph(b); }},
+            {"lower", [](int b) { return std::islower(b); }},
+            {"print", [](int b) { return std::isprint(b); }},
+            {"punct", [](int b) { return std::ispunct(b); }},
+            {"space", [](int b) { return std::isspace(b); }},
+            {"upper", [](int b) { return std::isupper(b); }},
+            {"xdigit", [](int b) { return std::isxdigit(b); }},
+        };
+        auto it = kClasses.find(name);
+        if (it == kClasses.end()) {
+            Fail("unknown class `[:" + name + ":]`");
+        }
+        // the classes of the "C" locale
+        for (int b = 0; b < 128; ++b) {
+            if (it->second(b)) {
+                set.set(b);
+            }
+        }
+    }
+
+    RegexNode ParseString() {
+        RegexNode concat;
+        concat.kind = RegexNode::Kind::CONCAT;
+        while (true) {
+            if (pos_ == pattern_.size()) {
+                Fail("unterminated `\"`");
+            }
+            char c = pattern_[pos_++];
+            if (c == '"') {
+                break;
+            }
+            if (c == '\\' && PeekCodePointEscape()) {
+                for (char b : EncodeUtf8(ParseCodePointEscape())) {
+                    concat.children.push_back(MakeByte(b));
+                }
+                continue;
+            }
+            concat.children.push_back(
+                MakeByte(c == '\\' ? ParseEscape() : c)
+            );
+        }
+        return concat;
+    }
+
+    std::string_view pattern_;
+    size_t pos_ = 0;
+};
+
+/**
+ * @brief A Thompson NFA. Every state has epsilon edges and at most one edge on
+ * a set of bytes.
+ */
+struct Nfa {
+    static constexpr size_t kNoSet = static_cast<size_t>(-1);
+
+    struct State {
+        std::vector<size_t> epsilon;
+        size_t set = kNoSet;
+        size_t target = 0;
+        std::optional<size_t> accept;
+    };
+
+    std::vector<State> states;
+    std::vector<ByteSet> sets;
+
+    size_t Add() {
+        states.emplace_back();
+        return states.size() - 1;
+    }
+
+    void Link(size_t from, size_t to) {
+        states[from].epsilon.push_back(to);
+    }
+
+    /**
+     * @brief Adds the states of the node.
+     * @return The entry and the exit state.
+     */
+    std::pair<size_t, size_t> Build(const RegexNode &node) {
+        switch (node.kind) {
+            case RegexNode::Kind::SET: {
+                size_t start = Add();
+                size_t end = Add();
+                states[start].set = sets.size();
+                states[start].target = end;
+                sets.push_back(node.set);
+                return {start, end};
+            }
+            case RegexNode::Kind::CONCAT: {
+                size_t start = Add();
+                size_t end = start;
+                for (const RegexNode &child : node.children) {
+                    auto [child_start, child_end] = Build(child);
+                    Link(end, child_start);
+                    end = child_end;
+                }
+                return {start, end};
+            }
+            case RegexNode::Kind::ALT: {
+                size_t start = Add();
+                size_t end = Add();
+                for (const RegexNode &child : node.children) {
+                    auto [child_start, child_end] = Build(child);
+                    Link(start, child_start);
+                    Link(child_end, end);
+                }
+                return {start, end};
+            }
+            case RegexNode::Kind::REPEAT: {
+                const RegexNode &child = node.children[0];
+                size_t start = Add();
+                size_t end = start;
+                for (size_t i = 0; i < node.min; ++i) {
+                    auto [child_start, child_end] = Build(child);
+                    Link(end, child_start);
+                    end = child_end;
+                }
+                if (!node.max.has_value()) {
+                    size_t loop = Add();
+                    auto [child_start, child_end] = Build(child);
+                    Link(end, loop);
+                    Link(loop, child_start);
+                    Link(child_end, loop);
+                    return {start, loop};
+                }
+                size_t exit = Add();
+                Link(end, exit);
+                for (size_t i = node.min; i < node.max.value(); ++i) {
+                    auto [child_start, child_end] = Build(child);
+                    Link(end, child_start);
+                    Link(child_end, exit);
+                    end = child_end;
+                }
+                return {start, exit};
+            }
+        }
+        return {0, 0};
+    }
+
+    std::vector<size_t> Closure(std::vector<size_t> subset) const {
+        std::vector<bool> seen(states.size(), false);
+        for (size_t s : subset) {
+            seen[s] = true;
+        }
+        for (size_t i = 0; i < subset.size(); ++i) {
+            for (size_t t : states[subset[i]].epsilon) {
+                if (!seen[t]) {
+                    seen[t] = true;
+                    subset.push_back(t);
+                }
+            }
+        }
+        std::sort(subset.begin(), subset.end());
+        return subset;
+    }
+};
+}  // namespace
+
+RegexError::RegexError(const std::string &msg) : msg_(msg) {
+}
+
+const char *RegexError::what() const noexcept {
+    return msg_.c_str();
+}
+
+LexerAutomaton::LexerAutomaton(const std::vector<std::string> &patterns) {
+    Nfa nfa;
+    size_t start = nfa.Add();
+    for (size_t i = 0; i < patterns.size(); ++i) {
+        auto [entry, exit] = nfa.Build(RegexParser(patterns[i]).Parse());
+        nfa.Link(start, entry);
+        nfa.states[exit].accept = i;
+    }
+
+    // two bytes are in the same class if every set has both or neither
+    classes_.assign(256, 0);
+    class_count_ = 1;
+    for (const ByteSet &set : nfa.sets) {
+        std::map<std::pair<uint32_t, bool>, uint32_t> split;
+        for (size_t b = 0; b < 256; ++b) {
+            auto key = std::make_pair(classes_[b], set.test(b));
+            auto it = split.try_emplace(key, split.size()).first;
+            classes_[b] = it->second;
+        }
+        class_count_ = split.size();
+    }
+    std::vector<size_t> representative(class_count_, 256);
+    for (size_t b = 256; b-- > 0;) {
+        representative[classes_[b]] = b;
+    }
+
+    // subset construction, the empty subset is the dead state
+    std::map<std::vector<size_t>, size_t> ids;
+    std::vector<std::vector<size_t>> subsets = {{}, nfa.Closure({start})};
+    ids[subsets[0]] = 0;
+    ids[subsets[1]] = 1;
+    std::vector<uint32_t> transitions;
+    std::vector<std::optional<size_t>> accept;
+    for (size_t i = 0; i < subsets.size(); ++i) {
+        std::optional<size_t> rule;
+        for (size_t s : subsets[i]) {
+            std::optional<size_t> a = nfa.states[s].accept;
+            if (a.has_value() && (!rule.has_value() || a < rule)) {
+                rule = a;
+            }
+        }
+        accept.push_back(rule);
+        for (size_t c = 0; c < class_count_; ++c) {
+            std::vector<size_t> moved;
+            for (size_t s : subsets[i]) {
+                const Nfa::State &state = nfa.states[s];
+                if (state.set != Nfa::kNoSet &&
+                    nfa.sets[state.set].test(representative[c])) {
+                    moved.push_back(state.target);
+                }
+            }
+            moved = nfa.Closure(std::move(moved));
+            auto [it, added] = ids.try_emplace(moved, subsets.size());
+            if (added) {
+                subsets.push_back(std::move(moved));
+            }
+            transitions.push_back(it->second);
+        }
+    }
+
+    // Moore's partition refinement, starting from the accepted patterns
+    size_t n = subsets.size();
+    std::vector<uint32_t> block(n);
+    size_t block_count = 0;
+    {
+        std::map<std::optional<size_t>, uint32_t> initial;
+        for (size_t s = 0; s < n; ++s) {
+            block[s] = initial.try_emplace(accept[s], initial.size())
+                           .first->second;
+        }
+        block_count = initial.size();
+    }
+    while (true) {
+        std::map<std::vector<uint32_t>, uint32_t> signatures;
+        std::vector<uint32_t> refined(n);
+        for (size_t s = 0; s < n; ++s) {
+            std::vector<uint32_t> signature = {block[s]};
+            for (size_t c = 0; c < class_count_; ++c) {
+                signature.push_back(block[transitions[s * class_count_ + c]]);
+            }
+            refined[s] = signatures
+                             .try_emplace(
+                                 std::move(signature), signatures.size()
+                             )
+                             .first->second;
+        }
+        block = std::move(refined);
+        if (signatures.size() == block_count) {
+            break;
+        }
+        block_count = signatures.size();
+    }
+
+    // renumbers the blocks breadth-first from the start, the block of the
+    // dead state becomes state 0
+    std::vector<int64_t> id_of(block_count, -1);
+    id_of[block[0]] = 0;
+    if (block[1] != block[0]) {
+        id_of[block[1]] = 1;
+    }
+    std::vector<size_t> members = {0, 1};
+    for (size_t k = 1; k < members.size(); ++k) {
+        for (size_t c = 0; c < class_count_; ++c) {
+            size_t t = transitions[members[k] * class_count_ + c];
+            if (id_of[block[t]] == -1) {
+                id_of[block[t]] = members.size();
+                members.push_back(t);
+            }
+        }
+    }
+    transitions_.assign(members.size() * class_count_, 0);
+    accept_.assign(members.size(), std::nullopt);
+    for (size_t k = 1; k < members.size(); ++k) {
+        accept_[k] = accept[members[k]];
+        for (size_t c = 0; c < class_count_; ++c) {
+            size_t t = transitions[members[k] * class_count_ + c];
+            transitions_[k * class_count_ + c] = id_of[block[t]];
+        }
+    }
+
+    // the sets may tell apart bytes the minimal DFA doesn't, the classes with
+    // equal columns are merged
+    std::map<std::vector<uint32_t>, uint32_t> columns;
+    std::vector<uint32_t> merged(class_count_);
+    std::vector<size_t> kept;
+    for (size_t c = 0; c < class_count_; ++c) {
+        std::vector<uint32_t> column;
+        for (size_t s = 0; s < members.size(); ++s) {
+            column.push_back(transitions_[s * class_count_ + c]);
+        }
+        auto [it, added] = columns.try_emplace(column, columns.size());
+        if (added) {
+            kept.push_back(c);
+        }
+        merged[c] = it->second;
+    }
+    for (uint32_t &c : classes_) {
+        c = merged[c];
+    }
+    std::vector<uint32_t> narrowed;
+    for (size_t s = 0; s < members.size(); ++s) {
+        for (size_t c : kept) {
+            narrowed.push_back(transitions_[s * class_count_ + c]);
+        }
+    }
+    class_count_ = kept.size();
+    transitions_ = std::move(narrowed);
+}
+
+size_t LexerAutomaton::GetStateCount() const {
+    return accept_.size();
+}
+
+size_t LexerAutomaton::GetClassCount() const {
+    return class_count_;
+}
+
+const std::vector<uint32_t> &LexerAutomaton::GetClasses() const {
+    return classes_;
+}
+
+const std::vector<uint32_t> &LexerAutomaton::GetTransitions() const {
+    return transitions_;
+}
+
+size_t LexerAutomaton::GetNext(size_t state, size_t cls) const {
+    return transitions_[state * class_count_ + cls];
+}
+
+std::optional<size_t> LexerAutomaton::GetAccept(size_t state) const {
+    return accept_[state];
+}
+
+std::vector<unsigned char> LexerAutomaton::GetLoopBytes(size_t state) const {
+    std::vector<unsigned char> bytes;
+    for (unsigned b = 0; b < 256; ++b) {
+        if (GetNext(state, classes_[b]) == state) {
+            bytes.push_back(static_cast<unsigned char>(b));
+        }
+    }
+    return bytes;
+}
+
+size_t LexerAutomaton::CountContinuing(unsigned char byte) const {
+    size_t count = 0;
+    for (size_t state = 2; state < GetStateCount(); ++state) {
+        count += GetNext(state, classes_[byte]) != 0;
+    }
+    return count;
+}
+
+std::optional<std::pair<size_t, size_t>> LexerAutomaton::Match(
+    std::string_view input
+) const {
+    std::optional<std::pair<size_t, size_t>> match;
+    size_t state = 1;
+    for (size_t i = 0; i < input.size(); ++i) {
+        unsigned char b = static_cast<unsigned char>(input[i]);
+        state = GetNext(state, classes_[b]);
+        if (state == 0) {
+            break;
+        }
+        if (accept_[state].has_value()) {
+            match = std::make_pair(accept_[state].value(), i + 1);
+        }
+    }
+    return match;
+}
@@ -1,9 +1,96 @@
 #include "LexerGenerator.h"
 
-#include <filesystem>
+#include <algorithm>
+#include <cctype>
 #include <fstream>
 
+#include "CodegenHelpers.h"
+#include "CombTables.h"
+#include "DenseTables.h"
 #include "Helpers.h"
+#include "KeywordHash.h"
+
+namespace {
+/**
+ * @brief Returns the byte as a character literal if it is printable, as a
+ * number otherwise.
+ */
+std::string ByteLiteral(unsigned b) {
+    if (b < 128 && std::isgraph(static_cast<int>(b)) && b != '\'' &&
+        b != '\\') {
+        return std::string("'") + static_cast<char>(b) + "'";
+    }
+    return std::to_string(b);
+}
+
+/**
+ * @brief Compiles the patterns.
+ * @throws LexerGeneratorError if a pattern can't be compiled.
+ */
+LexerAutomaton Compile(const std::vector<std::string> &patterns) {
+    try {
+        return LexerAutomaton(patterns);
+    } catch (const RegexError &e) {
+        throw LexerGeneratorError(e.what());
+    }
+}
+
+/**
+ * @brief Returns whether the quote terminal is made of printable characters
+ * only and needs no escaping, so its name is the text it matches.
+ */
+bool IsPlainWord(const std::string &name) {
+    return !name.empty() && std::all_of(name.begin(), name.end(), [](char c) {
+        return c > ' ' && c < 127 && c != '\\' && c != '"';
+    });
+}
+
+/**
+ * @brief The most bytes a vectorized skip compares every block of the input
+ * with.
+ */
+constexpr size_t kMaxSkipBytes = 4;
+
+/**
+ * @brief Returns the function skipping the bytes the state loops on, an empty
+ * string if the loop isn't worth vectorizing.
+ * @details Either the bytes of the loop, as in whitespace, or the bytes
+ * leaving it, as in comments and strings, are compared with every block, so
+ * one of them has to be a few bytes. A loop over UTF-8 characters leaves the
+ * state on every non-ASCII byte, only its ASCII runs are skipped then.
+ */
+std::string SkipFunction(const LexerAutomaton &dfa, size_t state) {
+    std::vector<unsigned char> loop = dfa.GetLoopBytes(state);
+    if (state == 0 || loop.empty()) {
+        return "";
+    }
+    bool until = loop.size() > kMaxSkipBytes;
+    bool high = false;
+    std::vector<unsigned char> bytes;
+    if (until) {
+        for (unsigned b = 0; b < 256; ++b) {
+            if (!std::binary_search(loop.begin(), loop.end(), b)) {
+                bytes.push_back(static_cast<unsigned char>(b));
+            }
+        }
+        if (bytes.size() > kMaxSkipBytes && loop.back() < 0x80) {
+            high = true;
+            std::erase_if(bytes, [](unsigned char b) { return b >= 0x80; });
+        }
+        if (bytes.size() > kMaxSkipBytes) {
+            return "";
+        }
+    } else {
+        bytes = loop;
+    }
+    std::string function = until ? "Skip<true" : "Skip<false";
+    function += high ? ", true" : ", false";
+    for (unsigned char b : bytes) {
+        function += ", " + ByteLiteral(b);
+    }
+    return function + ">";
+}
+}  // namespace
 
 LexerGeneratorError::LexerGeneratorError(const std::string &msg) : msg_(msg) {
 }
@@ -12,67 +99,27 @@ const char *LexerGeneratorError::what() const noexcept {
     return msg_.c_str();
 }
 
-LexerGenerator::LexerGenerator(const std::string &folder, const Grammar &g)
-    : folder_(folder), g_(g) {
+LexerGenerator::LexerGenerator(
+    const std::string &folder, const Grammar &g, ScannerKind scanner,
+    KeywordMode keywords
+)
+    : folder_(folder), g_(g), scanner_(scanner), keywords_(keywords) {
 }
 
 void LexerGenerator::Generate() {
-    std::ofstream out(folder_ + "/Lexer.l");
-    out << "%option noyywrap\n";
-    out << "%{\n";
-    out << "#include <cstdio>\n";
-    out << "#include <cstdlib>\n";
-    out << "#include <iostream>\n";
-    out << "#include <vector>\n";
-    out << "\n";
-    out << "#include \"LexerFwd.hpp\"\n";
-    out << "\n";
-    out << "std::vector<p::Terminal> tokens;\n";
-    out << "\n";
-    out << "extern FILE *yyin;\n";
-    out << "extern \"C\" int yylex();\n";
-    out << "\n";
-    out << "std::vector<p::Terminal> Lex(const char *filename) {\n";
-    out << "    tokens.clear();\n";
-    out << "    FILE *file = fopen(filename, \"r\");\n";
-    out << "    if (!file) {\n";
-    out << "        std::cerr << \"Error: cannot open file `\" << filename << "
-           "\"`\" << std::endl;\n";
-    out << "        exit(1);\n";
-    out << "    }\n";
-    out << "    yyin = file;\n";
-    out << "    yylex();\n";
-    out << "    return tokens;\n";
-    out << "}\n";
-    out << "%}\n";
-    out << "\n";
-    out << "%%\n";
-    out << "\n";
+    std::vector<Terminal> quotes;
     for (const Token &token : g_.tokens_) {
-        // if (IsTerminal(token)) {
         if (IsNonTerminal(token)) {
             continue;
         }
         Terminal t = std::get<Terminal>(token);
-        if (t == T_EOF || t.name_.empty()) {
+        if (t == T_EOF || t.name_.empty() || !t.IsQuote()) {
             continue;
         }
-        if (t.IsQuote()) {
-            out << "\"";
-            for (const char &c : t.name_) {
-                // user may pass something like '\n' as a token. this should
-                // be taken exactly as if it was embraced in double quotes
-                // without modifying (so '\n' is considered a newline, not a
-                // sequence of backslash and `n`)
-                if (c == '"') {
-                    out << "\\";
-                }
-                out << c;
-            }
-            out << "\"" << "\t"
-                << "{ tokens.push_back(p::Terminal{yytext}); }\n";
-        }
+        quotes.push_back(t);
     }
+    std::vector<std::string> regexes;
+    std::vector<std::optional<Terminal>> regex_rules;
     for (const Token &token : g_.tokens_) {
         if (IsNonTerminal(token)) {
             continue;
@@ -82,34 +129,975 @@ void LexerGenerator::Generate() {
             continue;
         }
         if (t.IsRegex() && t.repr_ != " ") {
-            out << t.repr_ << "\t"
-                << "{ tokens.push_back(p::Terminal{\"" << t.name_ << "\", "
-                << "yytext}); }\n";
+            regexes.push_back(t.repr_);
+            regex_rules.push_back(t);
         }
     }
     for (const std::string &regex : g_.ignored_) {
-        out << regex << "\t;\n";
+        regexes.push_back(regex);
+        regex_rules.push_back(std::nullopt);
+    }
+
+    // the keywords a regex terminal matches in full win over it only when
+    // the match is no longer than them, which the lexer can tell after the
+    // regex terminal is matched
+    std::vector<std::optional<size_t>> lexed_by(quotes.size());
+    if (keywords_ == KeywordMode::HASH) {
+        LexerAutomaton words = Compile(regexes);
+        for (size_t q = 0; q < quotes.size(); ++q) {
+            const std::string &name = quotes[q].name_;
+            if (!IsPlainWord(name)) {
+                continue;
+            }
+            auto match = words.Match(name);
+            if (match.has_value() && match->second == name.size() &&
+                regex_rules[match->first].has_value()) {
+                lexed_by[q] = match->first;
+            }
+        }
+    }
+
+    rules_.clear();
+    hashed_.clear();
+    std::vector<std::string> patterns;
+    for (size_t q = 0; q < quotes.size(); ++q) {
+        if (lexed_by[q].has_value()) {
+            continue;
+        }
+        // the terminal is taken as a string, escapes included: '\n' is a
+        // newline, not a backslash and `n`
+        std::string pattern = "\"";
+        for (const char &c : quotes[q].name_) {
+            if (c == '"') {
+                pattern += "\\";
+            }
+            pattern += c;
+        }
+        patterns.push_back(pattern + "\"");
+        rules_.push_back(quotes[q]);
     }
+    for (size_t q = 0; q < quotes.size(); ++q) {
+        if (lexed_by[q].has_value()) {
+            hashed_.emplace_back(quotes[q], rules_.size() + lexed_by[q].value());
+        }
+    }
+    patterns.insert(patterns.end(), regexes.begin(), regexes.end());
+    rules_.insert(rules_.end(), regex_rules.begin(), regex_rules.end());
+
+    std::optional<LexerAutomaton> dfa = Compile(patterns);
 
+    SymbolIds symbols(g_);
+    std::ofstream out(folder_ + "/Lexer.cpp");
+    out << "#include <fcntl.h>\n";
+    out << "#include <sys/mman.h>\n";
+    out << "#include <sys/stat.h>\n";
+    out << "#include <unistd.h>\n";
+    out << "\n";
+    out << "#include <algorithm>\n";
+    out << "#include <cstddef>\n";
+    out << "#include <cerrno>\n";
+    out << "#include <cstdint>\n";
+    out << "#include <cstdio>\n";
+    out << "#include <memory>\n";
+    out << "#include <string>\n";
+    out << "#include <string_view>\n";
+    out << "#include <system_error>\n";
+    out << "#include <thread>\n";
+    out << "#include <utility>\n";
+    out << "#include <vector>\n";
+    out << "\n";
+    out << "#include \"LexerFwd.hpp\"\n";
+    out << "\n";
+    bool skips = false;
+    for (size_t s = 0; s < dfa->GetStateCount(); ++s) {
+        skips = skips || !SkipFunction(dfa.value(), s).empty();
+    }
+    if (skips) {
+        out << "#if defined(__GNUC__) && defined(__SSE2__)\n";
+        out << "#include <immintrin.h>\n";
+        out << "#endif\n";
+        out << "\n";
+    }
+    out << "namespace {\n";
+    if (skips) {
+        GenerateSkip(out);
+        out << "\n";
+    }
+    if (scanner_ == ScannerKind::TABLE) {
+        GenerateTableScanner(out, dfa.value());
+    } else {
+        GenerateDirectScanner(out, dfa.value());
+    }
+    out << "\n";
+    out << "// the terminal id of every rule plus 1, p::kTerminalCount for the "
+           "IGNORE\n";
+    out << "// ones\n";
+    out << "constexpr std::uint32_t kRuleTerminal[] = {\n";
+    out << "    p::kTerminalCount,\n";
+    for (size_t r = 0; r < rules_.size(); ++r) {
+        out << "    ";
+        if (rules_[r].has_value()) {
+            out << symbols.GetTerminalId(rules_[r].value()) << ",  // "
+                << DescribeToken(rules_[r].value());
+        } else {
+            out << "p::kTerminalCount,  // IGNORE";
+        }
+        out << "\n";
+    }
+    out << "};\n";
+    out << "\n";
+    GenerateSyncBytes(out, dfa.value());
     out << "\n";
-    out << "%%\n";
+    if (!hashed_.empty()) {
+        GenerateKeywords(out);
+        out << "\n";
+    }
+    out << "std::string ErrorMessage(const std::string &what, int error) {\n";
+    out << "    return what + \": \" + std::system_category().message(error);\n";
+    out << "}\n";
+    out << "\n";
+    out << "// reads the descriptor from its offset to the end, a regular file "
+           "is mapped\n";
+    out << "// into memory and anything else is read into a string, the "
+           "pointer owns the\n";
+    out << "// text\n";
+    out << "std::shared_ptr<const void> Load(int fd, std::string_view &text) "
+           "{\n";
+    out << "    struct stat st;\n";
+    out << "    if (fstat(fd, &st) != 0) {\n";
+    out << "        throw p::LexerError(ErrorMessage(\"cannot read the input\", "
+           "errno));\n";
+    out << "    }\n";
+    out << "    off_t offset = lseek(fd, 0, SEEK_CUR);\n";
+    out << "    if (S_ISREG(st.st_mode) && offset >= 0) {\n";
+    out << "        size_t size = static_cast<size_t>(st.st_size);\n";
+    out << "        size_t start = static_cast<size_t>(offset);\n";
+    out << "        if (start >= size) {\n";
+    out << "            text = std::string_view();\n";
+    out << "            return nullptr;\n";
+    out << "        }\n";
+    out << "        void *data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, "
+           "fd, 0);\n";
+    out << "        if (data != MAP_FAILED) {\n";
+    out << "            madvise(data, size, MADV_SEQUENTIAL);\n";
+    out << "            // the input is consumed as if it was read\n";
+    out << "            lseek(fd, 0, SEEK_END);\n";
+    out << "            text = std::string_view(static_cast<const char *>(data), "
+           "size)\n";
+    out << "                       .substr(start);\n";
+    out << "            return std::shared_ptr<const void>(data, [size](void "
+           "*mapped) {\n";
+    out << "                munmap(mapped, size);\n";
+    out << "            });\n";
+    out << "        }\n";
+    out << "    }\n";
+    out << "    auto buffer = std::make_shared<std::string>();\n";
+    out << "    char chunk[1 << 16];\n";
+    out << "    while (true) {\n";
+    out << "        ssize_t n = read(fd, chunk, sizeof(chunk));\n";
+    out << "        if (n < 0 && errno == EINTR) {\n";
+    out << "            continue;\n";
+    out << "        }\n";
+    out << "        if (n < 0) {\n";
+    out << "            throw p::LexerError(ErrorMessage(\"cannot read the "
+           "input\", errno));\n";
+    out << "        }\n";
+    out << "        if (n == 0) {\n";
+    out << "            break;\n";
+    out << "        }\n";
+    out << "        buffer->append(chunk, static_cast<size_t>(n));\n";
+    out << "    }\n";
+    out << "    text = *buffer;\n";
+    out << "    return buffer;\n";
+    out << "}\n";
+    out << "\n";
+    out << "// the stream may have buffered a part of the input already, so it "
+           "is read\n";
+    out << "// through the stream\n";
+    out << "std::shared_ptr<const void> Load(FILE *file, std::string_view "
+           "&text) {\n";
+    out << "    auto buffer = std::make_shared<std::string>();\n";
+    out << "    char chunk[1 << 16];\n";
+    out << "    size_t n;\n";
+    out << "    while ((n = fread(chunk, 1, sizeof(chunk), file)) > 0) {\n";
+    out << "        buffer->append(chunk, n);\n";
+    out << "    }\n";
+    out << "    if (ferror(file)) {\n";
+    out << "        throw p::LexerError(\"cannot read the input\");\n";
+    out << "    }\n";
+    out << "    text = *buffer;\n";
+    out << "    return buffer;\n";
+    out << "}\n";
+    out << "\n";
+    out << "std::shared_ptr<const void> Load(const char *filename, "
+           "std::string_view &text) {\n";
+    out << "    int fd = open(filename, O_RDONLY);\n";
+    out << "    if (fd < 0) {\n";
+    out << "        throw p::LexerError(ErrorMessage(\n";
+    out << "            \"cannot open file `\" + std::string(filename) + "
+           "\"`\", errno\n";
+    out << "        ));\n";
+    out << "    }\n";
+    out << "    try {\n";
+    out << "        std::shared_ptr<const void> storage = Load(fd, text);\n";
+    out << "        close(fd);\n";
+    out << "        return storage;\n";
+    out << "    } catch (...) {\n";
+    out << "        close(fd);\n";
+    out << "        throw;\n";
+    out << "    }\n";
+    out << "}\n";
+    out << "\n";
+    out << "template <typename Input>\n";
+    out << "p::TokenStream OpenStream(Input input) {\n";
+    out << "    std::string_view text;\n";
+    out << "    std::shared_ptr<const void> storage = Load(input, text);\n";
+    out << "    return p::TokenStream(text, std::move(storage));\n";
+    out << "}\n";
+    out << "\n";
+    out << "p::LexedInput Collect(p::TokenStream stream) {\n";
+    out << "    p::LexedInput input;\n";
+    out << "    input.text = stream.GetText();\n";
+    out << "    input.storage = stream.GetStorage();\n";
+    out << "    p::LexToken token;\n";
+    out << "    while (stream.Next(token)) {\n";
+    out << "        input.tokens.push_back(token);\n";
+    out << "    }\n";
+    out << "    return input;\n";
+    out << "}\n";
+    out << "\n";
+    out << "// the chunks are at least this long, shorter inputs are lexed on "
+           "one thread\n";
+    out << "constexpr size_t kMinChunk = 1 << 20;\n";
+    out << "\n";
+    out << "// the first sync byte in [begin, end), begin if there is none\n";
+    out << "size_t FindChunkStart(std::string_view text, size_t begin, size_t "
+           "end) {\n";
+    out << "    for (size_t i = begin; i < end; ++i) {\n";
+    out << "        if (kSyncBytes[static_cast<unsigned char>(text[i])]) {\n";
+    out << "            return i;\n";
+    out << "        }\n";
+    out << "    }\n";
+    out << "    return begin;\n";
+    out << "}\n";
+    out << "\n";
+    out << "// the tokens starting in [begin, end) when lexing from begin, and "
+           "the stream\n";
+    out << "// with the first token after them\n";
+    out << "struct Chunk {\n";
+    out << "    std::vector<p::LexToken> tokens;\n";
+    out << "    bool more = false;\n";
+    out << "    p::LexToken next = {};\n";
+    out << "    size_t pos = 0;\n";
+    out << "};\n";
+    out << "\n";
+    out << "void LexChunk(std::string_view text, size_t begin, size_t end, "
+           "Chunk &chunk) {\n";
+    out << "    p::TokenStream stream(text);\n";
+    out << "    stream.Seek(begin);\n";
+    out << "    while ((chunk.more = stream.Next(chunk.next)) && "
+           "chunk.next.offset < end) {\n";
+    out << "        chunk.tokens.push_back(chunk.next);\n";
+    out << "    }\n";
+    out << "    chunk.pos = stream.GetPosition();\n";
+    out << "}\n";
+    out << "\n";
+    out << "// the chunks after the first one are lexed from a guessed start, "
+           "the lexer\n";
+    out << "// goes on from the chunk before until it starts a token the chunk "
+           "starts too,\n";
+    out << "// since the tokens after a position only depend on it; this is "
+           "at the start of\n";
+    out << "// the chunk if no match goes on with its sync byte\n";
+    out << "p::LexedInput LexChunks(\n";
+    out << "    std::string_view text, std::shared_ptr<const void> storage, "
+           "unsigned threads\n";
+    out << ") {\n";
+    out << "    if (threads == 0) {\n";
+    out << "        threads = std::max(1u, "
+           "std::thread::hardware_concurrency());\n";
+    out << "    }\n";
+    out << "    size_t count = std::min<size_t>(threads, text.size() / "
+           "kMinChunk + 1);\n";
+    out << "    std::vector<size_t> starts(count + 1, text.size());\n";
+    out << "    for (size_t k = 0; k < count; ++k) {\n";
+    out << "        starts[k] = text.size() / count * k;\n";
+    out << "    }\n";
+    out << "    for (size_t k = 1; k < count; ++k) {\n";
+    out << "        starts[k] = FindChunkStart(text, starts[k], starts[k + "
+           "1]);\n";
+    out << "    }\n";
+    out << "    std::vector<Chunk> chunks(count);\n";
+    out << "    std::vector<std::thread> workers;\n";
+    out << "    for (size_t k = 1; k < count; ++k) {\n";
+    out << "        workers.emplace_back([&, k] {\n";
+    out << "            LexChunk(text, starts[k], starts[k + 1], chunks[k]);\n";
+    out << "        });\n";
+    out << "    }\n";
+    out << "    LexChunk(text, 0, starts[1], chunks[0]);\n";
+    out << "    for (std::thread &worker : workers) {\n";
+    out << "        worker.join();\n";
+    out << "    }\n";
+    out << "\n";
+    out << "    // the tokens of chunk k from used[k] on are the ones of the "
+           "input, after the\n";
+    out << "    // ones relexed[k] the lexer gave from the end of the chunk "
+           "before\n";
+    out << "    std::vector<size_t> used(count);\n";
+    out << "    std::vector<std::vector<p::LexToken>> relexed(count + 1);\n";
+    out << "    bool more = chunks[0].more;\n";
+    out << "    p::LexToken next = chunks[0].next;\n";
+    out << "    p::TokenStream stream(text);\n";
+    out << "    stream.Seek(chunks[0].pos);\n";
+    out << "    for (size_t k = 1; k < count; ++k) {\n";
+    out << "        const std::vector<p::LexToken> &guessed = "
+           "chunks[k].tokens;\n";
+    out << "        size_t &i = used[k];\n";
+    out << "        while (more && next.offset < starts[k + 1]) {\n";
+    out << "            while (i < guessed.size() && guessed[i].offset < "
+           "next.offset) {\n";
+    out << "                ++i;\n";
+    out << "            }\n";
+    out << "            if (i < guessed.size() && guessed[i].offset == "
+           "next.offset) {\n";
+    out << "                break;\n";
+    out << "            }\n";
+    out << "            relexed[k].push_back(next);\n";
+    out << "            more = stream.Next(next);\n";
+    out << "        }\n";
+    out << "        if (more && next.offset < starts[k + 1]) {\n";
+    out << "            more = chunks[k].more;\n";
+    out << "            next = chunks[k].next;\n";
+    out << "            stream.Seek(chunks[k].pos);\n";
+    out << "        } else {\n";
+    out << "            i = guessed.size();\n";
+    out << "        }\n";
+    out << "    }\n";
+    out << "    while (more) {\n";
+    out << "        relexed[count].push_back(next);\n";
+    out << "        more = stream.Next(next);\n";
+    out << "    }\n";
+    out << "\n";
+    out << "    std::vector<size_t> at(count + 1);\n";
+    out << "    size_t total = 0;\n";
+    out << "    for (size_t k = 0; k <= count; ++k) {\n";
+    out << "        total += relexed[k].size();\n";
+    out << "        at[k] = total;\n";
+    out << "        if (k < count) {\n";
+    out << "            total += chunks[k].tokens.size() - used[k];\n";
+    out << "        }\n";
+    out << "    }\n";
+    out << "    p::LexedInput input;\n";
+    out << "    input.text = text;\n";
+    out << "    input.storage = std::move(storage);\n";
+    out << "    // the tokens of the first chunk are kept where they are\n";
+    out << "    input.tokens = std::move(chunks[0].tokens);\n";
+    out << "    input.tokens.resize(total);\n";
+    out << "    auto place = [&](size_t k) {\n";
+    out << "        std::copy(\n";
+    out << "            chunks[k].tokens.begin() + "
+           "static_cast<std::ptrdiff_t>(used[k]),\n";
+    out << "            chunks[k].tokens.end(),\n";
+    out << "            input.tokens.begin() + "
+           "static_cast<std::ptrdiff_t>(at[k])\n";
+    out << "        );\n";
+    out << "    };\n";
+    out << "    workers.clear();\n";
+    out << "    for (size_t k = 1; k < count; ++k) {\n";
+    out << "        workers.emplace_back(place, k);\n";
+    out << "    }\n";
+    out << "    for (size_t k = 1; k <= count; ++k) {\n";
+    out << "        std::copy(\n";
+    out << "            relexed[k].begin(), relexed[k].end(),\n";
+    out << "            input.tokens.begin() +\n";
+    out << "                static_cast<std::ptrdiff_t>(at[k] - "
+           "relexed[k].size())\n";
+    out << "        );\n";
+    out << "    }\n";
+    out << "    for (std::thread &worker : workers) {\n";
+    out << "        worker.join();\n";
+    out << "    }\n";
+    out << "    return input;\n";
+    out << "}\n";
+    out << "}  // namespace\n";
+    out << "\n";
+    out << "bool p::TokenStream::Next(p::LexToken &token) {\n";
+    out << "    while (pos_ < text_.size()) {\n";
+    out << "        size_t start = pos_;\n";
+    out << "        size_t end = pos_;\n";
+    out << "        size_t rule = Match(text_, start, end);\n";
+    out << "        if (rule == 0) {\n";
+    out << "            // nothing matches the byte, it is skipped\n";
+    out << "            ++pos_;\n";
+    out << "            continue;\n";
+    out << "        }\n";
+    out << "        pos_ = end;\n";
+    if (hashed_.empty()) {
+        out << "        std::uint32_t id = kRuleTerminal[rule];\n";
+    } else {
+        out << "        std::uint32_t id =\n";
+        out << "            MatchedTerminal(rule, text_.substr(start, end - "
+               "start));\n";
+    }
+    out << "        if (id != p::kTerminalCount) {\n";
+    out << "            token = p::LexToken{\n";
+    out << "                id, static_cast<std::uint32_t>(end - start), "
+           "start\n";
+    out << "            };\n";
+    out << "            return true;\n";
+    out << "        }\n";
+    out << "    }\n";
+    out << "    return false;\n";
+    out << "}\n";
+    out << "\n";
+    out << "p::TokenStream p::Lexer::Stream(std::string_view buffer) const "
+           "{\n";
+    out << "    return p::TokenStream(buffer);\n";
+    out << "}\n";
+    out << "\n";
+    out << "p::TokenStream p::Lexer::Stream(int fd) const {\n";
+    out << "    return OpenStream(fd);\n";
+    out << "}\n";
+    out << "\n";
+    out << "p::TokenStream p::Lexer::Stream(FILE *file) const {\n";
+    out << "    return OpenStream(file);\n";
+    out << "}\n";
+    out << "\n";
+    out << "p::TokenStream p::Lexer::StreamFile(const char *filename) const "
+           "{\n";
+    out << "    return OpenStream(filename);\n";
+    out << "}\n";
+    out << "\n";
+    out << "p::LexedInput p::Lexer::Lex(std::string_view buffer) const {\n";
+    out << "    return Collect(Stream(buffer));\n";
+    out << "}\n";
+    out << "\n";
+    out << "p::LexedInput p::Lexer::Lex(int fd) const {\n";
+    out << "    return Collect(Stream(fd));\n";
+    out << "}\n";
+    out << "\n";
+    out << "p::LexedInput p::Lexer::Lex(FILE *file) const {\n";
+    out << "    return Collect(Stream(file));\n";
+    out << "}\n";
+    out << "\n";
+    out << "p::LexedInput p::Lexer::LexFile(const char *filename) const {\n";
+    out << "    return Collect(StreamFile(filename));\n";
+    out << "}\n";
+    out << "\n";
+    out << "p::LexedInput p::Lexer::LexParallel(std::string_view buffer, "
+           "unsigned threads)\n";
+    out << "    const {\n";
+    out << "    return LexChunks(buffer, nullptr, threads);\n";
+    out << "}\n";
+    out << "\n";
+    out << "p::LexedInput p::Lexer::LexFileParallel(\n";
+    out << "    const char *filename, unsigned threads\n";
+    out << ") const {\n";
+    out << "    std::string_view text;\n";
+    out << "    std::shared_ptr<const void> storage = Load(filename, text);\n";
+    out << "    return LexChunks(text, std::move(storage), threads);\n";
+    out << "}\n";
+    out << "\n";
+    out << "p::TokenPipe::TokenPipe(p::TokenStream stream)\n";
+    out << "    : text_(stream.GetText()),\n";
+    out << "      storage_(stream.GetStorage()),\n";
+    out << "      batches_(std::make_unique<Batch[]>(kBatches)) {\n";
+    out << "    thread_ = std::thread(&TokenPipe::Produce, this, "
+           "std::move(stream));\n";
+    out << "}\n";
+    out << "\n";
+    out << "p::TokenPipe::~TokenPipe() {\n";
+    out << "    // wakes the lexer up if the ring is full\n";
+    out << "    stop_.store(true, std::memory_order_relaxed);\n";
+    out << "    read_.fetch_add(1, std::memory_order_release);\n";
+    out << "    read_.notify_one();\n";
+    out << "    thread_.join();\n";
+    out << "}\n";
+    out << "\n";
+    out << "void p::TokenPipe::Produce(p::TokenStream stream) {\n";
+    out << "    size_t written = 0;\n";
+    out << "    bool last = false;\n";
+    out << "    while (!last) {\n";
+    out << "        size_t read = read_.load(std::memory_order_acquire);\n";
+    out << "        while (written - read >= kBatches &&\n";
+    out << "               !stop_.load(std::memory_order_relaxed)) {\n";
+    out << "            read_.wait(read, std::memory_order_acquire);\n";
+    out << "            read = read_.load(std::memory_order_acquire);\n";
+    out << "        }\n";
+    out << "        if (stop_.load(std::memory_order_relaxed)) {\n";
+    out << "            return;\n";
+    out << "        }\n";
+    out << "        Batch &batch = batches_[written % kBatches];\n";
+    out << "        batch.count = 0;\n";
+    out << "        try {\n";
+    out << "            while (batch.count < kBatchSize &&\n";
+    out << "                   stream.Next(batch.tokens[batch.count])) {\n";
+    out << "                ++batch.count;\n";
+    out << "            }\n";
+    out << "            last = batch.count < kBatchSize;\n";
+    out << "        } catch (...) {\n";
+    out << "            error_ = std::current_exception();\n";
+    out << "            last = true;\n";
+    out << "        }\n";
+    out << "        batch.last = last;\n";
+    out << "        written_.store(++written, std::memory_order_release);\n";
+    out << "        written_.notify_one();\n";
+    out << "    }\n";
+    out << "}\n";
+    out << "\n";
+    out << "bool p::TokenPipe::Refill() {\n";
+    out << "    while (true) {\n";
+    out << "        size_t read = read_.load(std::memory_order_relaxed);\n";
+    out << "        if (reading_) {\n";
+    out << "            reading_ = false;\n";
+    out << "            read_.store(++read, std::memory_order_release);\n";
+    out << "            read_.notify_one();\n";
+    out << "        }\n";
+    out << "        if (last_) {\n";
+    out << "            if (error_) {\n";
+    out << "                std::rethrow_exception(error_);\n";
+    out << "            }\n";
+    out << "            return false;\n";
+    out << "        }\n";
+    out << "        size_t written = written_.load(std::memory_order_acquire);\n";
+    out << "        while (written == read) {\n";
+    out << "            written_.wait(written, std::memory_order_acquire);\n";
+    out << "            written = written_.load(std::memory_order_acquire);\n";
+    out << "        }\n";
+    out << "        const Batch &batch = batches_[read % kBatches];\n";
+    out << "        tokens_ = batch.tokens;\n";
+    out << "        index_ = 0;\n";
+    out << "        count_ = batch.count;\n";
+    out << "        reading_ = true;\n";
+    out << "        last_ = batch.last;\n";
+    out << "        if (count_ > 0) {\n";
+    out << "            return true;\n";
+    out << "        }\n";
+    out << "    }\n";
+    out << "}\n";
+    out << "\n";
+    out << "p::TokenStream StreamInput(const char *filename) {\n";
+    out << "    return p::Lexer().StreamFile(filename);\n";
+    out << "}\n";
+    out << "\n";
+    out << "p::LexedInput LexInput(std::string_view buffer) {\n";
+    out << "    return p::Lexer().Lex(buffer);\n";
+    out << "}\n";
+    out << "\n";
+    out << "p::LexedInput LexInput(const char *filename) {\n";
+    out << "    return p::Lexer().LexFile(filename);\n";
+    out << "}\n";
+    out << "\n";
+    out << "std::vector<p::Terminal> Lex(const char *filename) {\n";
+    out << "    p::LexedInput input = LexInput(filename);\n";
+    out << "    std::vector<p::Terminal> tokens;\n";
+    out << "    tokens.reserve(input.tokens.size());\n";
+    out << "    for (const p::LexToken &token : input.tokens) {\n";
+    out << "        tokens.push_back(p::MakeTerminal(token.id, "
+           "input.Lexeme(token)));\n";
+    out << "    }\n";
+    out << "    return tokens;\n";
+    out << "}\n";
     out.close();
 
-    std::string build_lexer_command = "flex --outfile=" + folder_ +
-                                      "/Lexer.cpp " + folder_ +
-                                      "/Lexer.l > /dev/null 2>&1";
-    int result = std::system(build_lexer_command.c_str());
-    if (result != 0) {
-        throw LexerGeneratorError(
-            "Failed to build lexer. Check whether `flex` is installed and "
-            "available in PATH."
+    GenerateFwd();
+}
+
+void LexerGenerator::GenerateSyncBytes(
+    std::ostream &out, const LexerAutomaton &dfa
+) const {
+    std::vector<size_t> counts(256);
+    for (unsigned b = 0; b < 256; ++b) {
+        counts[b] = dfa.CountContinuing(static_cast<unsigned char>(b));
+    }
+    size_t fewest = *std::min_element(counts.begin(), counts.end());
+    std::vector<uint32_t> sync(256);
+    for (unsigned b = 0; b < 256; ++b) {
+        sync[b] = counts[b] == fewest;
+    }
+    out << "// the bytes the fewest states go on with, " << fewest
+        << " of them; a parallel lex\n";
+    out << "// starts its chunks at one\n";
+    out << "constexpr std::uint8_t kSyncBytes[256] = {\n";
+    GenerateArray(out, sync, 4);
+    out << "};\n";
+}
+
+void LexerGenerator::GenerateTableScanner(
+    std::ostream &out, const LexerAutomaton &dfa
+) const {
+    size_t states = dfa.GetStateCount();
+    size_t classes = dfa.GetClassCount();
+    std::vector<uint32_t> accept(states, 0);
+    for (size_t s = 0; s < states; ++s) {
+        if (dfa.GetAccept(s).has_value()) {
+            accept[s] = dfa.GetAccept(s).value() + 1;
+        }
+    }
+
+    out << "// " << states << " states, " << classes << " byte classes\n";
+    out << "constexpr size_t kClassCount = " << classes << ";\n";
+    out << "\n";
+    out << "// the equivalence class of every byte\n";
+    out << "constexpr " << UnsignedType(CombTables::WidthFor(classes - 1))
+        << " kClassOf[256] = {\n";
+    GenerateArray(out, dfa.GetClasses(), 4);
+    out << "};\n";
+    out << "\n";
+    out << "// the next state by state and class, state 0 is the dead state and "
+           "state 1\n";
+    out << "// the start state\n";
+    out << "constexpr " << UnsignedType(CombTables::WidthFor(states - 1))
+        << " kNext[] = {\n";
+    GenerateArray(out, dfa.GetTransitions(), 4);
+    out << "};\n";
+    out << "\n";
+    out << "// the rule the state accepts plus 1, 0 if it doesn't accept\n";
+    out << "constexpr " << UnsignedType(CombTables::WidthFor(rules_.size()))
+        << " kAccept[] = {\n";
+    GenerateArray(out, accept, 4);
+    out << "};\n";
+    out << "\n";
+    out << "// returns the rule of the longest match at `pos` plus 1 (0 if "
+           "nothing\n";
+    out << "// matches) and sets `end` past the match\n";
+    out << "size_t Match(std::string_view input, size_t pos, size_t &end) "
+           "{\n";
+    out << "    size_t rule = 0;\n";
+    out << "    size_t state = 1;\n";
+    out << "    for (size_t i = pos; i < input.size(); ++i) {\n";
+    out << "        state = kNext[state * kClassCount + "
+           "kClassOf[static_cast<unsigned char>(input[i])]];\n";
+    out << "        if (state == 0) {\n";
+    out << "            break;\n";
+    out << "        }\n";
+    bool skips = false;
+    for (size_t s = 0; s < states; ++s) {
+        std::string skip = SkipFunction(dfa, s);
+        if (skip.empty()) {
+            continue;
+        }
+        if (!skips) {
+            out << "        // the loops over a few bytes skip them a block at "
+                   "a time\n";
+            out << "        switch (state) {\n";
+            skips = true;
+        }
+        out << "        case " << s << ":\n";
+        out << "            i = " << skip << "(input, i + 1) - 1;\n";
+        out << "            break;\n";
+    }
+    if (skips) {
+        out << "        }\n";
+    }
+    out << "        if (kAccept[state] != 0) {\n";
+    out << "            rule = kAccept[state];\n";
+    out << "            end = i + 1;\n";
+    out << "        }\n";
+    out << "    }\n";
+    out << "    return rule;\n";
+    out << "}\n";
+}
+
+void LexerGenerator::GenerateKeywords(std::ostream &out) const {
+    SymbolIds symbols(g_);
+    std::vector<std::string> words;
+    size_t max_length = 0;
+    std::vector<bool> lexes(rules_.size() + 1, false);
+    for (const auto &[t, rule] : hashed_) {
+        words.push_back(t.name_);
+        max_length = std::max(max_length, t.name_.size());
+        lexes[rule + 1] = true;
+    }
+    KeywordHash hash(words);
+
+    out << "// the keywords the regex terminals match are lexed by them and "
+           "told apart\n";
+    out << "// by a perfect hash of the lexeme\n";
+    out << "struct Keyword {\n";
+    out << "    // the rule of the regex terminal plus 1\n";
+    out << "    std::uint32_t rule;\n";
+    out << "    std::uint32_t id;\n";
+    out << "    std::string_view text;\n";
+    out << "};\n";
+    out << "\n";
+    out << "constexpr size_t kMaxKeywordLength = " << max_length << ";\n";
+    out << "\n";
+    out << "// whether the rule plus 1 lexes keywords\n";
+    out << "constexpr bool kRuleKeywords[] = {\n";
+    for (size_t r = 0; r < lexes.size(); ++r) {
+        out << (r % 8 == 0 ? "    " : " ") << (lexes[r] ? "true" : "false")
+            << (r + 1 == lexes.size() ? "" : ",");
+        if (r % 8 == 7 || r + 1 == lexes.size()) {
+            out << "\n";
+        }
+    }
+    out << "};\n";
+    out << "\n";
+    out << "// the seed of the slot hash of every bucket\n";
+    out << "constexpr std::uint32_t kKeywordSeeds[] = {\n";
+    GenerateArray(out, hash.GetSeeds(), 4);
+    out << "};\n";
+    out << "\n";
+    out << "constexpr Keyword kKeywords[] = {\n";
+    for (uint32_t slot : hash.GetSlots()) {
+        if (slot == 0) {
+            out << "    {0, 0, {}},\n";
+            continue;
+        }
+        const auto &[t, rule] = hashed_[slot - 1];
+        out << "    {" << rule + 1 << ", " << symbols.GetTerminalId(t)
+            << ", \"" << t.name_ << "\"},\n";
+    }
+    out << "};\n";
+    out << "\n";
+    out << "std::uint64_t HashKeyword(std::string_view s, std::uint64_t seed) "
+           "{\n";
+    out << "    std::uint64_t h = 0xcbf29ce484222325ull ^ (seed * "
+           "0x9e3779b97f4a7c15ull);\n";
+    out << "    for (char c : s) {\n";
+    out << "        h ^= static_cast<unsigned char>(c);\n";
+    out << "        h *= 0x100000001b3ull;\n";
+    out << "    }\n";
+    out << "    h ^= h >> 29;\n";
+    out << "    h *= 0xbf58476d1ce4e5b9ull;\n";
+    out << "    h ^= h >> 32;\n";
+    out << "    return h;\n";
+    out << "}\n";
+    out << "\n";
+    out << "// the terminal id of the match of the rule plus 1, the one of the "
+           "keyword if\n";
+    out << "// the lexeme is one\n";
+    out << "std::uint32_t MatchedTerminal(size_t rule, std::string_view lexeme) "
+           "{\n";
+    out << "    if (!kRuleKeywords[rule] || lexeme.size() > kMaxKeywordLength) "
+           "{\n";
+    out << "        return kRuleTerminal[rule];\n";
+    out << "    }\n";
+    out << "    std::uint64_t seed = kKeywordSeeds[HashKeyword(lexeme, 0) % "
+        << hash.GetSeeds().size() << "];\n";
+    out << "    const Keyword &keyword =\n";
+    out << "        kKeywords[HashKeyword(lexeme, seed) & "
+        << hash.GetSlots().size() - 1 << "];\n";
+    out << "    if (keyword.rule == rule && keyword.text == lexeme) {\n";
+    out << "        return keyword.id;\n";
+    out << "    }\n";
+    out << "    return kRuleTerminal[rule];\n";
+    out << "}\n";
+}
+
+void LexerGenerator::GenerateSkip(std::ostream &out) const {
+    out << "// returns the first position from `i` on with a byte that is "
+           "(kUntil) or\n";
+    out << "// isn't (!kUntil) one of kBytes, or is above 0x7f (kHigh), the "
+           "size of the\n";
+    out << "// input if there is none\n";
+    out << "template <bool kUntil, bool kHigh, unsigned char... kBytes>\n";
+    out << "size_t SkipScalar(std::string_view input, size_t i) {\n";
+    out << "    for (; i < input.size(); ++i) {\n";
+    out << "        unsigned char c = static_cast<unsigned char>(input[i]);\n";
+    out << "        if (kHigh && c >= 0x80) {\n";
+    out << "            return i;\n";
+    out << "        }\n";
+    out << "        if (((c == kBytes) || ...) == kUntil) {\n";
+    out << "            return i;\n";
+    out << "        }\n";
+    out << "    }\n";
+    out << "    return i;\n";
+    out << "}\n";
+    out << "\n";
+    out << "#if defined(__GNUC__) && defined(__SSE2__)\n";
+    out << "template <bool kUntil, bool kHigh, unsigned char... kBytes>\n";
+    out << "size_t SkipSse2(std::string_view input, size_t i) {\n";
+    out << "    for (; i + 16 <= input.size(); i += 16) {\n";
+    out << "        __m128i block = _mm_loadu_si128(\n";
+    out << "            reinterpret_cast<const __m128i *>(input.data() + i)\n";
+    out << "        );\n";
+    out << "        __m128i found = _mm_setzero_si128();\n";
+    out << "        ((found = _mm_or_si128(\n";
+    out << "              found, _mm_cmpeq_epi8(block, "
+           "_mm_set1_epi8(static_cast<char>(kBytes)))\n";
+    out << "          )),\n";
+    out << "         ...);\n";
+    out << "        if (kHigh) {\n";
+    out << "            found = _mm_or_si128(found, block);\n";
+    out << "        }\n";
+    out << "        unsigned mask = static_cast<unsigned>(_mm_movemask_epi8("
+           "found));\n";
+    out << "        if (!kUntil) {\n";
+    out << "            mask ^= 0xffff;\n";
+    out << "        }\n";
+    out << "        if (mask != 0) {\n";
+    out << "            return i + __builtin_ctz(mask);\n";
+    out << "        }\n";
+    out << "    }\n";
+    out << "    return SkipScalar<kUntil, kHigh, kBytes...>(input, i);\n";
+    out << "}\n";
+    out << "\n";
+    out << "template <bool kUntil, bool kHigh, unsigned char... kBytes>\n";
+    out << "__attribute__((target(\"avx2\"))) size_t\n";
+    out << "SkipAvx2(std::string_view input, size_t i) {\n";
+    out << "    for (; i + 32 <= input.size(); i += 32) {\n";
+    out << "        __m256i block = _mm256_loadu_si256(\n";
+    out << "            reinterpret_cast<const __m256i *>(input.data() + i)\n";
+    out << "        );\n";
+    out << "        __m256i found = _mm256_setzero_si256();\n";
+    out << "        ((found = _mm256_or_si256(\n";
+    out << "              found, _mm256_cmpeq_epi8(block, "
+           "_mm256_set1_epi8(static_cast<char>(kBytes)))\n";
+    out << "          )),\n";
+    out << "         ...);\n";
+    out << "        if (kHigh) {\n";
+    out << "            found = _mm256_or_si256(found, block);\n";
+    out << "        }\n";
+    out << "        unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8("
+           "found));\n";
+    out << "        if (!kUntil) {\n";
+    out << "            mask = ~mask;\n";
+    out << "        }\n";
+    out << "        if (mask != 0) {\n";
+    out << "            return i + __builtin_ctz(mask);\n";
+    out << "        }\n";
+    out << "    }\n";
+    out << "    return SkipSse2<kUntil, kHigh, kBytes...>(input, i);\n";
+    out << "}\n";
+    out << "\n";
+    out << "const bool kHasAvx2 = [] {\n";
+    out << "    __builtin_cpu_init();\n";
+    out << "    return __builtin_cpu_supports(\"avx2\") != 0;\n";
+    out << "}();\n";
+    out << "#endif\n";
+    out << "\n";
+    out << "template <bool kUntil, bool kHigh, unsigned char... kBytes>\n";
+    out << "size_t Skip(std::string_view input, size_t i) {\n";
+    out << "#if defined(__GNUC__) && defined(__SSE2__)\n";
+    out << "    if (kHasAvx2) {\n";
+    out << "        return SkipAvx2<kUntil, kHigh, kBytes...>(input, i);\n";
+    out << "    }\n";
+    out << "    return SkipSse2<kUntil, kHigh, kBytes...>(input, i);\n";
+    out << "#else\n";
+    out << "    return SkipScalar<kUntil, kHigh, kBytes...>(input, i);\n";
+    out << "#endif\n";
+    out << "}\n";
+}
+
+void LexerGenerator::GenerateDirectScanner(
+    std::ostream &out, const LexerAutomaton &dfa
+) const {
+    size_t states = dfa.GetStateCount();
+    const std::vector<uint32_t> &classes = dfa.GetClasses();
+    // the byte ranges leading to every state, by state
+    std::vector<std::vector<std::vector<std::pair<unsigned, unsigned>>>>
+        ranges(states, std::vector<std::vector<std::pair<unsigned, unsigned>>>(
+                           states
+                       ));
+    std::vector<bool> targeted(states, false);
+    for (size_t s = 1; s < states; ++s) {
+        for (unsigned b = 0; b < 256; ++b) {
+            size_t t = dfa.GetNext(s, classes[b]);
+            if (t == 0) {
+                continue;
+            }
+            targeted[t] = true;
+            std::vector<std::pair<unsigned, unsigned>> &r = ranges[s][t];
+            if (!r.empty() && r.back().second + 1 == b) {
+                r.back().second = b;
+            } else {
+                r.emplace_back(b, b);
+            }
+        }
+    }
+
+    out << "// " << states << " states, the dead state is left out\n";
+    out << "// returns the rule of the longest match at `pos` plus 1 (0 if "
+           "nothing\n";
+    out << "// matches) and sets `end` past the match\n";
+    out << "size_t Match(std::string_view input, size_t pos, size_t &end) "
+           "{\n";
+    out << "    const unsigned char *const begin =\n";
+    out << "        reinterpret_cast<const unsigned char *>(input.data());\n";
+    out << "    const unsigned char *const limit = begin + input.size();\n";
+    out << "    const unsigned char *p = begin + pos;\n";
+    out << "    size_t rule = 0;\n";
+    out << "    unsigned char c;\n";
+    for (size_t s = 1; s < states; ++s) {
+        if (targeted[s]) {
+            out << "state" << s << ":\n";
+        }
+        std::string skip = SkipFunction(dfa, s);
+        if (!skip.empty()) {
+            out << "    p = begin + " << skip << "(input, p - begin);\n";
+        }
+        if (s != 1 && dfa.GetAccept(s).has_value()) {
+            out << "    rule = " << dfa.GetAccept(s).value() + 1 << ";\n";
+            out << "    end = p - begin;\n";
+        }
+        bool moves = std::any_of(
+            ranges[s].begin(), ranges[s].end(),
+            [](const auto &r) { return !r.empty(); }
         );
+        if (!moves) {
+            out << "    return rule;\n";
+            continue;
+        }
+        out << "    if (p == limit) {\n";
+        out << "        return rule;\n";
+        out << "    }\n";
+        out << "    c = *p++;\n";
+        for (size_t t = 1; t < states; ++t) {
+            if (ranges[s][t].empty()) {
+                continue;
+            }
+            out << "    if (";
+            for (size_t i = 0; i < ranges[s][t].size(); ++i) {
+                auto [lo, hi] = ranges[s][t][i];
+                out << (i == 0 ? "" : " || ");
+                if (lo == 0 && hi == 255) {
+                    out << "true";
+                } else if (lo == hi) {
+                    out << "c == " << ByteLiteral(lo);
+                } else if (lo == 0) {
+                    out << "c <= " << ByteLiteral(hi);
+                } else if (hi == 255) {
+                    out << "c >= " << ByteLiteral(lo);
+                } else if (ranges[s][t].size() == 1) {
+                    out << "c >= " << ByteLiteral(lo) << " && c <= "
+                        << ByteLiteral(hi);
+                } else {
+                    out << "(c >= " << ByteLiteral(lo) << " && c <= "
+                        << ByteLiteral(hi) << ")";
+                }
+            }
+            out << ") {\n";
+            out << "        goto state" << t << ";\n";
+            out << "    }\n";
+        }
+        out << "    return rule;\n";
     }
-    std::filesystem::remove(folder_ + "/Lexer.l");
-    out = std::ofstream(folder_ + "/LexerFwd.hpp");
+    out << "}\n";
+}
+
+void LexerGenerator::GenerateFwd() const {
+    // the same ids the parser tables are built with, they only depend on the
+    // grammar
+    SymbolIds symbols(g_);
+    std::ofstream out(folder_ + "/LexerFwd.hpp");
     out << "#pragma once\n";
     out << "\n";
-    out << "#include \"variant\"\n";
+    out << "#include <atomic>\n";
+    out << "#include <cstddef>\n";
+    out << "#include <cstdint>\n";
+    out << "#include <cstdio>\n";
+    out << "#include <exception>\n";
+    out << "#include <memory>\n";
+    out << "#include <stdexcept>\n";
+    out << "#include <string>\n";
+    out << "#include <string_view>\n";
+    out << "#include <thread>\n";
+    out << "#include <unordered_map>\n";
+    out << "#include <utility>\n";
+    out << "#include <variant>\n";
+    out << "#include <vector>\n";
     out << "\n";
     out << "namespace p {\n";
     out << "struct Terminal {\n";
@@ -134,5 +1122,214 @@ void LexerGenerator::Generate() {
     out << "};\n";
     out << "\n";
     out << "using Token = std::variant<Terminal, NonTerminal>;\n";
+    out << "\n";
+    out << "// the terminals by the id the lexer emits and the parser indexes "
+           "its tables\n";
+    out << "// by, 0 is the end of the input\n";
+    out << "inline constexpr std::uint32_t kTerminalCount = "
+        << symbols.GetTerminalCount() << ";\n";
+    out << "inline constexpr const char *kTerminalNames[kTerminalCount] = {\n";
+    for (size_t t = 0; t < symbols.GetTerminalCount(); ++t) {
+        out << "    \"" << symbols.GetTerminal(t).name_ << "\",\n";
+    }
+    out << "};\n";
+    out << "// the tokens of the regex terminals keep their lexeme in `repr`\n";
+    out << "inline constexpr bool kTerminalIsRegex[kTerminalCount] = {\n";
+    for (size_t t = 0; t < symbols.GetTerminalCount(); ++t) {
+        out << "    " << (symbols.GetTerminal(t).IsRegex() ? "true" : "false")
+            << ",\n";
+    }
+    out << "};\n";
+    out << "\n";
+    out << "// a token as the lexer emits it, the lexeme is `length` bytes of "
+           "the input\n";
+    out << "// at `offset`\n";
+    out << "struct LexToken {\n";
+    out << "    std::uint32_t id;\n";
+    out << "    std::uint32_t length;\n";
+    out << "    std::size_t offset;\n";
+    out << "};\n";
+    out << "\n";
+    out << "// the tokens of an input, which is either a file mapped into "
+           "memory and kept\n";
+    out << "// mapped by `storage` or a buffer owned by the caller\n";
+    out << "struct LexedInput {\n";
+    out << "    std::string_view text;\n";
+    out << "    std::vector<LexToken> tokens;\n";
+    out << "    std::shared_ptr<const void> storage;\n";
+    out << "\n";
+    out << "    std::string_view Lexeme(const LexToken &token) const {\n";
+    out << "        return std::string_view(text).substr(token.offset, "
+           "token.length);\n";
+    out << "    }\n";
+    out << "};\n";
+    out << "\n";
+    out << "// pulls the tokens of an input from the lexer one at a time, "
+           "the input is\n";
+    out << "// like the one of LexedInput\n";
+    out << "class TokenStream {\n";
+    out << "public:\n";
+    out << "    explicit TokenStream(\n";
+    out << "        std::string_view text, std::shared_ptr<const void> storage "
+           "= nullptr\n";
+    out << "    )\n";
+    out << "        : text_(text), storage_(std::move(storage)) {}\n";
+    out << "\n";
+    out << "    // reads the next token, false at the end of the input\n";
+    out << "    bool Next(LexToken &token);\n";
+    out << "\n";
+    out << "    std::string_view GetText() const {\n";
+    out << "        return text_;\n";
+    out << "    }\n";
+    out << "\n";
+    out << "    const std::shared_ptr<const void> &GetStorage() const {\n";
+    out << "        return storage_;\n";
+    out << "    }\n";
+    out << "\n";
+    out << "    // the offset the next token is looked for from\n";
+    out << "    std::size_t GetPosition() const {\n";
+    out << "        return pos_;\n";
+    out << "    }\n";
+    out << "\n";
+    out << "    void Seek(std::size_t pos) {\n";
+    out << "        pos_ = pos;\n";
+    out << "    }\n";
+    out << "\n";
+    out << "private:\n";
+    out << "    std::string_view text_;\n";
+    out << "    std::shared_ptr<const void> storage_;\n";
+    out << "    std::size_t pos_ = 0;\n";
+    out << "};\n";
+    out << "\n";
+    out << "// lexes a stream on its own thread while the tokens are pulled, "
+           "they are\n";
+    out << "// passed in batches through a ring of them. The lexer waits while "
+           "the ring is\n";
+    out << "// full, an exception it throws is thrown by Next() after the "
+           "tokens before it,\n";
+    out << "// and it is stopped if the pipe is destroyed first\n";
+    out << "class TokenPipe {\n";
+    out << "public:\n";
+    out << "    explicit TokenPipe(TokenStream stream);\n";
+    out << "    TokenPipe(const TokenPipe &) = delete;\n";
+    out << "    TokenPipe &operator=(const TokenPipe &) = delete;\n";
+    out << "    ~TokenPipe();\n";
+    out << "\n";
+    out << "    // reads the next token, false at the end of the input\n";
+    out << "    bool Next(LexToken &token) {\n";
+    out << "        if (index_ == count_ && !Refill()) {\n";
+    out << "            return false;\n";
+    out << "        }\n";
+    out << "        token = tokens_[index_++];\n";
+    out << "        return true;\n";
+    out << "    }\n";
+    out << "\n";
+    out << "    std::string_view GetText() const {\n";
+    out << "        return text_;\n";
+    out << "    }\n";
+    out << "\n";
+    out << "    const std::shared_ptr<const void> &GetStorage() const {\n";
+    out << "        return storage_;\n";
+    out << "    }\n";
+    out << "\n";
+    out << "private:\n";
+    out << "    static constexpr std::size_t kBatchSize = 1024;\n";
+    out << "    static constexpr std::size_t kBatches = 16;\n";
+    out << "\n";
+    out << "    struct Batch {\n";
+    out << "        LexToken tokens[kBatchSize];\n";
+    out << "        std::size_t count;\n";
+    out << "        bool last;\n";
+    out << "    };\n";
+    out << "\n";
+    out << "    void Produce(TokenStream stream);\n";
+    out << "    // moves to the next batch, waiting for the lexer if it is "
+           "behind\n";
+    out << "    bool Refill();\n";
+    out << "\n";
+    out << "    std::string_view text_;\n";
+    out << "    std::shared_ptr<const void> storage_;\n";
+    out << "    std::unique_ptr<Batch[]> batches_;\n";
+    out << "    // the batches read and the batches written, each side only "
+           "waits on the\n";
+    out << "    // other one's counter\n";
+    out << "    alignas(64) std::atomic<std::size_t> read_ = 0;\n";
+    out << "    alignas(64) std::atomic<std::size_t> written_ = 0;\n";
+    out << "    std::atomic<bool> stop_ = false;\n";
+    out << "    std::exception_ptr error_;\n";
+    out << "    alignas(64) const LexToken *tokens_ = nullptr;\n";
+    out << "    std::size_t index_ = 0;\n";
+    out << "    std::size_t count_ = 0;\n";
+    out << "    bool reading_ = false;\n";
+    out << "    bool last_ = false;\n";
+    out << "    std::thread thread_;\n";
+    out << "};\n";
+    out << "\n";
+    out << "// thrown when the input can't be read\n";
+    out << "class LexerError : public std::runtime_error {\n";
+    out << "public:\n";
+    out << "    using std::runtime_error::runtime_error;\n";
+    out << "};\n";
+    out << "\n";
+    out << "// the lexer keeps no state besides the one of its streams, every "
+           "thread can\n";
+    out << "// lex with an object of its own; the files and descriptors are "
+           "read from\n";
+    out << "// their offset to the end, the buffers are owned by the caller "
+           "and a path\n";
+    out << "// is only taken by the *File functions\n";
+    out << "class Lexer {\n";
+    out << "public:\n";
+    out << "    TokenStream Stream(std::string_view buffer) const;\n";
+    out << "    TokenStream Stream(int fd) const;\n";
+    out << "    TokenStream Stream(FILE *file) const;\n";
+    out << "    TokenStream StreamFile(const char *filename) const;\n";
+    out << "\n";
+    out << "    LexedInput Lex(std::string_view buffer) const;\n";
+    out << "    LexedInput Lex(int fd) const;\n";
+    out << "    LexedInput Lex(FILE *file) const;\n";
+    out << "    LexedInput LexFile(const char *filename) const;\n";
+    out << "\n";
+    out << "    // lexes chunks of the input on as many threads, the hardware "
+           "threads if 0,\n";
+    out << "    // and gives the same tokens as Lex()\n";
+    out << "    LexedInput LexParallel(std::string_view buffer, unsigned threads "
+           "= 0) const;\n";
+    out << "    LexedInput LexFileParallel(const char *filename, unsigned threads "
+           "= 0)\n";
+    out << "        const;\n";
+    out << "};\n";
+    out << "\n";
+    out << "// the terminal the parse tree holds for a token\n";
+    out << "inline Terminal MakeTerminal(std::uint32_t id, std::string_view "
+           "lexeme) {\n";
+    out << "    if (kTerminalIsRegex[id]) {\n";
+    out << "        return Terminal{kTerminalNames[id], std::string(lexeme)};\n";
+    out << "    }\n";
+    out << "    return Terminal{std::string(lexeme)};\n";
+    out << "}\n";
+    out << "\n";
+    out << "// kTerminalCount if the grammar has no such terminal\n";
+    out << "inline std::uint32_t GetTerminalId(const Terminal &t) {\n";
+    out << "    static const std::unordered_map<std::string, std::uint32_t> "
+           "ids = {\n";
+    for (size_t t = 0; t < symbols.GetTerminalCount(); ++t) {
+        out << "        {\"" << symbols.GetTerminalName(t) << "\", " << t
+            << "},\n";
+    }
+    out << "    };\n";
+    out << "    auto it = ids.find((t.repr.empty() ? \"T_\" : \"R_\") + "
+           "t.name);\n";
+    out << "    if (it == ids.end()) {\n";
+    out << "        return kTerminalCount;\n";
+    out << "    }\n";
+    out << "    return it->second;\n";
+    out << "}\n";
     out << "};  // namespace p\n";
-}
\ No newline at end of file
+    out << "\n";
+    out << "// the same as the ones of p::Lexer, they throw p::LexerError\n";
+    out << "p::LexedInput LexInput(const char *filename);\n";
+    out << "p::LexedInput LexInput(std::string_view buffer);\n";
+    out << "p::TokenStream StreamInput(const char *filename);\n";
+    out << "std::vector<p::Terminal> Lex(const char *filename);\n";
+}
@@ -1,9 +1,43 @@
 #include "ParserGenerator.h"
 
+#include <algorithm>
 #include <fstream>
 #include <iostream>
+#include <map>
+#include <optional>
 
+#include "CodegenHelpers.h"
 #include "Helpers.h"
+#include "LayoutProfile.h"
+#include "TableBundle.h"
+
+namespace {
+/**
+ * @brief Returns the expression constructing the action in the generated code.
+ */
+std::string ActionLiteral(const Action &a) {
+    std::string type;
+    switch (a.type_) {
+        case ActionType::ACCEPT:
+            type = "ACCEPT";
+            break;
+        case ActionType::ERROR:
+            type = "ERROR";
+            break;
+        case ActionType::REDUCE:
+            type = "REDUCE";
+            break;
+        case ActionType::SHIFT:
+            type = "SHIFT";
+            break;
+        case ActionType::SHIFT_REDUCE:
+            type = "SHIFT_REDUCE";
+            break;
+    }
+    return "Action{ActionType::" + type + ", " + std::to_string(a.value_) +
+           "}";
+}
+}  // namespace
 
 ParserGeneratorError::ParserGeneratorError(const std::string &msg) : msg_(msg) {
 }
@@ -13,24 +47,93 @@ const char *ParserGeneratorError::what() const noexcept {
 }
 
 ParserGenerator::ParserGenerator(
-    const std::string &folder, const Grammar &g, const ActionTable &at,
-    const GotoTable &gt, const FollowSets &fs, bool add_json_generator,
-    size_t json_indents
+    const std::string &folder, const Grammar &g, const DenseTables &tables,
+    const FollowSets &fs, bool add_json_generator, size_t json_indents,
+    const CombTables *comb, bool bundle, bool profile,
+    std::vector<Expression> expressions
+)
+    : folder_(folder),
+      g_(g),
+      tables_(&tables),
+      comb_(comb),
+      fs_(fs),
+      add_json_generator_(add_json_generator),
+      json_indents_(json_indents),
+      bundle_(bundle),
+      profile_(profile),
+      expressions_(std::move(expressions)) {
+}
+
+ParserGenerator::ParserGenerator(
+    const std::string &folder, const Grammar &g, const PredictTable &pt,
+    const FollowSets &fs, bool add_json_generator, size_t json_indents
 )
     : folder_(folder),
       g_(g),
-      at_(at),
-      gt_(gt),
+      pt_(&pt),
       fs_(fs),
       add_json_generator_(add_json_generator),
       json_indents_(json_indents) {
 }
 
 void ParserGenerator::Generate() {
+    if (tables_ != nullptr) {
+        // the lexer numbers the terminals from the grammar alone
+        SymbolIds lexer_ids(g_);
+        const SymbolIds &ids = tables_->symbols_;
+        bool same = ids.GetTerminalCount() == lexer_ids.GetTerminalCount();
+        for (size_t t = 0; same && t < ids.GetTerminalCount(); ++t) {
+            same = ids.GetTerminalName(t) == lexer_ids.GetTerminalName(t);
+        }
+        if (!same) {
+            throw ParserGeneratorError(
+                "The tables number the terminals differently from the lexer"
+            );
+        }
+    }
     std::ofstream out(folder_ + "/Parser.hpp");
+    GeneratePrelude(out);
+    if (pt_ != nullptr) {
+        GenerateLLTables(out);
+    } else {
+        GenerateLRTables(out);
+    }
+    GenerateParseTree(out);
+    if (pt_ != nullptr) {
+        GenerateLLParser(out);
+    } else {
+        GenerateLRParser(out);
+    }
+    out << "};  // namespace p\n";
+    out.close();
+
+    if (bundle_) {
+        try {
+            TableBundle(g_, *tables_, fs_).Write(folder_ + "/tables.bin");
+        } catch (const TableBundleError &e) {
+            throw ParserGeneratorError(e.what());
+        }
+        std::ofstream bundle_out(folder_ + "/BundleParser.hpp");
+        GenerateBundleParser(bundle_out);
+    }
+}
+
+void ParserGenerator::GeneratePrelude(std::ostream &out, bool bundle_runtime)
+    const {
     out << "#pragma once\n";
     out << "\n";
+    if (bundle_runtime) {
+        out << "#include <fcntl.h>\n";
+        out << "#include <sys/mman.h>\n";
+        out << "#include <sys/stat.h>\n";
+        out << "#include <unistd.h>\n";
+        out << "\n";
+    }
     out << "#include <algorithm>\n";
+    out << "#include <cstdint>\n";
+    if (bundle_runtime) {
+        out << "#include <cstring>\n";
+    }
     out << "#include <iostream>\n";
     out << "#include <fstream>\n";
     out << "#include <memory>\n";
@@ -39,9 +142,15 @@ void ParserGenerator::Generate() {
     }
     out << "#include <ranges>\n";
     out << "#include <set>\n";
+    if (bundle_runtime) {
+        out << "#include <span>\n";
+    }
     out << "#include <stack>\n";
     out << "#include <stdexcept>\n";
     out << "#include <string>\n";
+    if (bundle_runtime) {
+        out << "#include <string_view>\n";
+    }
     out << "#include <unordered_map>\n";
     out << "#include <variant>\n";
     out << "#include <vector>\n";
@@ -90,11 +199,18 @@ void ParserGenerator::Generate() {
     out << "\n";
     out << "using Grammar = std::vector<Rule>;\n";
     out << "\n";
+    out << "using FollowSet = std::set<Terminal>;\n";
+    out << "using FollowSets = std::unordered_map<NonTerminal, FollowSet>;\n";
+    out << "\n";
+}
+
+void ParserGenerator::GenerateActionType(std::ostream &out) const {
     out << "enum class ActionType {\n";
     out << "    SHIFT,\n";
     out << "    REDUCE,\n";
     out << "    ACCEPT,\n";
-    out << "    ERROR\n";
+    out << "    ERROR,\n";
+    out << "    SHIFT_REDUCE\n";
     out << "};\n";
     out << "\n";
     out << "struct Action {\n";
@@ -102,46 +218,57 @@ void ParserGenerator::Generate() {
     out << "    size_t value = 0;\n";
     out << "};\n";
     out << "\n";
-    out << "using ActionTable = std::vector<std::unordered_map<std::string, "
+}
+
+void ParserGenerator::GenerateLRTables(std::ostream &out) const {
+    GenerateActionType(out);
+    if (comb_ != nullptr) {
+        GenerateCombTables(out);
+    } else {
+        GenerateMapTables(out);
+    }
+    GenerateUnitChains(out);
+    GenerateFollowSets(out);
+}
+
+void ParserGenerator::GenerateMapTables(std::ostream &out) const {
+    out << "using ActionTable = std::vector<std::unordered_map<size_t, "
            "Action>>;\n";
     out << "using GotoTable = std::unordered_map<size_t, "
            "std::unordered_map<NonTerminal, size_t>>;\n";
-    out << "using FollowSet = std::set<Terminal>;\n";
-    out << "using FollowSets = std::unordered_map<NonTerminal, FollowSet>;\n";
-    out << "\n";
     out << "class ParserTables {\n";
     out << "public:\n";
+    const SymbolIds &symbols = tables_->symbols_;
+    const DenseActionTable &action = tables_->action_;
+    const DenseGotoTable &goto_table = tables_->goto_;
     out << "    static const ActionTable &GetActionTable() {\n";
     out << "        static const ActionTable table = {\n";
-    for (size_t i = 0; i < at_.size(); ++i) {
+    for (size_t i = 0; i < action.GetStateCount(); ++i) {
         out << "            {\n";
+        // the terminals sharing a column get an entry each
+        std::vector<DenseActionTable::Cell> row;
+        for (size_t t = 0; t < symbols.GetTerminalCount(); ++t) {
+            row.push_back(action.GetRow(i)[tables_->GetTerminalColumn(t)]);
+        }
+        size_t count = std::count_if(row.begin(), row.end(), [](auto cell) {
+            return cell != 0;
+        });
         size_t j = 0;
-        for (const auto &[terminal, action] : at_[i]) {
-            out << "                ";
-            out << "{\"" << terminal << "\", Action{ActionType::";
-            switch (action.type_) {
-                case ActionType::ACCEPT:
-                    out << "ACCEPT";
-                    break;
-                case ActionType::ERROR:
-                    out << "ERROR";
-                    break;
-                case ActionType::REDUCE:
-                    out << "REDUCE";
-                    break;
-                case ActionType::SHIFT:
-                    out << "SHIFT";
-                    break;
+        for (size_t t = 0; t < row.size(); ++t) {
+            if (row[t] == 0) {
+                continue;
             }
-            out << ", " << action.value_ << "}}";
-            if (j != at_[i].size() - 1) {
+            Action a = DenseActionTable::Decode(row[t]);
+            out << "                ";
+            out << "{" << t << ", " << ActionLiteral(a) << "}";
+            if (j != count - 1) {
                 out << ",";
             }
             ++j;
-            out << "\n";
+            out << "  // " << symbols.GetTerminalName(t) << "\n";
         }
         out << "            }";
-        if (i != at_.size() - 1) {
+        if (i != action.GetStateCount() - 1) {
             out << ",";
         }
         out << "\n";
@@ -153,29 +280,238 @@ void ParserGenerator::Generate() {
     out << "\n";
     out << "    static const GotoTable &GetGotoTable() {\n";
     out << "        static const GotoTable table = {\n";
-    for (const auto &[state, table] : gt_) {
-        size_t nonzero_count = 0;
-        for (const auto &[terminal, goto_value] : table) {
-            if (goto_value != 0) {
-                ++nonzero_count;
-            }
-        }
-        if (nonzero_count == 0) {
+    for (size_t i = 0; i < goto_table.GetStateCount(); ++i) {
+        std::span<const DenseGotoTable::Cell> row = goto_table.GetRow(i);
+        size_t count = std::count_if(row.begin(), row.end(), [](auto cell) {
+            return cell != DenseGotoTable::kNone;
+        });
+        if (count == 0) {
             continue;
         }
         out << "            ";
         out << "{\n";
         out << "                ";
-        out << state << ", {\n";
+        out << i << ", {\n";
         size_t j = 0;
-        for (const auto &[terminal, goto_value] : table) {
-            if (goto_value == 0) {
+        for (size_t nt = 0; nt < row.size(); ++nt) {
+            if (row[nt] == DenseGotoTable::kNone) {
+                continue;
+            }
+            out << "                    ";
+            out << "{NonTerminal{\"" << symbols.GetNonTerminal(nt).name_
+                << "\"}, " << row[nt] << "}";
+            if (j != count - 1) {
+                out << ",";
+            }
+            ++j;
+            out << "\n";
+        }
+        out << "                }\n";
+        out << "            },\n";
+    }
+    out << "        };\n";
+    out << "\n";
+    out << "        return table;\n";
+    out << "    }\n";
+    out << "\n";
+    out << "    using Lookahead = size_t;\n";
+    out << "\n";
+    out << "    static Lookahead GetLookahead(std::uint32_t id) {\n";
+    out << "        return id;\n";
+    out << "    }\n";
+    out << "\n";
+    out << "    static const std::unordered_map<size_t, Action> "
+           "&GetDefaultTable() {\n";
+    out << "        static const std::unordered_map<size_t, Action> table = "
+           "{\n";
+    for (size_t i = 0; i < action.GetStateCount(); ++i) {
+        if (action.GetDefault(i).type_ != ActionType::ERROR) {
+            out << "            {" << i << ", "
+                << ActionLiteral(action.GetDefault(i)) << "},\n";
+        }
+    }
+    out << "        };\n";
+    out << "\n";
+    out << "        return table;\n";
+    out << "    }\n";
+    out << "\n";
+    out << "    static Action GetDefault(size_t state) {\n";
+    out << "        if (!GetActionTable()[state].empty()) {\n";
+    out << "            return Action{ActionType::ERROR};\n";
+    out << "        }\n";
+    out << "        auto it = GetDefaultTable().find(state);\n";
+    out << "        if (it == GetDefaultTable().end()) {\n";
+    out << "            return Action{ActionType::ERROR};\n";
+    out << "        }\n";
+    out << "        return it->second;\n";
+    out << "    }\n";
+    out << "\n";
+    out << "    static Action GetAction(size_t state, Lookahead a) {\n";
+    out << "        const auto &row = GetActionTable()[state];\n";
+    out << "        auto it = row.find(a);\n";
+    out << "        if (it == row.end()) {\n";
+    out << "            auto def = GetDefaultTable().find(state);\n";
+    out << "            if (def == GetDefaultTable().end()) {\n";
+    out << "                return Action{ActionType::ERROR};\n";
+    out << "            }\n";
+    out << "            return def->second;\n";
+    out << "        }\n";
+    out << "        return it->second;\n";
+    out << "    }\n";
+    out << "\n";
+    out << "    static size_t GetGoto(size_t state, size_t rule) {\n";
+    out << "        static const std::vector<NonTerminal> lhs = {\n";
+    for (const Rule &rule : g_.rules_) {
+        out << "            NonTerminal{\"" << rule.lhs.name_ << "\"},\n";
+    }
+    out << "        };\n";
+    out << "        return GetGotoTable().at(state).at(lhs[rule]);\n";
+    out << "    }\n";
+    out << "\n";
+}
+
+void ParserGenerator::GenerateCombTables(std::ostream &out) const {
+    const SymbolIds &symbols = tables_->symbols_;
+    std::vector<uint32_t> rule_columns;
+    for (const Rule &rule : g_.rules_) {
+        rule_columns.push_back(static_cast<uint32_t>(
+            comb_->GetTerminalCount() + symbols.GetNonTerminalId(rule.lhs)
+        ));
+    }
+    uint32_t max_column = rule_columns.empty()
+                              ? 0
+                              : *std::max_element(
+                                    rule_columns.begin(), rule_columns.end()
+                                );
+
+    out << "class ParserTables {\n";
+    out << "public:\n";
+    out << "    using Lookahead = size_t;\n";
+    out << "\n";
+    out << "    static constexpr size_t kTerminalColumns = "
+        << comb_->GetTerminalCount() << ";\n";
+    out << "    static constexpr size_t kTableSize = "
+        << comb_->GetNext().size() << ";\n";
+    out << "\n";
+    out << "    static constexpr " << UnsignedType(comb_->GetBaseWidth())
+        << " kBase[] = {\n";
+    GenerateArray(out, comb_->GetBase(), 8);
+    out << "    };\n";
+    out << "    static constexpr " << UnsignedType(comb_->GetNextWidth())
+        << " kNext[kTableSize] = {\n";
+    GenerateArray(out, comb_->GetNext(), 8);
+    out << "    };\n";
+    out << "    static constexpr " << UnsignedType(comb_->GetCheckWidth())
+        << " kCheck[kTableSize] = {\n";
+    GenerateArray(out, comb_->GetCheck(), 8);
+    out << "    };\n";
+    out << "    static constexpr "
+        << UnsignedType(CombTables::WidthFor(max_column))
+        << " kRuleColumn[] = {\n";
+    GenerateArray(out, rule_columns, 8);
+    out << "    };\n";
+    out << "    static constexpr " << UnsignedType(comb_->GetDefaultWidth())
+        << " kDefault[] = {\n";
+    GenerateArray(out, comb_->GetDefaults(), 8);
+    out << "    };\n";
+    out << "    static constexpr std::uint8_t kDefaultOnly[] = {\n";
+    GenerateArray(out, comb_->GetDefaultOnly(), 8);
+    out << "    };\n";
+    out << "    static constexpr "
+        << UnsignedType(CombTables::WidthFor(comb_->GetTerminalCount()))
+        << " kTerminalClass[] = {\n";
+    GenerateArray(out, comb_->GetTerminalClasses(), 8);
+    out << "    };\n";
+    out << "\n";
+    out << "    static Lookahead GetLookahead(std::uint32_t id) {\n";
+    out << "        if (id >= kTerminalCount) {\n";
+    out << "            return kTerminalColumns;\n";
+    out << "        }\n";
+    out << "        return kTerminalClass[id];\n";
+    out << "    }\n";
+    out << "\n";
+    out << "    static Action Decode(std::uint32_t cell) {\n";
+    out << "        if (cell == 0) {\n";
+    out << "            return Action{ActionType::ERROR};\n";
+    out << "        }\n";
+    out << "        return Action{\n";
+    out << "            static_cast<ActionType>((cell & "
+        << ((1u << DenseActionTable::kTypeBits) - 1) << "u) - 1),\n";
+    out << "            static_cast<size_t>(cell >> "
+        << DenseActionTable::kTypeBits << ")\n";
+    out << "        };\n";
+    out << "    }\n";
+    out << "\n";
+    out << "    static Action GetDefault(size_t state) {\n";
+    out << "        if (!kDefaultOnly[state]) {\n";
+    out << "            return Action{ActionType::ERROR};\n";
+    out << "        }\n";
+    out << "        return Decode(kDefault[state]);\n";
+    out << "    }\n";
+    out << "\n";
+    out << "    static Action GetAction(size_t state, Lookahead a) {\n";
+    out << "        size_t i = kBase[state] + a;\n";
+    out << "        if (a >= kTerminalColumns || i >= kTableSize || kCheck[i] != "
+           "state) {\n";
+    out << "            return Decode(kDefault[state]);\n";
+    out << "        }\n";
+    out << "        return Decode(kNext[i]);\n";
+    out << "    }\n";
+    out << "\n";
+    out << "    static size_t GetGoto(size_t state, size_t rule) {\n";
+    out << "        return kNext[kBase[state] + kRuleColumn[rule]];\n";
+    out << "    }\n";
+    out << "\n";
+}
+
+void ParserGenerator::GenerateUnitChains(std::ostream &out) const {
+    if (tables_->unit_chains_.empty()) {
+        return;
+    }
+    const SymbolIds &symbols = tables_->symbols_;
+    size_t rules = g_.rules_.size();
+    // keyed by the state and the rule whose goto was redirected, so no name
+    // is compared on a reduction
+    out << "    static const std::vector<NonTerminal> *GetCollapsed(size_t "
+           "state, size_t rule) {\n";
+    out << "        static const std::unordered_map<size_t, "
+           "std::vector<NonTerminal>> chains = {\n";
+    for (const auto &[key, chain] : tables_->unit_chains_) {
+        for (size_t r = 0; r < rules; ++r) {
+            if (symbols.GetNonTerminalId(g_[r].lhs) != key.second) {
                 continue;
             }
+            out << "            {" << key.first * rules + r << ", {";
+            for (size_t i = 0; i < chain.size(); ++i) {
+                out << (i == 0 ? "" : ", ") << "NonTerminal{\""
+                    << symbols.GetNonTerminal(chain[i]).name_ << "\"}";
+            }
+            out << "}},\n";
+        }
+    }
+    out << "        };\n";
+    out << "        auto it = chains.find(state * " << rules << " + rule);\n";
+    out << "        return it == chains.end() ? nullptr : &it->second;\n";
+    out << "    }\n";
+    out << "\n";
+}
+
+void ParserGenerator::GenerateLLTables(std::ostream &out) const {
+    out << "using PredictTable = std::unordered_map<NonTerminal, "
+           "std::unordered_map<std::string, size_t>>;\n";
+    out << "\n";
+    out << "class ParserTables {\n";
+    out << "public:\n";
+    out << "    static const PredictTable &GetPredictTable() {\n";
+    out << "        static const PredictTable table = {\n";
+    for (const auto &[nt, row] : *pt_) {
+        out << "            {\n";
+        out << "                NonTerminal{\"" << nt.name_ << "\"}, {\n";
+        size_t j = 0;
+        for (const auto &[terminal, rule_number] : row) {
             out << "                    ";
-            out << "{NonTerminal{\"" << terminal.name_ << "\"}, " << goto_value
-                << "}";
-            if (j != table.size() - 1) {
+            out << "{\"" << terminal << "\", " << rule_number << "}";
+            if (j != row.size() - 1) {
                 out << ",";
             }
             ++j;
@@ -189,6 +525,10 @@ void ParserGenerator::Generate() {
     out << "        return table;\n";
     out << "    }\n";
     out << "\n";
+    GenerateFollowSets(out);
+}
+
+void ParserGenerator::GenerateFollowSets(std::ostream &out) const {
     out << "    static const FollowSet GetFollowSetFor(const NonTerminal &nt) "
            "{\n";
     out << "        return GetFollowSets().at(nt);\n";
@@ -197,7 +537,16 @@ void ParserGenerator::Generate() {
     out << "private:\n";
     out << "    static const FollowSets GetFollowSets() {\n";
     out << "        static const FollowSets table = {\n";
-    for (const auto &[nt, follow_set] : fs_) {
+    // the sets are emitted in the order of the ids, the map may have been
+    // filled in any order, e.g. when loaded from the generation cache
+    SymbolIds ids(g_);
+    for (size_t i = 0; i < ids.GetNonTerminalCount(); ++i) {
+        const NonTerminal &nt = ids.GetNonTerminal(i);
+        auto it = fs_.find(nt);
+        if (it == fs_.end()) {
+            continue;
+        }
+        const std::set<Terminal> &follow_set = it->second;
         out << "            ";
         out << "{NonTerminal{\"" << nt.name_ << "\"}, {\n";
         size_t j = 0;
@@ -221,10 +570,14 @@ void ParserGenerator::Generate() {
     out << "    }\n";
     out << "};\n";
     out << "\n";
+}
+
+void ParserGenerator::GenerateParseTree(std::ostream &out) const {
     out << "class ParseTreePreorderVisitor {\n";
     out << "public:\n";
     out << "    virtual void VisitTerminal(const Terminal &t) = 0;\n";
     out << "    virtual void VisitNonTerminal(const NonTerminal &nt) = 0;\n";
+    GenerateLexemeVisit(out);
     out << "    virtual ~ParseTreePreorderVisitor() = default;\n";
     out << "};\n";
     out << "\n";
@@ -232,17 +585,22 @@ void ParserGenerator::Generate() {
     out << "public:\n";
     out << "    virtual void VisitTerminal(const Terminal &t) = 0;\n";
     out << "    virtual void VisitNonTerminal(const NonTerminal &nt) = 0;\n";
+    GenerateLexemeVisit(out);
     out << "    virtual ~ParseTreePostorderVisitor() = default;\n";
     out << "};\n";
     out << "\n";
     out << "struct ParseTreeNode {\n";
     out << "    Token value;\n";
     out << "    std::vector<std::shared_ptr<ParseTreeNode>> children;\n";
+    out << "    // the lexeme of a regex terminal parsed from a LexedInput, a "
+           "view into its\n";
+    out << "    // text, `value` then only holds the name of the terminal\n";
+    out << "    std::string_view lexeme = {};\n";
     out << "\n";
     out << "    void Accept(ParseTreePreorderVisitor &visitor) const "
            "{\n";
     out << "        if (std::holds_alternative<p::Terminal>(value)) {\n";
-    out << "            visitor.VisitTerminal(std::get<Terminal>(value));\n";
+    out << "            VisitTerminal(visitor);\n";
     out << "        } else {\n";
     out << "            "
            "visitor.VisitNonTerminal(std::get<NonTerminal>(value));\n";
@@ -257,18 +615,34 @@ void ParserGenerator::Generate() {
     out << "            child->Accept(visitor);\n";
     out << "        }\n";
     out << "        if (std::holds_alternative<p::Terminal>(value)) {\n";
-    out << "            visitor.VisitTerminal(std::get<Terminal>(value));\n";
+    out << "            VisitTerminal(visitor);\n";
     out << "        } else {\n";
     out << "            "
            "visitor.VisitNonTerminal(std::get<NonTerminal>(value));\n";
     out << "        }\n";
     out << "    }\n";
+    out << "\n";
+    out << "private:\n";
+    out << "    template <typename Visitor>\n";
+    out << "    void VisitTerminal(Visitor &visitor) const {\n";
+    out << "        if (lexeme.empty()) {\n";
+    out << "            visitor.VisitTerminal(std::get<Terminal>(value));\n";
+    out << "        } else {\n";
+    out << "            visitor.VisitLexeme(std::get<Terminal>(value), "
+           "lexeme);\n";
+    out << "        }\n";
+    out << "    }\n";
     out << "};\n";
     out << "\n";
     out << "class ParseTree {\n";
     out << "public:\n";
-    out << "    explicit ParseTree(std::shared_ptr<ParseTreeNode> root) : "
-           "root_(root) {}\n";
+    out << "    // `storage` keeps the input the lexemes of the tree point "
+           "into alive\n";
+    out << "    explicit ParseTree(\n";
+    out << "        std::shared_ptr<ParseTreeNode> root,\n";
+    out << "        std::shared_ptr<const void> storage = nullptr\n";
+    out << "    )\n";
+    out << "        : root_(root), storage_(std::move(storage)) {}\n";
     out << "\n";
     out << "    std::shared_ptr<ParseTreeNode> GetRoot() const {\n";
     out << "        return root_;\n";
@@ -284,6 +658,7 @@ void ParserGenerator::Generate() {
     out << "\n";
     out << "private:\n";
     out << "    std::shared_ptr<ParseTreeNode> root_;\n";
+    out << "    std::shared_ptr<const void> storage_;\n";
     out << "};\n";
     out << "\n";
     if (add_json_generator_) {
@@ -310,6 +685,8 @@ void ParserGenerator::Generate() {
         out << "            tree[\"value\"] = t.name;\n";
         out << "            if (!t.repr.empty()) {\n";
         out << "                tree[\"lexeme\"] = t.repr;\n";
+        out << "            } else if (!node->lexeme.empty()) {\n";
+        out << "                tree[\"lexeme\"] = std::string(node->lexeme);\n";
         out << "            }\n";
         out << "        } else {\n";
         out << "            tree[\"type\"] = "
@@ -329,68 +706,292 @@ void ParserGenerator::Generate() {
         out << "};\n";
         out << "\n";
     }
+}
+
+void ParserGenerator::GenerateLexemeVisit(std::ostream &out) const {
+    out << "    // called instead of VisitTerminal() for the regex terminals "
+           "whose lexeme is\n";
+    out << "    // a view into the input, see ParseTreeNode::lexeme\n";
+    out << "    virtual void VisitLexeme(const Terminal &t, std::string_view "
+           "lexeme) {\n";
+    out << "        VisitTerminal(Terminal{t.name, std::string(lexeme)});\n";
+    out << "    }\n";
+}
+
+void ParserGenerator::GenerateLRParser(std::ostream &out) const {
     out << "class Parser {\n";
     out << "public:\n";
     out << "    int Parse(const std::vector<Terminal> &stream) {\n";
+    out << "        converted_text_.clear();\n";
+    out << "        converted_.tokens.clear();\n";
+    out << "        for (const Terminal &t : stream) {\n";
+    out << "            const std::string &lexeme = t.repr.empty() ? t.name : "
+           "t.repr;\n";
+    out << "            converted_.tokens.push_back(LexToken{\n";
+    out << "                GetTerminalId(t), "
+           "static_cast<std::uint32_t>(lexeme.size()),\n";
+    out << "                converted_text_.size()\n";
+    out << "            });\n";
+    out << "            converted_text_ += lexeme;\n";
+    out << "        }\n";
+    out << "        converted_.text = converted_text_;\n";
+    out << "        return Parse(converted_);\n";
+    out << "    }\n";
+    out << "\n";
+    out << "    // the tables are indexed by the terminal ids of the tokens, a "
+           "terminal\n";
+    out << "    // is only built for the tree when its token is shifted. The "
+           "lexemes of the\n";
+    out << "    // regex terminals stay views into the input, the tree keeps "
+           "a mapped file\n";
+    out << "    // mapped, a buffer of the caller has to outlive it\n";
+    out << "    int Parse(const LexedInput &input) {\n";
     out << "        Clear();\n";
-    out << "        for (const Terminal &token : stream | std::views::reverse) "
-           "{\n";
-    out << "            seq_.push(token);\n";
+    out << "        input_ = &input;\n";
+    out << "        text_ = input.text;\n";
+    out << "        // the converted stream is overwritten by the next call\n";
+    out << "        views_ = &input != &converted_;\n";
+    out << "        storage_ = views_ ? input.storage : nullptr;\n";
+    out << "        Load();\n";
+    out << "        return Run();\n";
+    out << "    }\n";
+    out << "\n";
+    out << "    // pulls the tokens from the lexer while parsing, the lexemes are "
+           "kept like\n";
+    out << "    // in Parse(const LexedInput &)\n";
+    out << "    int Parse(TokenStream &tokens) {\n";
+    out << "        Clear();\n";
+    out << "        stream_ = &tokens;\n";
+    out << "        text_ = tokens.GetText();\n";
+    out << "        views_ = true;\n";
+    out << "        storage_ = tokens.GetStorage();\n";
+    out << "        Load();\n";
+    out << "        return Run();\n";
+    out << "    }\n";
+    out << "\n";
+    out << "    // the same with the lexer running on another thread\n";
+    out << "    int Parse(TokenPipe &tokens) {\n";
+    out << "        Clear();\n";
+    out << "        pipe_ = &tokens;\n";
+    out << "        text_ = tokens.GetText();\n";
+    out << "        views_ = true;\n";
+    out << "        storage_ = tokens.GetStorage();\n";
+    out << "        Load();\n";
+    out << "        return Run();\n";
+    out << "    }\n";
+    out << "\n";
+    out << "    ParseTree GetParseTree() const {\n";
+    out << "        return ParseTree(node_stack_.top(), storage_);\n";
+    out << "    }\n";
+    out << "\n";
+    if (profile_) {
+        GenerateProfileWriter(out);
+    }
+    out << "private:\n";
+    GenerateLRLoop(out);
+    out << "    // `fused` is set for SHIFT_REDUCE, which doesn't push a state for "
+           "the\n";
+    out << "    // shifted terminal\n";
+    if (!expressions_.empty()) {
+        out << "    // returns whether the sub-parser of an expression consumed "
+               "input\n";
+    }
+    out << "    " << (expressions_.empty() ? "void" : "bool")
+        << " Reduce(size_t rule_number, bool fused) {\n";
+    out << "        const Rule &rule = g_[rule_number];\n";
+    out << "        std::vector<std::shared_ptr<ParseTreeNode>> new_children;\n";
+    out << "        if (QualName(rule.prod[0]) != \"T_\") {\n";
+    out << "            for (size_t i = 0; i < rule.prod.size(); ++i) {\n";
+    out << "                new_children.push_back(node_stack_.top());\n";
+    out << "                node_stack_.pop();\n";
+    out << "                if (i != 0 || !fused) {\n";
+    out << "                    state_stack_.pop();\n";
+    out << "                }\n";
+    out << "            }\n";
     out << "        }\n";
-    out << "    \n";
-    out << "        Terminal a = seq_.top();\n";
+    out << "        std::reverse(new_children.begin(), new_children.end());\n";
+    out << "        auto new_node = "
+           "std::make_shared<ParseTreeNode>(ParseTreeNode{rule.lhs, "
+           "new_children});\n";
+    out << "        size_t t = state_stack_.top();\n";
+    if (expressions_.empty()) {
+        GenerateGotoPush(out);
+    } else {
+        out << "        return Goto(t, rule_number, new_node);\n";
+    }
+    out << "    }\n";
+    out << "\n";
+    if (!expressions_.empty()) {
+        GenerateClimbing(out);
+    }
+    out << "    // reads the current token from the input or the lexer, the end "
+           "of the\n";
+    out << "    // input is right past the last one\n";
+    out << "    void Load() {\n";
+    out << "        if (stream_ != nullptr) {\n";
+    out << "            at_end_ = !stream_->Next(token_);\n";
+    out << "        } else if (pipe_ != nullptr) {\n";
+    out << "            at_end_ = !pipe_->Next(token_);\n";
+    out << "        } else {\n";
+    out << "            at_end_ = pos_ >= input_->tokens.size();\n";
+    out << "            if (!at_end_) {\n";
+    out << "                token_ = input_->tokens[pos_];\n";
+    out << "            }\n";
+    out << "        }\n";
+    out << "        if (at_end_) {\n";
+    out << "            token_ = LexToken{0, 0, text_.size()};\n";
+    out << "        }\n";
+    out << "    }\n";
+    out << "\n";
+    out << "    // the error recovery may skip the end of the input too\n";
+    out << "    void Advance() {\n";
+    out << "        if (at_end_) {\n";
+    out << "            past_end_ = true;\n";
+    out << "            return;\n";
+    out << "        }\n";
+    out << "        ++pos_;\n";
+    out << "        Load();\n";
+    out << "    }\n";
+    out << "\n";
+    out << "    std::uint32_t Current() const {\n";
+    out << "        return token_.id;\n";
+    out << "    }\n";
+    out << "\n";
+    out << "    std::string_view Lexeme() const {\n";
+    out << "        if (at_end_) {\n";
+    out << "            return \"$\";\n";
+    out << "        }\n";
+    out << "        return text_.substr(token_.offset, token_.length);\n";
+    out << "    }\n";
+    out << "\n";
+    out << "    std::shared_ptr<ParseTreeNode> Shifted(std::uint32_t a) const {\n";
+    out << "        if (views_ && kTerminalIsRegex[a]) {\n";
+    out << "            return std::make_shared<ParseTreeNode>(\n";
+    out << "                ParseTreeNode{Terminal{kTerminalNames[a]}, {}, "
+           "Lexeme()}\n";
+    out << "            );\n";
+    out << "        }\n";
+    out << "        return std::make_shared<ParseTreeNode>(\n";
+    out << "            ParseTreeNode{MakeTerminal(a, Lexeme()), {}}\n";
+    out << "        );\n";
+    out << "    }\n";
+    out << "\n";
+    out << "    void Clear() {\n";
+    out << "        input_ = nullptr;\n";
+    out << "        stream_ = nullptr;\n";
+    out << "        pipe_ = nullptr;\n";
+    out << "        pos_ = 0;\n";
+    out << "        at_end_ = false;\n";
+    out << "        past_end_ = false;\n";
+    out << "        while (!state_stack_.empty()) {\n";
+    out << "            state_stack_.pop();\n";
+    out << "        }\n";
+    out << "        state_stack_.push(0);\n";
+    out << "        while (!node_stack_.empty()) {\n";
+    out << "            node_stack_.pop();\n";
+    out << "        }\n";
+    if (!expressions_.empty()) {
+        out << "        climbs_.clear();\n";
+    }
+    out << "    }\n";
+    out << "\n";
+    GenerateGrammar(out);
+    GenerateQualName(out);
+    out << "    std::string converted_text_;\n";
+    out << "    LexedInput converted_;\n";
+    out << "    const LexedInput *input_ = nullptr;\n";
+    out << "    TokenStream *stream_ = nullptr;\n";
+    out << "    TokenPipe *pipe_ = nullptr;\n";
+    out << "    std::string_view text_;\n";
+    out << "    bool views_ = false;\n";
+    out << "    std::shared_ptr<const void> storage_;\n";
+    out << "    size_t pos_ = 0;\n";
+    out << "    LexToken token_ = {};\n";
+    out << "    bool at_end_ = false;\n";
+    out << "    bool past_end_ = false;\n";
+    out << "    std::stack<size_t> state_stack_;\n";
+    out << "    std::stack<std::shared_ptr<ParseTreeNode>> node_stack_;\n";
+    out << "\n";
+    out << "    NonTerminal current_nt_;\n";
+    if (!expressions_.empty()) {
+        out << "    std::vector<ClimbFrame> climbs_;\n";
+    }
+    if (profile_) {
+        out << "\n";
+        out << "    static constexpr std::uint64_t kTablesFingerprint = 0x"
+            << std::hex << LayoutProfile::Fingerprint(*tables_) << std::dec
+            << "ULL;\n";
+        out << "    std::vector<size_t> state_visits_ = std::vector<size_t>("
+            << tables_->action_.GetStateCount() << ", 0);\n";
+        out << "    std::vector<size_t> terminal_shifts_ = "
+               "std::vector<size_t>(kTerminalCount, 0);\n";
+    }
+    out << "};\n";
+}
+
+void ParserGenerator::GenerateLRLoop(std::ostream &out) const {
+    out << "    int Run() {\n";
+    out << "        std::uint32_t a = Current();\n";
+    out << "        ParserTables::Lookahead la = "
+           "ParserTables::GetLookahead(a);\n";
     out << "        bool done = false;\n";
     out << "        int return_state = 0;\n";
     out << "        while (!done) {\n";
     out << "            size_t s = state_stack_.top();\n";
-    out << "            auto entry = action_.at(s);\n";
-    out << "            Action action;\n";
-    out << "            if (entry.find(QualName(a)) != entry.end()) {\n";
-    out << "                action = entry.at(QualName(a));\n";
-    out << "            } else {\n";
-    out << "                action = Action{ActionType::ERROR};\n";
+    if (profile_) {
+        out << "            ++state_visits_[s];\n";
+    }
+    out << "            Action action = ParserTables::GetDefault(s);\n";
+    out << "            if (action.type == ActionType::ERROR) {\n";
+    out << "                action = ParserTables::GetAction(s, la);\n";
     out << "            }\n";
     out << "            switch (action.type) {\n";
     out << "                case ActionType::SHIFT: {\n";
-    out << "                    auto new_node = "
-           "std::make_shared<ParseTreeNode>(ParseTreeNode{a, {}});\n";
+    out << "                    auto new_node = Shifted(a);\n";
     out << "                    node_stack_.push(new_node);\n";
     out << "                    state_stack_.push(action.value);\n";
-    out << "                    seq_.pop();\n";
-    out << "                    a = seq_.top();\n";
+    if (profile_) {
+        out << "                    ++terminal_shifts_[a];\n";
+    }
+    out << "                    Advance();\n";
+    out << "                    a = Current();\n";
+    out << "                    la = ParserTables::GetLookahead(a);\n";
     out << "                    break;\n";
     out << "                }\n";
-    out << "                case ActionType::REDUCE: {\n";
-    out << "                    Rule rule = g_[action.value];\n";
-    out << "                    std::vector<std::shared_ptr<ParseTreeNode>> "
-           "new_children;\n";
-    out << "                    if (QualName(rule.prod[0]) != \"T_\") {\n";
-    out << "                        for (size_t i = 0; i < rule.prod.size(); "
-           "++i) "
-           "{\n";
-    out << "                            "
-           "new_children.push_back(node_stack_.top());\n";
-    out << "                            node_stack_.pop();\n";
-    out << "                            state_stack_.pop();\n";
-    out << "                        }\n";
-    out << "                    }\n";
-    out << "                    std::reverse(new_children.begin(), "
-           "new_children.end());\n";
-    out << "                    auto new_node = "
-           "std::make_shared<ParseTreeNode>(ParseTreeNode{rule.lhs, "
-           "new_children});\n";
+    out << "                case ActionType::REDUCE:\n";
+    if (expressions_.empty()) {
+        out << "                    Reduce(action.value, false);\n";
+    } else {
+        out << "                    if (Reduce(action.value, false)) {\n";
+        out << "                        a = Current();\n";
+        out << "                        la = ParserTables::GetLookahead(a);\n";
+        out << "                    }\n";
+    }
+    out << "                    break;\n";
+    out << "                case ActionType::SHIFT_REDUCE: {\n";
+    out << "                    auto new_node = Shifted(a);\n";
     out << "                    node_stack_.push(new_node);\n";
-    out << "                    size_t t = state_stack_.top();\n";
-    out << "                    state_stack_.push(goto_.at(t).at(rule.lhs));\n";
-    out << "                    current_nt_ = rule.lhs;\n";
+    if (profile_) {
+        out << "                    ++terminal_shifts_[a];\n";
+    }
+    out << "                    Advance();\n";
+    out << "                    a = Current();\n";
+    out << "                    la = ParserTables::GetLookahead(a);\n";
+    if (expressions_.empty()) {
+        out << "                    Reduce(action.value, true);\n";
+    } else {
+        out << "                    if (Reduce(action.value, true)) {\n";
+        out << "                        a = Current();\n";
+        out << "                        la = ParserTables::GetLookahead(a);\n";
+        out << "                    }\n";
+    }
     out << "                    break;\n";
     out << "                }\n";
     out << "                case ActionType::ACCEPT:\n";
     out << "                    done = true;\n";
     out << "                    break;\n";
     out << "                case ActionType::ERROR: {\n";
-    out << "                    std::cerr << \"Error on token \" << "
-           "(a.repr.empty() ? a.name : a.repr) << "
+    out << "                    std::cerr << \"Error on token \" << Lexeme() << "
            "\", trying to recover\" << "
            "std::endl;\n";
     out << "                    ++return_state;\n";
@@ -404,20 +1005,22 @@ void ParserGenerator::Generate() {
     out << "                        return -return_state;\n";
     out << "                    }\n";
     out << "                    bool recovered = false;\n";
-    out << "                    while (!seq_.empty() && !recovered) {\n";
-    out << "                        if (follow.find(seq_.top()) != "
-           "follow.end()) {\n";
+    out << "                    while (!past_end_ && !recovered) {\n";
+    out << "                        if (Current() < kTerminalCount &&\n";
+    out << "                            follow.find(MakeTerminal(Current(), "
+           "Lexeme())) != follow.end()) {\n";
     out << "                            recovered = true;\n";
     out << "                        }\n";
-    out << "                        seq_.pop();\n";
+    out << "                        Advance();\n";
     out << "                    }\n";
     out << "                    if (!recovered) {\n";
     out << "                        std::cerr << \"Error, cannot recover\" << "
            "std::endl;\n";
     out << "                        return -return_state;\n";
     out << "                    }\n";
-    out << "                    if (!seq_.empty()) {\n";
-    out << "                        a = seq_.top();\n";
+    out << "                    if (!past_end_) {\n";
+    out << "                        a = Current();\n";
+    out << "                        la = ParserTables::GetLookahead(a);\n";
     out << "                    }\n";
     out << "                }\n";
     out << "            }\n";
@@ -425,25 +1028,511 @@ void ParserGenerator::Generate() {
     out << "        return return_state;\n";
     out << "    }\n";
     out << "\n";
-    out << "    ParseTree GetParseTree() const {\n";
-    out << "        return ParseTree(node_stack_.top());\n";
+}
+
+void ParserGenerator::GenerateProfileWriter(std::ostream &out) const {
+    out << "    // writes the number of visits of every state and of shifts of "
+           "every\n";
+    out << "    // terminal counted over all calls to Parse(), pass the file to "
+           "`gen\n";
+    out << "    // --profile` to lay the tables out for them\n";
+    out << "    void WriteProfile(std::ostream &out) const {\n";
+    out << "        out << \"pargen-profile " << LayoutProfile::kVersion
+        << " \" << std::hex << kTablesFingerprint << std::dec << \" \"\n";
+    out << "            << state_visits_.size() << \"\\n\";\n";
+    out << "        for (size_t s = 0; s < state_visits_.size(); ++s) {\n";
+    out << "            if (state_visits_[s] != 0) {\n";
+    out << "                out << \"state \" << s << \" \" << "
+           "state_visits_[s] << \"\\n\";\n";
+    out << "            }\n";
+    out << "        }\n";
+    out << "        for (size_t t = 0; t < terminal_shifts_.size(); ++t) {\n";
+    out << "            if (terminal_shifts_[t] != 0) {\n";
+    out << "                out << \"terminal \" << terminal_shifts_[t] << "
+           "(kTerminalIsRegex[t] ? \" R_\" : \" T_\") << kTerminalNames[t] "
+           "<< \"\\n\";\n";
+    out << "            }\n";
+    out << "        }\n";
     out << "    }\n";
     out << "\n";
-    out << "private:\n";
-    out << "    void Clear() {\n";
-    out << "        while (!seq_.empty()) {\n";
-    out << "            seq_.pop();\n";
+}
+
+void ParserGenerator::GenerateGotoPush(std::ostream &out) const {
+    out << "        state_stack_.push(ParserTables::GetGoto(t, rule_number));\n";
+    out << "        current_nt_ = rule.lhs;\n";
+    if (!tables_->unit_chains_.empty()) {
+        // the goto skipped the reductions by unit rules, their nodes are
+        // restored here
+        out << "        const std::vector<NonTerminal> *collapsed = "
+               "ParserTables::GetCollapsed(t, rule_number);\n";
+        out << "        if (collapsed != nullptr) {\n";
+        out << "            for (const NonTerminal &lhs : *collapsed) {\n";
+        out << "                new_node = std::make_shared<ParseTreeNode>("
+               "ParseTreeNode{lhs, {new_node}});\n";
+        out << "                current_nt_ = lhs;\n";
+        out << "            }\n";
+        out << "        }\n";
+    }
+    out << "        node_stack_.push(new_node);\n";
+}
+
+void ParserGenerator::GenerateClimbing(std::ostream &out) const {
+    const SymbolIds &symbols = tables_->symbols_;
+    size_t rules = g_.rules_.size();
+    size_t states = tables_->action_.GetStateCount();
+    size_t chained = expressions_.size() + 1;
+    auto operand = [this](const NonTerminal &nt) -> std::optional<size_t> {
+        for (size_t e = 0; e < expressions_.size(); ++e) {
+            if (expressions_[e].operand_ == nt) {
+                return e;
+            }
+        }
+        return std::nullopt;
+    };
+
+    std::vector<uint32_t> operand_of(rules, 0);
+    for (size_t r = 0; r < rules; ++r) {
+        std::optional<size_t> e = operand(g_[r].lhs);
+        if (e.has_value()) {
+            operand_of[r] = e.value() + 1;
+        }
+    }
+    // keyed like the chains of GetCollapsed(), the expression (numbered from
+    // 1) and the number of unit nodes up to its operand
+    std::map<size_t, std::pair<size_t, size_t>> chains;
+    for (const auto &[key, chain] : tables_->unit_chains_) {
+        for (size_t r = 0; r < rules; ++r) {
+            if (symbols.GetNonTerminalId(g_[r].lhs) != key.second ||
+                (operand_of[r] != 0 && operand_of[r] != chained)) {
+                continue;
+            }
+            for (size_t i = 0; i < chain.size(); ++i) {
+                std::optional<size_t> e =
+                    operand(symbols.GetNonTerminal(chain[i]));
+                if (e.has_value()) {
+                    chains[key.first * rules + r] = {e.value() + 1, i + 1};
+                    operand_of[r] = chained;
+                    break;
+                }
+            }
+        }
+    }
+    // an operand is only parsed right after an operator or at the start of
+    // its expression, so the goto on the expression tells the starts apart
+    std::vector<uint32_t> starts(expressions_.size() * states, 0);
+    for (size_t e = 0; e < expressions_.size(); ++e) {
+        size_t root =
+            symbols.GetNonTerminalId(expressions_[e].levels_[0].lhs_);
+        for (size_t s = 0; s < states; ++s) {
+            starts[e * states + s] = tables_->goto_.Get(s, root).has_value();
+        }
+    }
+    std::vector<uint32_t> level_counts;
+    bool left = false;
+    bool tail = false;
+    for (const Expression &expression : expressions_) {
+        level_counts.push_back(expression.levels_.size());
+        for (const ExpressionLevel &level : expression.levels_) {
+            (level.tail_.has_value() ? tail : left) = true;
+        }
+    }
+
+    out << "    // the expressions marked for precedence climbing: the tables "
+           "only parse\n";
+    out << "    // their operands, a finished operand is handed to the "
+           "sub-parser of its\n";
+    out << "    // expression, which reads the operator after it and builds "
+           "the levels\n";
+    out << "    // once they are complete. `levels` holds the operands and the "
+           "operators\n";
+    out << "    // of the levels still being parsed, from the loosest one\n";
+    out << "    struct ClimbFrame {\n";
+    out << "        size_t expression;\n";
+    out << "        size_t depth;\n";
+    out << "        std::vector<std::vector<std::shared_ptr<ParseTreeNode>>> "
+           "levels;\n";
+    out << "    };\n";
+    out << "\n";
+    out << "    // the expression the left-hand side of the rule is an operand "
+           "of plus 1,\n";
+    out << "    // " << chained
+        << " if the goto may bypass unit reductions up to an operand\n";
+    out << "    static constexpr " << UnsignedType(CombTables::WidthFor(chained))
+        << " kOperandOf[] = {\n";
+    GenerateArray(out, operand_of, 8);
+    out << "    };\n";
+    out << "    // by expression and state\n";
+    out << "    static constexpr std::uint8_t kExpressionStart[] = {\n";
+    GenerateArray(out, starts, 8);
+    out << "    };\n";
+    out << "    static constexpr size_t kLevelCount[] = {\n";
+    GenerateArray(out, level_counts, 8);
+    out << "    };\n";
+    out << "\n";
+    out << "    // returns -1 if the node is not an operand of an expression, "
+           "otherwise\n";
+    out << "    // whether the sub-parser consumed input\n";
+    out << "    int Climb(size_t t, size_t rule_number, "
+           "std::shared_ptr<ParseTreeNode> &node) {\n";
+    out << "        size_t e = kOperandOf[rule_number];\n";
+    out << "        if (e == 0) {\n";
+    out << "            return -1;\n";
     out << "        }\n";
-    out << "        seq_.push(Terminal{\"$\", \"$\"});\n";
-    out << "        while (!state_stack_.empty()) {\n";
+    if (!chains.empty()) {
+        out << "        size_t wraps = 0;\n";
+        out << "        if (e == " << chained << ") {\n";
+        out << "            static const std::unordered_map<size_t, "
+               "std::pair<size_t, size_t>> chains = {\n";
+        for (const auto &[key, value] : chains) {
+            out << "                {" << key << ", {" << value.first << ", "
+                << value.second << "}},\n";
+        }
+        out << "            };\n";
+        out << "            auto it = chains.find(t * " << rules
+            << " + rule_number);\n";
+        out << "            if (it == chains.end()) {\n";
+        out << "                return -1;\n";
+        out << "            }\n";
+        out << "            e = it->second.first;\n";
+        out << "            wraps = it->second.second;\n";
+        out << "        }\n";
+    }
+    out << "        --e;\n";
+    out << "        if (!climbs_.empty() && climbs_.back().expression == e &&\n";
+    out << "            climbs_.back().depth + 1 == state_stack_.size()) {\n";
+    out << "            // the operand follows an operator, the state it was "
+           "parsed in is done\n";
     out << "            state_stack_.pop();\n";
+    out << "        } else if (kExpressionStart[e * " << states << " + t]) {\n";
+    out << "            climbs_.push_back(ClimbFrame{e, state_stack_.size(), "
+           "{}});\n";
+    out << "            climbs_.back().levels.resize(kLevelCount[e]);\n";
+    out << "        } else {\n";
+    out << "            return -1;\n";
     out << "        }\n";
-    out << "        state_stack_.push(0);\n";
-    out << "        while (!node_stack_.empty()) {\n";
-    out << "            node_stack_.pop();\n";
+    if (!chains.empty()) {
+        out << "        if (wraps != 0) {\n";
+        out << "            const std::vector<NonTerminal> &collapsed = "
+               "*ParserTables::GetCollapsed(t, rule_number);\n";
+        out << "            for (size_t i = 0; i < wraps; ++i) {\n";
+        out << "                node = std::make_shared<ParseTreeNode>("
+               "ParseTreeNode{collapsed[i], {node}});\n";
+        out << "            }\n";
+        out << "        }\n";
+    }
+    out << "        climbs_.back().levels.back().push_back(node);\n";
+    out << "        bool consumed = false;\n";
+    out << "        switch (e) {\n";
+    for (size_t e = 0; e < expressions_.size(); ++e) {
+        out << "            case " << e << ":\n";
+        out << "                consumed = ClimbExpression" << e << "();\n";
+        out << "                break;\n";
+    }
+    out << "        }\n";
+    out << "        return consumed ? 1 : 0;\n";
+    out << "    }\n";
+    out << "\n";
+    out << "    // pushes the goto of the reduction unless its node is an "
+           "operand, returns\n";
+    out << "    // whether the sub-parser of an expression consumed input\n";
+    out << "    bool Goto(size_t t, size_t rule_number, "
+           "std::shared_ptr<ParseTreeNode> new_node) {\n";
+    out << "        int climbed = Climb(t, rule_number, new_node);\n";
+    out << "        if (climbed >= 0) {\n";
+    out << "            return climbed == 1;\n";
+    out << "        }\n";
+    out << "        const Rule &rule = g_[rule_number];\n";
+    GenerateGotoPush(out);
+    out << "        return false;\n";
+    out << "    }\n";
+    out << "\n";
+    if (left) {
+        out << "    // <L> = <L> 'op' <N> | <N>\n";
+        out << "    static std::shared_ptr<ParseTreeNode> BuildLeft(const "
+               "NonTerminal &lhs, const "
+               "std::vector<std::shared_ptr<ParseTreeNode>> &items) {\n";
+        out << "        auto node = std::make_shared<ParseTreeNode>("
+               "ParseTreeNode{lhs, {items[0]}});\n";
+        out << "        for (size_t i = 1; i + 1 < items.size(); i += 2) {\n";
+        out << "            node = std::make_shared<ParseTreeNode>("
+               "ParseTreeNode{lhs, {node, items[i], items[i + 1]}});\n";
+        out << "        }\n";
+        out << "        return node;\n";
+        out << "    }\n";
+        out << "\n";
+    }
+    if (tail) {
+        out << "    // <L> = <N> <Tail>, <Tail> = 'op' <N> <Tail> | EPSILON\n";
+        out << "    static std::shared_ptr<ParseTreeNode> BuildTail(const "
+               "NonTerminal &lhs, const NonTerminal &tail, const "
+               "std::vector<std::shared_ptr<ParseTreeNode>> &items) {\n";
+        out << "        auto node = std::make_shared<ParseTreeNode>("
+               "ParseTreeNode{tail, {}});\n";
+        out << "        for (size_t i = items.size(); i > 1; i -= 2) {\n";
+        out << "            node = std::make_shared<ParseTreeNode>("
+               "ParseTreeNode{tail, {items[i - 2], items[i - 1], node}});\n";
+        out << "        }\n";
+        out << "        return std::make_shared<ParseTreeNode>("
+               "ParseTreeNode{lhs, {items[0], node}});\n";
+        out << "    }\n";
+        out << "\n";
+    }
+    for (size_t e = 0; e < expressions_.size(); ++e) {
+        GenerateClimber(out, e);
+    }
+}
+
+void ParserGenerator::GenerateClimber(std::ostream &out, size_t e) const {
+    const Expression &expression = expressions_[e];
+    const std::vector<ExpressionLevel> &levels = expression.levels_;
+    size_t n = levels.size();
+    auto rule_of = [this](const NonTerminal &nt) {
+        size_t r = 0;
+        while (g_[r].lhs != nt) {
+            ++r;
+        }
+        return r;
+    };
+    // the operator is shifted in the state after the level, or after the
+    // operand of the level when the operators are in a tail
+    std::vector<uint32_t> goto_rules;
+    for (size_t k = 0; k < n; ++k) {
+        const NonTerminal &before =
+            !levels[k].tail_.has_value() ? levels[k].lhs_ : levels[k].next_;
+        goto_rules.push_back(rule_of(before));
+    }
+
+    out << "    // " << DescribeToken(levels[0].lhs_) << ":";
+    for (const ExpressionLevel &level : levels) {
+        out << " " << DescribeToken(level.lhs_) << " (";
+        for (size_t i = 0; i < level.operators_.size(); ++i) {
+            out << (i == 0 ? "" : " | ") << DescribeToken(level.operators_[i]);
+        }
+        out << "),";
+    }
+    out << " operand " << DescribeToken(expression.operand_) << "\n";
+    out << "    bool ClimbExpression" << e << "() {\n";
+    out << "        auto &levels = climbs_.back().levels;\n";
+    out << "        std::uint32_t a = Current();\n";
+    out << "        size_t level = " << n << ";\n";
+    for (size_t k = 0; k < n; ++k) {
+        out << "        " << (k == 0 ? "if" : "} else if") << " (";
+        const std::vector<Terminal> &ops = levels[k].operators_;
+        for (size_t i = 0; i < ops.size(); ++i) {
+            out << (i == 0 ? "" : " || ") << "a == "
+                << tables_->symbols_.GetTerminalId(ops[i]);
+        }
+        out << ") {  //";
+        for (const Terminal &op : ops) {
+            out << " " << DescribeToken(op);
+        }
+        out << "\n";
+        out << "            level = " << k << ";\n";
+    }
+    out << "        }\n";
+    out << "        size_t t = state_stack_.top();\n";
+    out << "        // the levels binding tighter than the operator are "
+           "complete, all of them\n";
+    out << "        // at the end of the expression\n";
+    out << "        size_t complete = level == " << n << " ? 0 : level;\n";
+    out << "        for (size_t j = " << n - 1 << "; j > complete; --j) {\n";
+    out << "            levels[j - 1].push_back(BuildExpression" << e
+        << "(j, levels[j]));\n";
+    out << "            levels[j].clear();\n";
     out << "        }\n";
+    out << "        if (level == " << n << ") {\n";
+    out << "            auto node = BuildExpression" << e << "(0, levels[0]);\n";
+    out << "            climbs_.pop_back();\n";
+    out << "            return Goto(t, " << rule_of(levels[0].lhs_)
+        << ", node);\n";
+    out << "        }\n";
+    out << "        // the next operand is parsed from the state after the "
+           "operator\n";
+    out << "        static constexpr size_t kGotoRules[] = {\n";
+    GenerateArray(out, goto_rules, 8);
+    out << "        };\n";
+    out << "        levels[level].push_back(Shifted(a));\n";
+    out << "        state_stack_.push(ParserTables::GetAction("
+           "ParserTables::GetGoto(t, kGotoRules[level]), "
+           "ParserTables::GetLookahead(a)).value);\n";
+    out << "        // the last reduction the tables would have made, for the "
+           "error recovery\n";
+    out << "        current_nt_ = g_[kGotoRules[level]].lhs;\n";
+    if (profile_) {
+        out << "        ++terminal_shifts_[a];\n";
+    }
+    out << "        Advance();\n";
+    out << "        return true;\n";
+    out << "    }\n";
+    out << "\n";
+    out << "    static std::shared_ptr<ParseTreeNode> BuildExpression" << e
+        << "(size_t level, const std::vector<std::shared_ptr<ParseTreeNode>> "
+           "&items) {\n";
+    out << "        switch (level) {\n";
+    for (size_t k = 0; k < n; ++k) {
+        out << "            case " << k << ": {\n";
+        out << "                static const NonTerminal lhs{\""
+            << levels[k].lhs_.name_ << "\"};\n";
+        if (levels[k].tail_.has_value()) {
+            out << "                static const NonTerminal tail{\""
+                << levels[k].tail_->name_ << "\"};\n";
+            out << "                return BuildTail(lhs, tail, items);\n";
+        } else {
+            out << "                return BuildLeft(lhs, items);\n";
+        }
+        out << "            }\n";
+    }
+    out << "        }\n";
+    out << "        return nullptr;\n";
     out << "    }\n";
     out << "\n";
+}
+
+void ParserGenerator::GenerateLLParser(std::ostream &out) const {
+    out << "class Parser {\n";
+    out << "public:\n";
+    out << "    int Parse(const std::vector<Terminal> &stream) {\n";
+    out << "        Clear();\n";
+    out << "        const Terminal eof{\"$\", \"$\"};\n";
+    out << "        size_t pos = 0;\n";
+    out << "        auto lookahead = [&]() -> const Terminal & {\n";
+    out << "            return pos < stream.size() ? stream[pos] : eof;\n";
+    out << "        };\n";
+    out << "\n";
+    out << "        NonTerminal start = std::get<NonTerminal>(g_[0].prod[0]);\n";
+    out << "        root_ = "
+           "std::make_shared<ParseTreeNode>(ParseTreeNode{start, {}});\n";
+    out << "        stack_.push_back({start, root_});\n";
+    out << "        int return_state = 0;\n";
+    out << "        while (!stack_.empty()) {\n";
+    out << "            auto [symbol, node] = stack_.back();\n";
+    out << "            stack_.pop_back();\n";
+    out << "            const Terminal &a = lookahead();\n";
+    out << "            if (std::holds_alternative<Terminal>(symbol)) {\n";
+    out << "                if (QualName(symbol) == QualName(a)) {\n";
+    out << "                    node->value = a;\n";
+    out << "                    ++pos;\n";
+    out << "                    continue;\n";
+    out << "                }\n";
+    out << "                // the expected terminal is assumed to be missing\n";
+    out << "                std::cerr << \"Error on token \" << "
+           "(a.repr.empty() ? a.name : a.repr) << \", expected \" << "
+           "std::get<Terminal>(symbol).name << \", trying to recover\" << "
+           "std::endl;\n";
+    out << "                ++return_state;\n";
+    out << "                continue;\n";
+    out << "            }\n";
+    out << "\n";
+    out << "            NonTerminal nt = std::get<NonTerminal>(symbol);\n";
+    out << "            const auto &row = predict_.at(nt);\n";
+    out << "            auto it = row.find(QualName(a));\n";
+    out << "            if (it == row.end()) {\n";
+    out << "                std::cerr << \"Error on token \" << "
+           "(a.repr.empty() ? a.name : a.repr) << "
+           "\", trying to recover\" << std::endl;\n";
+    out << "                ++return_state;\n";
+    out << "                FollowSet follow = "
+           "ParserTables::GetFollowSetFor(nt);\n";
+    out << "                while (pos < stream.size() &&\n";
+    out << "                       row.find(QualName(lookahead())) == "
+           "row.end() &&\n";
+    out << "                       follow.find(lookahead()) == follow.end()) "
+           "{\n";
+    out << "                    ++pos;\n";
+    out << "                }\n";
+    out << "                if (row.find(QualName(lookahead())) != row.end()) "
+           "{\n";
+    out << "                    stack_.push_back({nt, node});\n";
+    out << "                } else if (follow.find(lookahead()) == "
+           "follow.end()) {\n";
+    out << "                    std::cerr << \"Error, cannot recover\" << "
+           "std::endl;\n";
+    out << "                    return -return_state;\n";
+    out << "                }\n";
+    out << "                continue;\n";
+    out << "            }\n";
+    out << "\n";
+    out << "            const Rule &rule = g_[it->second];\n";
+    out << "            if (QualName(rule.prod[0]) == \"T_\") {\n";
+    out << "                continue;\n";
+    out << "            }\n";
+    out << "            for (const Token &token : rule.prod) {\n";
+    out << "                node->children.push_back("
+           "std::make_shared<ParseTreeNode>(ParseTreeNode{token, {}}));\n";
+    out << "            }\n";
+    out << "            for (size_t i = rule.prod.size(); i > 0; --i) {\n";
+    out << "                stack_.push_back({rule.prod[i - 1], "
+           "node->children[i - 1]});\n";
+    out << "            }\n";
+    out << "        }\n";
+    out << "        if (pos < stream.size()) {\n";
+    out << "            std::cerr << \"Error on token \" << "
+           "(stream[pos].repr.empty() ? stream[pos].name : stream[pos].repr) "
+           "<< \", expected end of input\" << std::endl;\n";
+    out << "            return -(return_state + 1);\n";
+    out << "        }\n";
+    out << "        return return_state;\n";
+    out << "    }\n";
+    out << "\n";
+    GenerateLexedInputParse(out);
+    out << "    ParseTree GetParseTree() const {\n";
+    out << "        return ParseTree(root_);\n";
+    out << "    }\n";
+    out << "\n";
+    out << "private:\n";
+    out << "    void Clear() {\n";
+    out << "        stack_.clear();\n";
+    out << "        root_.reset();\n";
+    out << "    }\n";
+    out << "\n";
+    GenerateGrammar(out);
+    GenerateQualName(out);
+    out << "    std::vector<std::pair<Token, std::shared_ptr<ParseTreeNode>>> "
+           "stack_;\n";
+    out << "    std::shared_ptr<ParseTreeNode> root_;\n";
+    out << "\n";
+    out << "    inline static const PredictTable predict_ = "
+           "ParserTables::GetPredictTable();\n";
+    out << "};\n";
+}
+
+void ParserGenerator::GenerateLexedInputParse(std::ostream &out) const {
+    out << "    // the tables are looked up by the terminals, the tokens are "
+           "converted\n";
+    out << "    int Parse(const LexedInput &input) {\n";
+    out << "        std::vector<Terminal> stream;\n";
+    out << "        stream.reserve(input.tokens.size());\n";
+    out << "        for (const LexToken &token : input.tokens) {\n";
+    out << "            stream.push_back(MakeTerminal(token.id, "
+           "input.Lexeme(token)));\n";
+    out << "        }\n";
+    out << "        return Parse(stream);\n";
+    out << "    }\n";
+    out << "\n";
+    out << "    int Parse(TokenStream &tokens) {\n";
+    out << "        return Parse(Convert(tokens));\n";
+    out << "    }\n";
+    out << "\n";
+    out << "    int Parse(TokenPipe &tokens) {\n";
+    out << "        return Parse(Convert(tokens));\n";
+    out << "    }\n";
+    out << "\n";
+    out << "    template <typename Stream>\n";
+    out << "    static std::vector<Terminal> Convert(Stream &tokens) {\n";
+    out << "        std::vector<Terminal> stream;\n";
+    out << "        LexToken token;\n";
+    out << "        while (tokens.Next(token)) {\n";
+    out << "            stream.push_back(MakeTerminal(\n";
+    out << "                token.id, tokens.GetText().substr(token.offset, "
+           "token.length)\n";
+    out << "            ));\n";
+    out << "        }\n";
+    out << "        return stream;\n";
+    out << "    }\n";
+    out << "\n";
+}
+
+void ParserGenerator::GenerateGrammar(std::ostream &out) const {
     out << "    inline static const Grammar g_ = {\n";
     for (const Rule &rule : g_.rules_) {
         out << "        {\n";
@@ -468,6 +1557,9 @@ void ParserGenerator::Generate() {
     }
     out << "    };\n";
     out << "\n";
+}
+
+void ParserGenerator::GenerateQualName(std::ostream &out) const {
     out << "    std::string QualName(const Token& token) {\n";
     out << "        if (std::holds_alternative<Terminal>(token)) {\n";
     out << "            Terminal t = std::get<Terminal>(token);\n";
@@ -481,17 +1573,408 @@ void ParserGenerator::Generate() {
     out << "        }\n";
     out << "    }\n";
     out << "\n";
+}
+
+void ParserGenerator::GenerateBundleParser(std::ostream &out) const {
+    GeneratePrelude(out, true);
+    GenerateActionType(out);
+    GenerateParseTree(out);
+    out << "// Maps a table bundle written by the generator into memory, the"
+           " tables are\n";
+    out << "// read in place\n";
+    out << "class BundleTables {\n";
+    out << "public:\n";
+    out << "    explicit BundleTables(const std::string &path) {\n";
+    out << "        int fd = ::open(path.c_str(), O_RDONLY);\n";
+    out << "        if (fd < 0) {\n";
+    out << "            throw std::runtime_error(\"Could not open \" +"
+           " path);\n";
+    out << "        }\n";
+    out << "        struct stat st;\n";
+    out << "        if (::fstat(fd, &st) != 0 || st.st_size < kHeaderSize) {\n";
+    out << "            ::close(fd);\n";
+    out << "            throw std::runtime_error(path + \" is not a table"
+           " bundle\");\n";
+    out << "        }\n";
+    out << "        size_ = static_cast<size_t>(st.st_size);\n";
+    out << "        void *data = ::mmap(nullptr, size_, PROT_READ,"
+           " MAP_PRIVATE, fd, 0);\n";
+    out << "        ::close(fd);\n";
+    out << "        if (data == MAP_FAILED) {\n";
+    out << "            throw std::runtime_error(\"Could not map \" + path);\n";
+    out << "        }\n";
+    out << "        data_ = static_cast<const std::uint8_t *>(data);\n";
+    out << "        try {\n";
+    out << "            Validate(path);\n";
+    out << "        } catch (...) {\n";
+    out << "            ::munmap(const_cast<std::uint8_t *>(data_), size_);\n";
+    out << "            throw;\n";
+    out << "        }\n";
+    out << "    }\n";
+    out << "\n";
+    out << "    BundleTables(const BundleTables &) = delete;\n";
+    out << "    BundleTables &operator=(const BundleTables &) = delete;\n";
+    out << "\n";
+    out << "    ~BundleTables() {\n";
+    out << "        ::munmap(const_cast<std::uint8_t *>(data_), size_);\n";
+    out << "    }\n";
+    out << "\n";
+    out << "    using Lookahead = size_t;\n";
+    out << "\n";
+    out << "    static constexpr size_t kNone = SIZE_MAX;\n";
+    out << "\n";
+    out << "    Lookahead GetLookahead(const Terminal &t) const {\n";
+    out << "        std::string name = (t.repr.empty() ? \"T_\" : \"R_\") +"
+           " t.name;\n";
+    out << "        const std::uint32_t *order = Section(kTerminalOrder);\n";
+    out << "        size_t lo = 0;\n";
+    out << "        size_t hi = Count(kTerminalOrder);\n";
+    out << "        while (lo < hi) {\n";
+    out << "            size_t mid = (lo + hi) / 2;\n";
+    out << "            std::string_view other = TerminalName(order[mid]);\n";
+    out << "            if (other < name) {\n";
+    out << "                lo = mid + 1;\n";
+    out << "            } else {\n";
+    out << "                hi = mid;\n";
+    out << "            }\n";
+    out << "        }\n";
+    out << "        if (lo == Count(kTerminalOrder) ||"
+           " TerminalName(order[lo]) != name) {\n";
+    out << "            return columns_;\n";
+    out << "        }\n";
+    out << "        return Section(kTerminalClasses)[order[lo]];\n";
+    out << "    }\n";
+    out << "\n";
+    out << "    Action GetDefault(size_t state) const {\n";
+    out << "        if (!Section(kDefaultOnly)[state]) {\n";
+    out << "            return Action{ActionType::ERROR};\n";
+    out << "        }\n";
+    out << "        return Decode(Section(kDefaults)[state]);\n";
+    out << "    }\n";
+    out << "\n";
+    out << "    Action GetAction(size_t state, Lookahead a) const {\n";
+    out << "        size_t i = Section(kBase)[state] + a;\n";
+    out << "        if (a >= columns_ || i >= Count(kCheck) ||\n";
+    out << "            Section(kCheck)[i] != state) {\n";
+    out << "            return Decode(Section(kDefaults)[state]);\n";
+    out << "        }\n";
+    out << "        return Decode(Section(kNext)[i]);\n";
+    out << "    }\n";
+    out << "\n";
+    out << "    size_t GetGoto(size_t state, size_t rule) const {\n";
+    out << "        size_t column = columns_ + GetLhs(rule);\n";
+    out << "        return Section(kNext)[Section(kBase)[state] + column];\n";
+    out << "    }\n";
+    out << "\n";
+    out << "    size_t GetLhs(size_t rule) const {\n";
+    out << "        return Section(kRules)[3 * rule];\n";
+    out << "    }\n";
+    out << "\n";
+    out << "    // 0 for an epsilon rule\n";
+    out << "    size_t GetLength(size_t rule) const {\n";
+    out << "        return Section(kRules)[3 * rule + 2];\n";
+    out << "    }\n";
+    out << "\n";
+    out << "    NonTerminal GetNonTerminal(size_t nt) const {\n";
+    out << "        const std::uint32_t *entry = Section(kNonTerminals) + 2 *"
+           " nt;\n";
+    out << "        return NonTerminal{std::string(String(entry[0],"
+           " entry[1]))};\n";
+    out << "    }\n";
+    out << "\n";
+    out << "    bool InFollow(size_t nt, const Terminal &t) const {\n";
+    out << "        std::string name = (t.repr.empty() ? \"T_\" : \"R_\") +"
+           " t.name;\n";
+    out << "        const std::uint32_t *index = Section(kFollowIndex);\n";
+    out << "        const std::uint32_t *follow = Section(kFollow);\n";
+    out << "        for (size_t i = index[nt]; i < index[nt + 1]; ++i) {\n";
+    out << "            if (TerminalName(follow[i]) == name) {\n";
+    out << "                return true;\n";
+    out << "            }\n";
+    out << "        }\n";
+    out << "        return false;\n";
+    out << "    }\n";
+    out << "\n";
+    out << "    // the non-terminals of the unit reductions the goto on the"
+           " left-hand side\n";
+    out << "    // of the rule skipped\n";
+    out << "    std::span<const std::uint32_t> GetCollapsed(size_t state,"
+           " size_t rule)\n";
+    out << "        const {\n";
+    out << "        size_t key = state * (Count(kNonTerminals) / 2) +"
+           " GetLhs(rule);\n";
+    out << "        const std::uint32_t *chains = Section(kUnitChains);\n";
+    out << "        size_t lo = 0;\n";
+    out << "        size_t hi = Count(kUnitChains) / 3;\n";
+    out << "        while (lo < hi) {\n";
+    out << "            size_t mid = (lo + hi) / 2;\n";
+    out << "            if (chains[3 * mid] < key) {\n";
+    out << "                lo = mid + 1;\n";
+    out << "            } else {\n";
+    out << "                hi = mid;\n";
+    out << "            }\n";
+    out << "        }\n";
+    out << "        if (lo == Count(kUnitChains) / 3 || chains[3 * lo] !="
+           " key) {\n";
+    out << "            return {};\n";
+    out << "        }\n";
+    out << "        return std::span<const std::uint32_t>(\n";
+    out << "            Section(kUnitSymbols) + chains[3 * lo + 1], chains[3"
+           " * lo + 2]\n";
+    out << "        );\n";
+    out << "    }\n";
+    out << "\n";
+    out << "private:\n";
+    out << "    static constexpr std::uint32_t kVersion = "
+        << TableBundle::kVersion << ";\n";
+    out << "    static constexpr std::uint32_t kByteOrderMark = 0x01020304;\n";
+    out << "    static constexpr size_t kSections = "
+        << static_cast<size_t>(BundleSection::COUNT) << ";\n";
+    out << "    static constexpr long kHeaderSize = 4 * (6 + 2 * kSections);\n";
+    out << "    enum Sections {\n";
+    out << "        kStrings,\n";
+    out << "        kTerminals,\n";
+    out << "        kTerminalOrder,\n";
+    out << "        kNonTerminals,\n";
+    out << "        kRules,\n";
+    out << "        kSymbols,\n";
+    out << "        kBase,\n";
+    out << "        kNext,\n";
+    out << "        kCheck,\n";
+    out << "        kDefaults,\n";
+    out << "        kDefaultOnly,\n";
+    out << "        kTerminalClasses,\n";
+    out << "        kFollowIndex,\n";
+    out << "        kFollow,\n";
+    out << "        kUnitChains,\n";
+    out << "        kUnitSymbols\n";
+    out << "    };\n";
+    out << "\n";
+    out << "    std::uint32_t Word(size_t i) const {\n";
+    out << "        std::uint32_t word;\n";
+    out << "        std::memcpy(&word, data_ + 4 * i, sizeof(word));\n";
+    out << "        return word;\n";
+    out << "    }\n";
+    out << "\n";
+    out << "    void Validate(const std::string &path) {\n";
+    out << "        if (std::memcmp(data_, \"PGTB\", 4) != 0) {\n";
+    out << "            throw std::runtime_error(path + \" is not a table"
+           " bundle\");\n";
+    out << "        }\n";
+    out << "        if (Word(1) != kVersion) {\n";
+    out << "            throw std::runtime_error(\n";
+    out << "                path + \" has version \" +"
+           " std::to_string(Word(1)) +\n";
+    out << "                \", expected \" + std::to_string(kVersion)\n";
+    out << "            );\n";
+    out << "        }\n";
+    out << "        if (Word(2) != kByteOrderMark) {\n";
+    out << "            throw std::runtime_error(path + \" has a different"
+           " byte order\");\n";
+    out << "        }\n";
+    out << "        if (Word(3) != size_ || Word(5) != kSections) {\n";
+    out << "            throw std::runtime_error(path + \" is truncated or"
+           " corrupted\");\n";
+    out << "        }\n";
+    out << "        columns_ = Word(4);\n";
+    out << "        for (size_t s = 0; s < kSections; ++s) {\n";
+    out << "            size_t width = s == kStrings ? 1 : 4;\n";
+    out << "            if (Word(6 + 2 * s) % 4 != 0 ||\n";
+    out << "                Word(6 + 2 * s) + width * Word(7 + 2 * s) >"
+           " size_) {\n";
+    out << "                throw std::runtime_error(path + \" is truncated"
+           " or corrupted\");\n";
+    out << "            }\n";
+    out << "        }\n";
+    out << "    }\n";
+    out << "\n";
+    out << "    const std::uint32_t *Section(size_t s) const {\n";
+    out << "        return reinterpret_cast<const std::uint32_t *>(data_ +"
+           " Word(6 + 2 * s));\n";
+    out << "    }\n";
+    out << "\n";
+    out << "    size_t Count(size_t s) const {\n";
+    out << "        return Word(7 + 2 * s);\n";
+    out << "    }\n";
+    out << "\n";
+    out << "    std::string_view String(size_t offset, size_t length) const"
+           " {\n";
+    out << "        return std::string_view(\n";
+    out << "            reinterpret_cast<const char *>(data_ + Word(6)) +"
+           " offset, length\n";
+    out << "        );\n";
+    out << "    }\n";
+    out << "\n";
+    out << "    std::string_view TerminalName(size_t t) const {\n";
+    out << "        const std::uint32_t *entry = Section(kTerminals) + 2 *"
+           " t;\n";
+    out << "        return String(entry[0], entry[1]);\n";
+    out << "    }\n";
+    out << "\n";
+    out << "    static Action Decode(std::uint32_t cell) {\n";
+    out << "        if (cell == 0) {\n";
+    out << "            return Action{ActionType::ERROR};\n";
+    out << "        }\n";
+    out << "        return Action{\n";
+    out << "            static_cast<ActionType>((cell & "
+        << ((1u << DenseActionTable::kTypeBits) - 1) << "u) - 1),\n";
+    out << "            static_cast<size_t>(cell >> "
+        << DenseActionTable::kTypeBits << ")\n";
+    out << "        };\n";
+    out << "    }\n";
+    out << "\n";
+    out << "    const std::uint8_t *data_ = nullptr;\n";
+    out << "    size_t size_ = 0;\n";
+    out << "    size_t columns_ = 0;\n";
+    out << "};\n";
+    out << "\n";
+    out << "class BundleParser {\n";
+    out << "public:\n";
+    out << "    explicit BundleParser(const BundleTables &tables) :"
+           " tables_(tables) {}\n";
+    out << "\n";
+    out << "    int Parse(const std::vector<Terminal> &stream) {\n";
+    out << "        Clear();\n";
+    out << "        for (const Terminal &token : stream |"
+           " std::views::reverse) {\n";
+    out << "            seq_.push(token);\n";
+    out << "        }\n";
+    out << "\n";
+    out << "        Terminal a = seq_.top();\n";
+    out << "        BundleTables::Lookahead la = tables_.GetLookahead(a);\n";
+    out << "        bool done = false;\n";
+    out << "        int return_state = 0;\n";
+    out << "        while (!done) {\n";
+    out << "            size_t s = state_stack_.top();\n";
+    out << "            Action action = tables_.GetDefault(s);\n";
+    out << "            if (action.type == ActionType::ERROR) {\n";
+    out << "                action = tables_.GetAction(s, la);\n";
+    out << "            }\n";
+    out << "            switch (action.type) {\n";
+    out << "                case ActionType::SHIFT: {\n";
+    out << "                    auto new_node =\n";
+    out << "                       "
+           " std::make_shared<ParseTreeNode>(ParseTreeNode{a, {}});\n";
+    out << "                    node_stack_.push(new_node);\n";
+    out << "                    state_stack_.push(action.value);\n";
+    out << "                    seq_.pop();\n";
+    out << "                    a = seq_.top();\n";
+    out << "                    la = tables_.GetLookahead(a);\n";
+    out << "                    break;\n";
+    out << "                }\n";
+    out << "                case ActionType::REDUCE:\n";
+    out << "                    Reduce(action.value, false);\n";
+    out << "                    break;\n";
+    out << "                case ActionType::SHIFT_REDUCE: {\n";
+    out << "                    auto new_node =\n";
+    out << "                       "
+           " std::make_shared<ParseTreeNode>(ParseTreeNode{a, {}});\n";
+    out << "                    node_stack_.push(new_node);\n";
+    out << "                    seq_.pop();\n";
+    out << "                    a = seq_.top();\n";
+    out << "                    la = tables_.GetLookahead(a);\n";
+    out << "                    Reduce(action.value, true);\n";
+    out << "                    break;\n";
+    out << "                }\n";
+    out << "                case ActionType::ACCEPT:\n";
+    out << "                    done = true;\n";
+    out << "                    break;\n";
+    out << "                case ActionType::ERROR: {\n";
+    out << "                    std::cerr << \"Error on token \"\n";
+    out << "                              << (a.repr.empty() ? a.name :"
+           " a.repr)\n";
+    out << "                              << \", trying to recover\" <<"
+           " std::endl;\n";
+    out << "                    ++return_state;\n";
+    out << "                    if (current_nt_ == BundleTables::kNone) {\n";
+    out << "                        std::cerr << \"Error, cannot recover\" <<"
+           " std::endl;\n";
+    out << "                        return -return_state;\n";
+    out << "                    }\n";
+    out << "                    bool recovered = false;\n";
+    out << "                    while (!seq_.empty() && !recovered) {\n";
+    out << "                        if (tables_.InFollow(current_nt_,"
+           " seq_.top())) {\n";
+    out << "                            recovered = true;\n";
+    out << "                        }\n";
+    out << "                        seq_.pop();\n";
+    out << "                    }\n";
+    out << "                    if (!recovered) {\n";
+    out << "                        std::cerr << \"Error, cannot recover\" <<"
+           " std::endl;\n";
+    out << "                        return -return_state;\n";
+    out << "                    }\n";
+    out << "                    if (!seq_.empty()) {\n";
+    out << "                        a = seq_.top();\n";
+    out << "                        la = tables_.GetLookahead(a);\n";
+    out << "                    }\n";
+    out << "                }\n";
+    out << "            }\n";
+    out << "        }\n";
+    out << "        return return_state;\n";
+    out << "    }\n";
+    out << "\n";
+    GenerateLexedInputParse(out);
+    out << "    ParseTree GetParseTree() const {\n";
+    out << "        return ParseTree(node_stack_.top());\n";
+    out << "    }\n";
+    out << "\n";
+    out << "private:\n";
+    out << "    // `fused` is set for SHIFT_REDUCE, which doesn't push a"
+           " state for the\n";
+    out << "    // shifted terminal\n";
+    out << "    void Reduce(size_t rule_number, bool fused) {\n";
+    out << "        size_t length = tables_.GetLength(rule_number);\n";
+    out << "        std::vector<std::shared_ptr<ParseTreeNode>>"
+           " new_children;\n";
+    out << "        for (size_t i = 0; i < length; ++i) {\n";
+    out << "            new_children.push_back(node_stack_.top());\n";
+    out << "            node_stack_.pop();\n";
+    out << "            if (i != 0 || !fused) {\n";
+    out << "                state_stack_.pop();\n";
+    out << "            }\n";
+    out << "        }\n";
+    out << "        std::reverse(new_children.begin(), new_children.end());\n";
+    out << "        current_nt_ = tables_.GetLhs(rule_number);\n";
+    out << "        auto new_node ="
+           " std::make_shared<ParseTreeNode>(ParseTreeNode{\n";
+    out << "            tables_.GetNonTerminal(current_nt_), new_children\n";
+    out << "        });\n";
+    out << "        size_t t = state_stack_.top();\n";
+    out << "        state_stack_.push(tables_.GetGoto(t, rule_number));\n";
+    out << "        for (std::uint32_t lhs : tables_.GetCollapsed(t,"
+           " rule_number)) {\n";
+    out << "            new_node = std::make_shared<ParseTreeNode>(\n";
+    out << "                ParseTreeNode{tables_.GetNonTerminal(lhs),"
+           " {new_node}}\n";
+    out << "            );\n";
+    out << "            current_nt_ = lhs;\n";
+    out << "        }\n";
+    out << "        node_stack_.push(new_node);\n";
+    out << "    }\n";
+    out << "\n";
+    out << "    void Clear() {\n";
+    out << "        while (!seq_.empty()) {\n";
+    out << "            seq_.pop();\n";
+    out << "        }\n";
+    out << "        seq_.push(Terminal{\"$\", \"$\"});\n";
+    out << "        while (!state_stack_.empty()) {\n";
+    out << "            state_stack_.pop();\n";
+    out << "        }\n";
+    out << "        state_stack_.push(0);\n";
+    out << "        while (!node_stack_.empty()) {\n";
+    out << "            node_stack_.pop();\n";
+    out << "        }\n";
+    out << "        current_nt_ = BundleTables::kNone;\n";
+    out << "    }\n";
+    out << "\n";
+    out << "    const BundleTables &tables_;\n";
     out << "    std::stack<Terminal> seq_;\n";
     out << "    std::stack<size_t> state_stack_;\n";
     out << "    std::stack<std::shared_ptr<ParseTreeNode>> node_stack_;\n";
     out << "\n";
-    out << "    NonTerminal current_nt_;\n";
-    out << "\n";
-    out << "    inline static const ActionTable action_ = "
-           "ParserTables::GetActionTable();\n";
-    out << "    inline static const GotoTable goto_ = "
-           "ParserTables::GetGotoTable();\n";
+    out << "    size_t current_nt_ = BundleTables::kNone;\n";
     out << "};\n";
+
     out << "};  // namespace p\n";
-    out.close();
-}
\ No newline at end of file
+}
@@ -1,18 +1,69 @@
 #include "Automaton.h"
 
 #include <boost/container_hash/hash_fwd.hpp>
+#include <algorithm>
 #include <cstddef>
 #include <queue>
 
 #include "GrammarAnalyzer.h"
 #include "Helpers.h"
 
+namespace {
+/**
+ * @brief The estimated number of bytes taken by an item stored in a set, which
+ * is the item itself and the node of the red-black tree.
+ */
+constexpr size_t kItemNodeBytes = sizeof(Automaton::Item) + 4 * sizeof(void *);
+
+/**
+ * @brief Returns the LR(0) core of the kernel of the state.
+ */
+std::vector<std::pair<size_t, size_t>> KernelCore(const Automaton::State &state
+) {
+    std::vector<std::pair<size_t, size_t>> core;
+    for (const Automaton::Item &item : state) {
+        if (item.dot_pos_ > 0 || item.rule_number_ == 0) {
+            core.emplace_back(item.rule_number_, item.dot_pos_);
+        }
+    }
+    core.erase(std::unique(core.begin(), core.end()), core.end());
+    return core;
+}
+
+std::string FormatBytes(size_t bytes) {
+    if (bytes < 1024 * 1024) {
+        return std::to_string(bytes / 1024) + " KiB";
+    }
+    return std::to_string(bytes / (1024 * 1024)) + " MiB";
+}
+}  // namespace
+
+AutomatonBudgetError::AutomatonBudgetError(const std::string &msg)
+    : msg_(msg) {
+}
+
+const char *AutomatonBudgetError::what() const noexcept {
+    return msg_.c_str();
+}
+
 Automaton::Item::Item(size_t rule_number, size_t dot_pos, Terminal lookahead)
     : rule_number_(rule_number), dot_pos_(dot_pos), lookahead_(lookahead) {
 }
 
-Automaton::Automaton(const Grammar &g, const GrammarAnalyzer &ga)
-    : g_(g), ga_(ga) {
+Automaton::Automaton(
+    const Grammar &g, const GrammarAnalyzer &ga,
+    const AutomatonLimits &limits
+)
+    : g_(g), ga_(ga), limits_(limits) {
+    BuildCanonicalCollection();
+}
+
+Automaton::Automaton(
+    const Grammar &g, const GrammarAnalyzer &ga, const StateMap &prev_states,
+    const Transitions &prev_transitions, const AutomatonLimits &limits
+)
+    : g_(g), ga_(ga), limits_(limits) {
+    ReuseStates(prev_states, prev_transitions);
     BuildCanonicalCollection();
 }
 
@@ -45,6 +96,8 @@ std::set<Automaton::Item> Automaton::Closure(
     }
 
     std::set<Item> closure = InternalClosure(items);
+    memory_ += key.items_.size() * sizeof(Item) +
+               closure.size() * kItemNodeBytes;
     closure_cache_[key] = closure;
 
     return closure;
@@ -108,26 +161,91 @@ std::set<Automaton::Item> Automaton::InternalClosure(const std::set<Item> &items
     return closure;
 }
 
+void Automaton::ReuseStates(
+    const StateMap &prev_states, const Transitions &prev_transitions
+) {
+    const std::optional<GrammarDiff> &diff = ga_.GetDiff();
+    if (!diff.has_value()) {
+        return;
+    }
+    for (const auto &[idx, prev_state] : prev_states.left) {
+        State state;
+        bool clean = true;
+        for (const Item &item : prev_state) {
+            if (item.rule_number_ >= diff->rule_mapping_.size() ||
+                !diff->rule_mapping_[item.rule_number_].has_value()) {
+                clean = false;
+                break;
+            }
+            Item mapped{
+                diff->rule_mapping_[item.rule_number_].value(), item.dot_pos_,
+                item.lookahead_
+            };
+            const Production &p = g_[mapped.rule_number_].prod;
+            for (size_t i = mapped.dot_pos_; i < p.size() && clean; ++i) {
+                if (IsNonTerminal(p[i]) &&
+                    diff->changed_.contains(std::get<NonTerminal>(p[i]))) {
+                    clean = false;
+                }
+            }
+            state.insert(mapped);
+        }
+        if (!clean || idx >= prev_transitions.size()) {
+            continue;
+        }
+
+        std::set<Item> kernel;
+        for (const Item &item : state) {
+            if (item.dot_pos_ > 0 || item.rule_number_ == 0) {
+                kernel.insert(item);
+            }
+        }
+        std::vector<Token> &tokens = reused_[state];
+        for (const auto &[token, target] : prev_transitions[idx]) {
+            tokens.push_back(token);
+        }
+        memory_ += kernel.size() * sizeof(Item) + state.size() * kItemNodeBytes;
+        closure_cache_[GetKey(kernel)] = std::move(state);
+    }
+}
+
 void Automaton::BuildCanonicalCollection() {
     State initial_state = Closure({Item{0, 0, T_EOF}});
     states_.insert({0, initial_state});
+    transitions_.emplace_back();
+    AddState(0, initial_state, 0);
     std::queue<size_t> state_queue;
     state_queue.push(0);
     size_t state_idx = 1;
+    std::vector<Token> all_tokens(g_.tokens_.begin(), g_.tokens_.end());
     while (!state_queue.empty()) {
         size_t current_idx = state_queue.front();
         state_queue.pop();
         const State &current_state = states_.left.at(current_idx);
-        for (const Token &token : g_.tokens_) {
+        // a reused state has transitions on exactly the same tokens as before
+        const std::vector<Token> *tokens = &all_tokens;
+        auto reused = reused_.find(current_state);
+        if (reused != reused_.end()) {
+            tokens = &reused->second;
+            ++reused_states_;
+        }
+        for (const Token &token : *tokens) {
             State goto_token_state = Goto(current_state, token);
-            if (!goto_token_state.empty()) {
-                if (states_.right.find(goto_token_state) ==
-                    states_.right.end()) {
-                    states_.insert({state_idx, goto_token_state});
-                    state_queue.push(state_idx);
-                    ++state_idx;
-                }
+            if (goto_token_state.empty()) {
+                continue;
             }
+            size_t target_idx;
+            auto it = states_.right.find(goto_token_state);
+            if (it == states_.right.end()) {
+                target_idx = state_idx++;
+                states_.insert({target_idx, goto_token_state});
+                state_queue.push(target_idx);
+                transitions_.emplace_back();
+                AddState(target_idx, goto_token_state, state_queue.size());
+            } else {
+                target_idx = it->second;
+            }
+            transitions_[current_idx][token] = target_idx;
         }
     }
 }
@@ -136,6 +254,109 @@ const Automaton::StateMap &Automaton::GetStates() const {
     return states_;
 }
 
+const Automaton::Transitions &Automaton::GetTransitions() const {
+    return transitions_;
+}
+
+size_t Automaton::GetReusedStates() const {
+    return reused_states_;
+}
+
+size_t Automaton::GetCoreCount() const {
+    return cores_.size();
+}
+
+size_t Automaton::GetEstimatedMemory() const {
+    return memory_;
+}
+
+std::vector<Automaton::CoreSplit> Automaton::GetCoreSplits(size_t count
+) const {
+    std::vector<const std::pair<
+        const std::vector<std::pair<size_t, size_t>>, std::vector<size_t>> *>
+        split;
+    for (const auto &entry : cores_) {
+        if (entry.second.size() > 1) {
+            split.push_back(&entry);
+        }
+    }
+    std::stable_sort(split.begin(), split.end(), [](auto *lhs, auto *rhs) {
+        return lhs->second.size() > rhs->second.size();
+    });
+    split.resize(std::min(split.size(), count));
+
+    std::vector<CoreSplit> result;
+    for (const auto *entry : split) {
+        CoreSplit core_split{entry->first, entry->second, {}};
+        // a lookahead caused the split if some kernel item has it only in
+        // some of the states sharing the core
+        std::map<std::pair<size_t, size_t>, std::map<Terminal, size_t>>
+            occurrences;
+        for (size_t idx : entry->second) {
+            for (const Item &item : states_.left.at(idx)) {
+                if (item.dot_pos_ > 0 || item.rule_number_ == 0) {
+                    ++occurrences[{item.rule_number_, item.dot_pos_}]
+                                 [item.lookahead_];
+                }
+            }
+        }
+        for (const auto &[core_item, lookaheads] : occurrences) {
+            for (const auto &[t, n] : lookaheads) {
+                if (n != entry->second.size()) {
+                    core_split.lookaheads_.insert(t);
+                }
+            }
+        }
+        result.push_back(std::move(core_split));
+    }
+    return result;
+}
+
+std::string Automaton::DescribeCoreSplits(size_t count) const {
+    std::string result;
+    for (const CoreSplit &split : GetCoreSplits(count)) {
+        result += std::to_string(split.states_.size()) +
+                  " LR(1) states share the core\n";
+        for (const auto &[rule, dot] : split.core_) {
+            result += "    " + DescribeRule(g_[rule], dot) + "\n";
+        }
+        result += "  split by lookaheads:";
+        for (const Terminal &t : split.lookaheads_) {
+            result += " " + DescribeToken(t);
+        }
+        result += "\n";
+    }
+    return result;
+}
+
+void Automaton::AddState(size_t idx, const State &state, size_t pending) {
+    cores_[KernelCore(state)].push_back(idx);
+    memory_ += state.size() * kItemNodeBytes;
+
+    size_t count = states_.size();
+    if (limits_.report_every_ != 0 && count % limits_.report_every_ == 0 &&
+        limits_.on_progress_) {
+        limits_.on_progress_(count, pending, memory_);
+    }
+
+    std::string exceeded;
+    if (limits_.max_states_ != 0 && count > limits_.max_states_) {
+        exceeded = "the limit of " + std::to_string(limits_.max_states_) +
+                   " states";
+    } else if (limits_.max_memory_ != 0 && memory_ > limits_.max_memory_) {
+        exceeded = "the memory limit of " + FormatBytes(limits_.max_memory_);
+    }
+    if (!exceeded.empty()) {
+        throw AutomatonBudgetError(
+            "The automaton exceeded " + exceeded + " (" +
+            std::to_string(count) + " states from " +
+            std::to_string(cores_.size()) + " LR(0) cores, ~" +
+            FormatBytes(memory_) + ", " + std::to_string(pending) +
+            " states pending). Most split cores:\n" + DescribeCoreSplits(10)
+        );
+    }
+}
+
 bool Automaton::DotAtEnd(const Item &item) const {
     return item.dot_pos_ >= g_[item.rule_number_].prod.size();
 }
@@ -0,0 +1,195 @@
+#include "CombTables.h"
+
+#include <algorithm>
+#include <numeric>
+#include <utility>
+
+CombTables::CombTables(const DenseTables &tables, bool in_order)
+    : terminal_count_(tables.action_.GetTerminalCount()),
+      nonterminal_count_(tables.goto_.GetNonTerminalCount()) {
+    size_t states = std::max(
+        tables.action_.GetStateCount(), tables.goto_.GetStateCount()
+    );
+    std::vector<std::vector<std::pair<size_t, uint32_t>>> rows(states);
+    for (size_t s = 0; s < tables.action_.GetStateCount(); ++s) {
+        std::span<const DenseActionTable::Cell> row = tables.action_.GetRow(s);
+        for (size_t t = 0; t < row.size(); ++t) {
+            if (row[t] != 0) {
+                rows[s].emplace_back(t, row[t]);
+            }
+        }
+    }
+    for (size_t s = 0; s < tables.goto_.GetStateCount(); ++s) {
+        std::span<const DenseGotoTable::Cell> row = tables.goto_.GetRow(s);
+        for (size_t nt = 0; nt < row.size(); ++nt) {
+            if (row[nt] != DenseGotoTable::kNone) {
+                rows[s].emplace_back(terminal_count_ + nt, row[nt]);
+            }
+        }
+    }
+
+    // the densest rows are the hardest to fit, so they are placed first
+    std::vector<size_t> order(states);
+    std::iota(order.begin(), order.end(), 0);
+    if (!in_order) {
+        std::stable_sort(
+            order.begin(), order.end(),
+            [&rows](size_t lhs, size_t rhs) {
+                return rows[lhs].size() > rows[rhs].size();
+            }
+        );
+    }
+
+    const uint32_t unused = static_cast<uint32_t>(states);
+    base_.assign(states, 0);
+    size_t first_free = 0;
+    for (size_t s : order) {
+        const auto &row = rows[s];
+        if (row.empty()) {
+            continue;
+        }
+        auto fits = [&](size_t base) {
+            return std::all_of(row.begin(), row.end(), [&](const auto &cell) {
+                size_t i = base + cell.first;
+                return i >= check_.size() || check_[i] == unused;
+            });
+        };
+        // no cell of the row can be placed before the first free slot
+        size_t base =
+            first_free > row.front().first ? first_free - row.front().first : 0;
+        while (!fits(base)) {
+            ++base;
+        }
+        size_t end = base + row.back().first + 1;
+        if (end > check_.size()) {
+            next_.resize(end, 0);
+            check_.resize(end, unused);
+        }
+        for (const auto &[column, value] : row) {
+            next_[base + column] = value;
+            check_[base + column] = static_cast<uint32_t>(s);
+        }
+        base_[s] = static_cast<uint32_t>(base);
+        while (first_free < check_.size() && check_[first_free] != unused) {
+            ++first_free;
+        }
+    }
+    // the arrays are emitted as C arrays, which can't be empty
+    if (check_.empty()) {
+        next_.push_back(0);
+        check_.push_back(unused);
+    }
+
+    const std::vector<DenseActionTable::Cell> &defaults =
+        tables.action_.GetDefaults();
+    defaults_.assign(defaults.begin(), defaults.end());
+    defaults_.resize(states, 0);
+    default_only_.assign(states, 0);
+    for (size_t s = 0; s < tables.action_.GetStateCount(); ++s) {
+        default_only_[s] = tables.action_.IsDefaultOnly(s) ? 1 : 0;
+    }
+    for (size_t t = 0; t < tables.symbols_.GetTerminalCount(); ++t) {
+        terminal_classes_.push_back(
+            static_cast<uint32_t>(tables.GetTerminalColumn(t))
+        );
+    }
+}
+
+std::optional<uint32_t> CombTables::Lookup(size_t state, size_t column) const {
+    size_t i = base_[state] + column;
+    if (i >= check_.size() || check_[i] != state) {
+        return std::nullopt;
+    }
+    return next_[i];
+}
+
+Action CombTables::GetAction(size_t state, size_t terminal) const {
+    if (terminal >= terminal_count_) {
+        return Action{ActionType::ERROR, 0};
+    }
+    return DenseActionTable::Decode(
+        Lookup(state, terminal).value_or(defaults_[state])
+    );
+}
+
+std::optional<size_t> CombTables::GetGoto(size_t state, size_t nonterminal)
+    const {
+    if (nonterminal >= nonterminal_count_) {
+        return std::nullopt;
+    }
+    return Lookup(state, terminal_count_ + nonterminal);
+}
+
+size_t CombTables::GetStateCount() const {
+    return base_.size();
+}
+
+size_t CombTables::GetTerminalCount() const {
+    return terminal_count_;
+}
+
+size_t CombTables::GetNonTerminalCount() const {
+    return nonterminal_count_;
+}
+
+const std::vector<uint32_t> &CombTables::GetBase() const {
+    return base_;
+}
+
+const std::vector<uint32_t> &CombTables::GetNext() const {
+    return next_;
+}
+
+const std::vector<uint32_t> &CombTables::GetCheck() const {
+    return check_;
+}
+
+const std::vector<uint32_t> &CombTables::GetDefaults() const {
+    return defaults_;
+}
+
+const std::vector<uint32_t> &CombTables::GetDefaultOnly() const {
+    return default_only_;
+}
+
+const std::vector<uint32_t> &CombTables::GetTerminalClasses() const {
+    return terminal_classes_;
+}
+
+size_t CombTables::WidthFor(uint64_t max_value) {
+    if (max_value <= UINT8_MAX) {
+        return 1;
+    }
+    if (max_value <= UINT16_MAX) {
+        return 2;
+    }
+    return 4;
+}
+
+size_t CombTables::GetBaseWidth() const {
+    if (base_.empty()) {
+        return WidthFor(0);
+    }
+    return WidthFor(*std::max_element(base_.begin(), base_.end()));
+}
+
+size_t CombTables::GetNextWidth() const {
+    return WidthFor(*std::max_element(next_.begin(), next_.end()));
+}
+
+size_t CombTables::GetCheckWidth() const {
+    return WidthFor(GetStateCount());
+}
+
+size_t CombTables::GetDefaultWidth() const {
+    if (defaults_.empty()) {
+        return WidthFor(0);
+    }
+    return WidthFor(*std::max_element(defaults_.begin(), defaults_.end()));
+}
+
+size_t CombTables::GetByteSize() const {
+    return base_.size() * (GetBaseWidth() + GetDefaultWidth() + 1) +
+           next_.size() * (GetNextWidth() + GetCheckWidth()) +
+           terminal_classes_.size() * WidthFor(terminal_count_);
+}
@@ -0,0 +1,268 @@
+#include "DenseTables.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "Helpers.h"
+
+SymbolIds::SymbolIds(const Grammar &g) {
+    AddTerminal(T_EOF);
+    for (const Token &token : g.tokens_) {
+        if (IsTerminal(token) && std::get<Terminal>(token) != EPSILON) {
+            AddTerminal(std::get<Terminal>(token));
+        }
+    }
+    for (const Rule &rule : g.rules_) {
+        AddNonTerminal(rule.lhs);
+    }
+    for (const Rule &rule : g.rules_) {
+        for (const Token &token : rule.prod) {
+            if (IsNonTerminal(token)) {
+                AddNonTerminal(std::get<NonTerminal>(token));
+            } else if (std::get<Terminal>(token) != EPSILON) {
+                AddTerminal(std::get<Terminal>(token));
+            }
+        }
+    }
+}
+
+size_t SymbolIds::AddTerminal(const Terminal &t) {
+    auto [it, inserted] = terminal_ids_.emplace(t, terminals_.size());
+    if (inserted) {
+        terminals_.push_back(t);
+        terminal_names_.push_back(QualName(t));
+    }
+    return it->second;
+}
+
+size_t SymbolIds::AddNonTerminal(const NonTerminal &nt) {
+    auto [it, inserted] = nonterminal_ids_.emplace(nt, nonterminals_.size());
+    if (inserted) {
+        nonterminals_.push_back(nt);
+    }
+    return it->second;
+}
+
+size_t SymbolIds::GetTerminalCount() const {
+    return terminals_.size();
+}
+
+size_t SymbolIds::GetNonTerminalCount() const {
+    return nonterminals_.size();
+}
+
+std::optional<size_t> SymbolIds::FindTerminal(const Terminal &t) const {
+    auto it = terminal_ids_.find(t);
+    if (it == terminal_ids_.end()) {
+        return std::nullopt;
+    }
+    return it->second;
+}
+
+std::optional<size_t> SymbolIds::FindNonTerminal(const NonTerminal &nt) const {
+    auto it = nonterminal_ids_.find(nt);
+    if (it == nonterminal_ids_.end()) {
+        return std::nullopt;
+    }
+    return it->second;
+}
+
+size_t SymbolIds::GetTerminalId(const Terminal &t) const {
+    return terminal_ids_.at(t);
+}
+
+size_t SymbolIds::GetNonTerminalId(const NonTerminal &nt) const {
+    return nonterminal_ids_.at(nt);
+}
+
+const Terminal &SymbolIds::GetTerminal(size_t id) const {
+    return terminals_.at(id);
+}
+
+const std::string &SymbolIds::GetTerminalName(size_t id) const {
+    return terminal_names_.at(id);
+}
+
+const NonTerminal &SymbolIds::GetNonTerminal(size_t id) const {
+    return nonterminals_.at(id);
+}
+
+DenseActionTable::DenseActionTable(size_t states, size_t terminals)
+    : terminals_(terminals),
+      cells_(states * terminals, 0),
+      defaults_(states, 0) {
+}
+
+DenseActionTable DenseActionTable::Clone() const {
+    DenseActionTable copy;
+    copy.terminals_ = terminals_;
+    copy.cells_ = cells_;
+    copy.defaults_ = defaults_;
+    return copy;
+}
+
+DenseActionTable::Cell DenseActionTable::Encode(const Action &action) {
+    if (action.type_ == ActionType::ERROR) {
+        return 0;
+    }
+    if (action.value_ > (UINT32_MAX >> kTypeBits)) {
+        throw std::out_of_range(
+            "Action value " + std::to_string(action.value_) +
+            " doesn't fit into a table cell"
+        );
+    }
+    // ERROR is encoded as 0, so the other types are shifted by one
+    Cell type = static_cast<Cell>(action.type_) + 1;
+    return static_cast<Cell>(action.value_ << kTypeBits) | type;
+}
+
+Action DenseActionTable::Decode(Cell cell) {
+    Cell type = cell & ((1u << kTypeBits) - 1);
+    if (type == 0) {
+        return Action{ActionType::ERROR, 0};
+    }
+    return Action{static_cast<ActionType>(type - 1), cell >> kTypeBits};
+}
+
+size_t DenseActionTable::GetStateCount() const {
+    return terminals_ == 0 ? 0 : cells_.size() / terminals_;
+}
+
+size_t DenseActionTable::GetTerminalCount() const {
+    return terminals_;
+}
+
+Action DenseActionTable::Get(size_t state, size_t terminal) const {
+    return Decode(cells_[state * terminals_ + terminal]);
+}
+
+void DenseActionTable::Set(
+    size_t state, size_t terminal, const Action &action
+) {
+    cells_[state * terminals_ + terminal] = Encode(action);
+}
+
+std::span<const DenseActionTable::Cell> DenseActionTable::GetRow(size_t state
+) const {
+    return std::span<const Cell>(cells_).subspan(state * terminals_, terminals_);
+}
+
+const std::vector<DenseActionTable::Cell> &DenseActionTable::GetCells() const {
+    return cells_;
+}
+
+Action DenseActionTable::Resolve(size_t state, size_t terminal) const {
+    Cell cell = cells_[state * terminals_ + terminal];
+    return Decode(cell != 0 ? cell : defaults_[state]);
+}
+
+Action DenseActionTable::GetDefault(size_t state) const {
+    return Decode(defaults_[state]);
+}
+
+void DenseActionTable::SetDefault(size_t state, const Action &action) {
+    defaults_[state] = Encode(action);
+}
+
+bool DenseActionTable::IsDefaultOnly(size_t state) const {
+    if (defaults_[state] == 0) {
+        return false;
+    }
+    std::span<const Cell> row = GetRow(state);
+    return std::all_of(row.begin(), row.end(), [](Cell cell) {
+        return cell == 0;
+    });
+}
+
+const std::vector<DenseActionTable::Cell> &DenseActionTable::GetDefaults(
+) const {
+    return defaults_;
+}
+
+DenseGotoTable::DenseGotoTable(size_t states, size_t nonterminals)
+    : nonterminals_(nonterminals), cells_(states * nonterminals, kNone) {
+}
+
+DenseGotoTable DenseGotoTable::Clone() const {
+    DenseGotoTable copy;
+    copy.nonterminals_ = nonterminals_;
+    copy.cells_ = cells_;
+    return copy;
+}
+
+size_t DenseGotoTable::GetStateCount() const {
+    return nonterminals_ == 0 ? 0 : cells_.size() / nonterminals_;
+}
+
+size_t DenseGotoTable::GetNonTerminalCount() const {
+    return nonterminals_;
+}
+
+std::optional<size_t> DenseGotoTable::Get(size_t state, size_t nonterminal)
+    const {
+    Cell cell = cells_[state * nonterminals_ + nonterminal];
+    if (cell == kNone) {
+        return std::nullopt;
+    }
+    return cell;
+}
+
+void DenseGotoTable::Set(size_t state, size_t nonterminal, size_t target) {
+    if (target >= kNone) {
+        throw std::out_of_range(
+            "Goto target " + std::to_string(target) +
+            " doesn't fit into a table cell"
+        );
+    }
+    cells_[state * nonterminals_ + nonterminal] = static_cast<Cell>(target);
+}
+
+std::span<const DenseGotoTable::Cell> DenseGotoTable::GetRow(size_t state
+) const {
+    return std::span<const Cell>(cells_).subspan(
+        state * nonterminals_, nonterminals_
+    );
+}
+
+const std::vector<DenseGotoTable::Cell> &DenseGotoTable::GetCells() const {
+    return cells_;
+}
+
+DenseTables DenseTables::Clone() const {
+    return DenseTables{
+        symbols_, action_.Clone(), goto_.Clone(), terminal_classes_,
+        unit_chains_
+    };
+}
+
+size_t DenseTables::GetTerminalColumn(size_t terminal) const {
+    return terminal_classes_.empty() ? terminal : terminal_classes_[terminal];
+}
+
+ActionTable DenseTables::ToActionTable() const {
+    ActionTable table(action_.GetStateCount());
+    for (size_t i = 0; i < table.size(); ++i) {
+        std::span<const DenseActionTable::Cell> row = action_.GetRow(i);
+        for (size_t t = 0; t < symbols_.GetTerminalCount(); ++t) {
+            DenseActionTable::Cell cell = row[GetTerminalColumn(t)];
+            if (cell != 0) {
+                table[i][symbols_.GetTerminalName(t)] =
+                    DenseActionTable::Decode(cell);
+            }
+        }
+    }
+    return table;
+}
+
+GotoTable DenseTables::ToGotoTable() const {
+    GotoTable table;
+    for (size_t i = 0; i < goto_.GetStateCount(); ++i) {
+        std::span<const DenseGotoTable::Cell> row = goto_.GetRow(i);
+        for (size_t nt = 0; nt < row.size(); ++nt) {
+            if (row[nt] != DenseGotoTable::kNone) {
+                table[i][symbols_.GetNonTerminal(nt)] = row[nt];
+            }
+        }
+    }
+    return table;
+}
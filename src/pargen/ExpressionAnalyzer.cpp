@@ -0,0 +1,298 @@
+#include "ExpressionAnalyzer.h"
+
+#include <algorithm>
+
+#include "Helpers.h"
+
+namespace {
+bool IsEpsilonRule(const Rule &rule) {
+    return rule.prod.size() == 1 && rule.prod[0] == Token(EPSILON);
+}
+
+bool IsNonTerminalToken(const Token &token, const NonTerminal &nt) {
+    return IsNonTerminal(token) && std::get<NonTerminal>(token) == nt;
+}
+
+/**
+ * @brief Matches `<lhs> = <first> op <rest...>`-like productions: returns the
+ * operator of a production made of the non-terminal `before` (if set), a
+ * terminal, and the non-terminals of `after`.
+ */
+std::optional<Terminal> MatchOperator(
+    const Production &prod, const std::optional<NonTerminal> &before,
+    const std::vector<NonTerminal> &after
+) {
+    size_t op = before.has_value() ? 1 : 0;
+    if (prod.size() != op + 1 + after.size() ||
+        (before.has_value() && !IsNonTerminalToken(prod[0], before.value())) ||
+        !IsTerminal(prod[op]) || prod[op] == Token(EPSILON)) {
+        return std::nullopt;
+    }
+    for (size_t i = 0; i < after.size(); ++i) {
+        if (!IsNonTerminalToken(prod[op + 1 + i], after[i])) {
+            return std::nullopt;
+        }
+    }
+    return std::get<Terminal>(prod[op]);
+}
+}  // namespace
+
+ExpressionError::ExpressionError(const std::string &msg) : msg_(msg) {
+}
+
+const char *ExpressionError::what() const noexcept {
+    return msg_.c_str();
+}
+
+ExpressionAnalyzer::ExpressionAnalyzer(const Grammar &g) : g_(g) {
+}
+
+Expression ExpressionAnalyzer::Analyze(const NonTerminal &root) const {
+    std::string name = DescribeToken(root);
+    if (RulesOf(root).empty()) {
+        throw ExpressionError(name + " is not defined");
+    }
+    std::optional<ExpressionLevel> level = MatchLevel(root);
+    if (!level.has_value()) {
+        throw ExpressionError(
+            name + " is not an expression, expected `" + name + " = " + name +
+            " 'op' <Next> | <Next>` or `" + name +
+            " = <Next> <Tail>` with `<Tail> = 'op' <Next> <Tail> | EPSILON`"
+        );
+    }
+
+    Expression expression;
+    std::vector<NonTerminal> chain;
+    while (level.has_value()) {
+        chain.push_back(level->lhs_);
+        if (level->tail_.has_value()) {
+            chain.push_back(level->tail_.value());
+        }
+        expression.levels_.push_back(level.value());
+        const NonTerminal &next = level->next_;
+        if (std::find(chain.begin(), chain.end(), next) != chain.end()) {
+            throw ExpressionError(
+                "The levels of " + name + " refer back to " +
+                DescribeToken(next)
+            );
+        }
+        level = MatchLevel(next);
+        if (!level.has_value()) {
+            expression.operand_ = next;
+        }
+    }
+    const NonTerminal &operand = expression.operand_;
+
+    std::vector<Terminal> operators;
+    for (const ExpressionLevel &l : expression.levels_) {
+        for (const Terminal &op : l.operators_) {
+            if (std::find(operators.begin(), operators.end(), op) !=
+                operators.end()) {
+                throw ExpressionError(
+                    "Operator " + DescribeToken(op) + " of " + name +
+                    " is used by two levels"
+                );
+            }
+            operators.push_back(op);
+        }
+    }
+
+    // the levels are only reached from the expression and the operators only
+    // appear between operands, so an operator after an operand always
+    // continues the expression
+    for (const Rule &rule : g_.rules_) {
+        if (std::find(chain.begin(), chain.end(), rule.lhs) != chain.end()) {
+            continue;
+        }
+        for (const Token &token : rule.prod) {
+            if (IsTerminal(token)) {
+                const Terminal &t = std::get<Terminal>(token);
+                if (std::find(operators.begin(), operators.end(), t) !=
+                    operators.end()) {
+                    throw ExpressionError(
+                        "Operator " + DescribeToken(t) + " of " + name +
+                        " is also used in `" + DescribeRule(rule) + "`"
+                    );
+                }
+                continue;
+            }
+            const NonTerminal &nt = std::get<NonTerminal>(token);
+            if (nt != root &&
+                (nt == operand ||
+                 std::find(chain.begin(), chain.end(), nt) != chain.end())) {
+                throw ExpressionError(
+                    DescribeToken(nt) + " of " + name + " is also used in `" +
+                    DescribeRule(rule) + "`"
+                );
+            }
+        }
+    }
+
+    // the operand is parsed from the state the expression starts in, which
+    // must not be able to start a level at the same time
+    std::set<std::string> nullable = FindNullable();
+    if (nullable.contains(operand.name_)) {
+        throw ExpressionError(
+            "Operand " + DescribeToken(operand) + " of " + name +
+            " can be empty"
+        );
+    }
+    std::vector<NonTerminal> corners{operand};
+    for (size_t i = 0; i < corners.size(); ++i) {
+        for (const Rule *rule : RulesOf(corners[i])) {
+            for (const Token &token : rule->prod) {
+                if (!IsNonTerminal(token)) {
+                    break;
+                }
+                const NonTerminal &nt = std::get<NonTerminal>(token);
+                if (std::find(chain.begin(), chain.end(), nt) != chain.end()) {
+                    throw ExpressionError(
+                        "Operand " + DescribeToken(operand) + " of " + name +
+                        " can start with " + DescribeToken(nt)
+                    );
+                }
+                if (std::find(corners.begin(), corners.end(), nt) ==
+                    corners.end()) {
+                    corners.push_back(nt);
+                }
+                if (!nullable.contains(nt.name_)) {
+                    break;
+                }
+            }
+        }
+    }
+    return expression;
+}
+
+std::vector<Expression> ExpressionAnalyzer::Analyze(
+    const std::vector<NonTerminal> &roots
+) const {
+    std::vector<Expression> expressions;
+    for (const NonTerminal &root : roots) {
+        auto same = [&root](const Expression &e) {
+            return e.levels_[0].lhs_ == root;
+        };
+        if (std::none_of(expressions.begin(), expressions.end(), same)) {
+            expressions.push_back(Analyze(root));
+        }
+    }
+    // a level of another expression would share the operand with it
+    for (const Expression &outer : expressions) {
+        for (const Expression &inner : expressions) {
+            const NonTerminal &root = inner.levels_[0].lhs_;
+            for (size_t k = 1; k < outer.levels_.size(); ++k) {
+                if (outer.levels_[k].lhs_ == root) {
+                    throw ExpressionError(
+                        DescribeToken(root) + " is a level of " +
+                        DescribeToken(outer.levels_[0].lhs_) +
+                        ", mark only one of them"
+                    );
+                }
+            }
+        }
+    }
+    return expressions;
+}
+
+std::optional<ExpressionLevel> ExpressionAnalyzer::MatchLevel(
+    const NonTerminal &nt
+) const {
+    std::vector<const Rule *> rules = RulesOf(nt);
+    if (rules.empty()) {
+        return std::nullopt;
+    }
+
+    // the rule without an operator gives the next level, and the tail if
+    // there is one
+    ExpressionLevel level{nt, std::nullopt, {}, {}};
+    auto plain = std::find_if(rules.begin(), rules.end(), [](const Rule *r) {
+        return std::all_of(r->prod.begin(), r->prod.end(), IsNonTerminal);
+    });
+    if (plain == rules.end()) {
+        return std::nullopt;
+    }
+    const Production &prod = (*plain)->prod;
+    if (prod.size() == 1 && rules.size() > 1) {
+        level.next_ = std::get<NonTerminal>(prod[0]);
+        for (const Rule *rule : rules) {
+            if (rule == *plain) {
+                continue;
+            }
+            std::optional<Terminal> op =
+                MatchOperator(rule->prod, nt, {level.next_});
+            if (!op.has_value()) {
+                return std::nullopt;
+            }
+            level.operators_.push_back(op.value());
+        }
+    } else if (prod.size() == 2 && rules.size() == 1) {
+        level.next_ = std::get<NonTerminal>(prod[0]);
+        NonTerminal tail = std::get<NonTerminal>(prod[1]);
+        std::vector<const Rule *> tail_rules = RulesOf(tail);
+        size_t empty = std::count_if(
+            tail_rules.begin(), tail_rules.end(),
+            [](const Rule *r) { return IsEpsilonRule(*r); }
+        );
+        if (tail == nt || tail == level.next_ || empty != 1 ||
+            tail_rules.size() < 2) {
+            return std::nullopt;
+        }
+        for (const Rule *rule : tail_rules) {
+            if (IsEpsilonRule(*rule)) {
+                continue;
+            }
+            std::optional<Terminal> op =
+                MatchOperator(rule->prod, std::nullopt, {level.next_, tail});
+            if (!op.has_value()) {
+                return std::nullopt;
+            }
+            level.operators_.push_back(op.value());
+        }
+        level.tail_ = tail;
+    } else {
+        return std::nullopt;
+    }
+    if (level.next_ == nt) {
+        return std::nullopt;
+    }
+    return level;
+}
+
+std::vector<const Rule *> ExpressionAnalyzer::RulesOf(const NonTerminal &nt
+) const {
+    std::vector<const Rule *> rules;
+    for (const Rule &rule : g_.rules_) {
+        if (rule.lhs == nt) {
+            rules.push_back(&rule);
+        }
+    }
+    return rules;
+}
+
+std::set<std::string> ExpressionAnalyzer::FindNullable() const {
+    std::set<std::string> nullable;
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (const Rule &rule : g_.rules_) {
+            if (nullable.contains(rule.lhs.name_)) {
+                continue;
+            }
+            bool empty = IsEpsilonRule(rule) ||
+                         std::all_of(
+                             rule.prod.begin(), rule.prod.end(),
+                             [&nullable](const Token &token) {
+                                 return IsNonTerminal(token) &&
+                                        nullable.contains(
+                                            std::get<NonTerminal>(token).name_
+                                        );
+                             }
+                         );
+            if (empty) {
+                nullable.insert(rule.lhs.name_);
+                changed = true;
+            }
+        }
+    }
+    return nullable;
+}
@@ -0,0 +1,555 @@
+#include "GenerationCache.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <map>
+
+#include "Helpers.h"
+
+namespace {
+
+const std::string kMagic = "PGC";
+const uint64_t kFormatVersion = 4;
+
+/*
+ * Every token stored in an entry is written once into a symbol table at the
+ * start of the entry and referred to by its index afterwards. Integers are
+ * written as LEB128 varints, which keeps the entries for the example grammars
+ * at a few kilobytes.
+ */
+class Writer {
+public:
+    void Varint(uint64_t v) {
+        while (v >= 0x80) {
+            buf_.push_back(static_cast<char>((v & 0x7f) | 0x80));
+            v >>= 7;
+        }
+        buf_.push_back(static_cast<char>(v));
+    }
+
+    void String(const std::string &s) {
+        Varint(s.size());
+        buf_ += s;
+    }
+
+    void Symbol(const Token &token) {
+        Varint(symbols_.at(token));
+    }
+
+    void SymbolTable(const std::set<Token> &symbols) {
+        Varint(symbols.size());
+        for (const Token &token : symbols) {
+            symbols_.emplace(token, symbols_.size());
+            if (IsTerminal(token)) {
+                const Terminal &t = std::get<Terminal>(token);
+                Varint(0);
+                String(t.name_);
+                String(t.repr_);
+            } else {
+                Varint(1);
+                String(std::get<NonTerminal>(token).name_);
+            }
+        }
+    }
+
+    void Fixed64(uint64_t v) {
+        for (size_t i = 0; i < 8; ++i) {
+            buf_.push_back(static_cast<char>((v >> (8 * i)) & 0xff));
+        }
+    }
+
+    const std::string &Get() const {
+        return buf_;
+    }
+
+private:
+    std::string buf_;
+    std::map<Token, size_t> symbols_;
+};
+
+class Reader {
+public:
+    explicit Reader(const std::string &buf) : buf_(buf) {
+    }
+
+    uint64_t Varint() {
+        uint64_t v = 0;
+        for (size_t shift = 0; shift < 64; shift += 7) {
+            uint8_t byte = static_cast<uint8_t>(Byte());
+            v |= static_cast<uint64_t>(byte & 0x7f) << shift;
+            if (!(byte & 0x80)) {
+                return v;
+            }
+        }
+        throw GenerationCacheError("Malformed integer in cache entry");
+    }
+
+    uint64_t Fixed64() {
+        uint64_t v = 0;
+        for (size_t i = 0; i < 8; ++i) {
+            v |= static_cast<uint64_t>(static_cast<uint8_t>(Byte())) << (8 * i);
+        }
+        return v;
+    }
+
+    std::string String() {
+        uint64_t size = Varint();
+        if (size > buf_.size() - pos_) {
+            throw GenerationCacheError("Truncated cache entry");
+        }
+        std::string s = buf_.substr(pos_, size);
+        pos_ += size;
+        return s;
+    }
+
+    const Token &Symbol() {
+        uint64_t i = Varint();
+        if (i >= symbols_.size()) {
+            throw GenerationCacheError("Unknown symbol in cache entry");
+        }
+        return symbols_[i];
+    }
+
+    const Terminal &TerminalSymbol() {
+        const Token &token = Symbol();
+        if (!IsTerminal(token)) {
+            throw GenerationCacheError("Expected a terminal in cache entry");
+        }
+        return std::get<Terminal>(token);
+    }
+
+    const NonTerminal &NonTerminalSymbol() {
+        const Token &token = Symbol();
+        if (!IsNonTerminal(token)) {
+            throw GenerationCacheError("Expected a non-terminal in cache entry");
+        }
+        return std::get<NonTerminal>(token);
+    }
+
+    void SymbolTable() {
+        uint64_t size = Varint();
+        for (uint64_t i = 0; i < size; ++i) {
+            if (Varint() == 0) {
+                std::string name = String();
+                symbols_.push_back(Terminal{name, String()});
+            } else {
+                symbols_.push_back(NonTerminal{String()});
+            }
+        }
+    }
+
+    bool AtEnd() const {
+        return pos_ == buf_.size();
+    }
+
+    std::string Rest() const {
+        return buf_.substr(pos_);
+    }
+
+private:
+    char Byte() {
+        if (pos_ >= buf_.size()) {
+            throw GenerationCacheError("Truncated cache entry");
+        }
+        return buf_[pos_++];
+    }
+
+    const std::string &buf_;
+    size_t pos_ = 0;
+    std::vector<Token> symbols_;
+};
+
+std::set<Token> CollectSymbols(const CacheEntry &entry) {
+    std::set<Token> symbols = entry.grammar_.tokens_;
+    symbols.insert(EPSILON);
+    symbols.insert(T_EOF);
+    for (const Rule &rule : entry.grammar_.rules_) {
+        symbols.insert(rule.lhs);
+        symbols.insert(rule.prod.begin(), rule.prod.end());
+    }
+    for (const auto &[token, first] : entry.first_) {
+        symbols.insert(token);
+        symbols.insert(first.begin(), first.end());
+    }
+    for (const auto &[nt, follow] : entry.follow_) {
+        symbols.insert(nt);
+        symbols.insert(follow.begin(), follow.end());
+    }
+    for (const auto &[idx, state] : entry.states_.left) {
+        for (const Automaton::Item &item : state) {
+            symbols.insert(item.lookahead_);
+        }
+    }
+    for (const auto &row : entry.transitions_) {
+        for (const auto &[token, target] : row) {
+            symbols.insert(token);
+        }
+    }
+    const SymbolIds &ids = entry.tables_.symbols_;
+    for (size_t i = 0; i < ids.GetTerminalCount(); ++i) {
+        symbols.insert(ids.GetTerminal(i));
+    }
+    for (size_t i = 0; i < ids.GetNonTerminalCount(); ++i) {
+        symbols.insert(ids.GetNonTerminal(i));
+    }
+    return symbols;
+}
+
+uint64_t Fnv1a(const std::string &s, uint64_t hash = 0xcbf29ce484222325ULL) {
+    for (char c : s) {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+/*
+ * A stored cell is never empty, and the value of a decoded action has to
+ * refer to an existing state or rule.
+ */
+bool IsValidAction(
+    const Action &action, size_t rule_count, size_t state_count
+) {
+    switch (action.type_) {
+        case ActionType::SHIFT:
+            return action.value_ < state_count;
+        case ActionType::REDUCE:
+        case ActionType::SHIFT_REDUCE:
+            return action.value_ < rule_count;
+        case ActionType::ACCEPT:
+            return action.value_ == 0;
+        default:
+            // an empty type with a value decodes to ERROR, which is never
+            // stored, and the type bits past SHIFT_REDUCE to no type at all
+            return false;
+    }
+}
+
+std::string Hex(uint64_t v) {
+    char hex[17];
+    std::snprintf(
+        hex, sizeof(hex), "%016llx", static_cast<unsigned long long>(v)
+    );
+    return hex;
+}
+
+}  // namespace
+
+GenerationCacheError::GenerationCacheError(const std::string &msg)
+    : msg_(msg) {
+}
+
+const char *GenerationCacheError::what() const noexcept {
+    return msg_.c_str();
+}
+
+GenerationCache::GenerationCache(const std::string &folder) : folder_(folder) {
+    std::error_code ec;
+    std::filesystem::create_directories(folder_, ec);
+    if (ec) {
+        throw GenerationCacheError(
+            "Could not create cache directory " + folder_ + ": " + ec.message()
+        );
+    }
+}
+
+uint64_t GenerationCache::Key(
+    const std::string &grammar_text, const std::string &options
+) {
+    uint64_t hash = Fnv1a(std::to_string(kFormatVersion) + '\0');
+    hash = Fnv1a(options + '\0', hash);
+    return Fnv1a(grammar_text, hash);
+}
+
+std::optional<CacheEntry> GenerationCache::Load(uint64_t key) const {
+    std::ifstream in(PathFor(key), std::ios::binary);
+    if (!in) {
+        return std::nullopt;
+    }
+    std::string buf(
+        (std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>()
+    );
+    if (buf.compare(0, kMagic.size(), kMagic) != 0) {
+        throw GenerationCacheError("Not a cache entry: " + PathFor(key));
+    }
+    std::string header = buf.substr(kMagic.size());
+    Reader h(header);
+    if (h.Varint() != kFormatVersion) {
+        return std::nullopt;
+    }
+    // the table cells are range-checked below, but a flipped bit in a symbol
+    // name or a rule would still give a well-formed entry
+    uint64_t checksum = h.Fixed64();
+    std::string body = h.Rest();
+    if (Fnv1a(body) != checksum) {
+        throw GenerationCacheError("Checksum mismatch in cache entry");
+    }
+    Reader r(body);
+
+    CacheEntry entry;
+    r.SymbolTable();
+
+    Grammar &g = entry.grammar_;
+    for (uint64_t n = r.Varint(); n > 0; --n) {
+        Rule rule{r.NonTerminalSymbol(), {}};
+        for (uint64_t m = r.Varint(); m > 0; --m) {
+            rule.prod.push_back(r.Symbol());
+        }
+        g.rules_.push_back(rule);
+    }
+    for (uint64_t n = r.Varint(); n > 0; --n) {
+        g.tokens_.insert(r.Symbol());
+    }
+    for (uint64_t n = r.Varint(); n > 0; --n) {
+        g.ignored_.push_back(r.String());
+    }
+
+    for (uint64_t n = r.Varint(); n > 0; --n) {
+        std::set<Terminal> &first = entry.first_[r.Symbol()];
+        for (uint64_t m = r.Varint(); m > 0; --m) {
+            first.insert(r.TerminalSymbol());
+        }
+    }
+    for (uint64_t n = r.Varint(); n > 0; --n) {
+        std::set<Terminal> &follow = entry.follow_[r.NonTerminalSymbol()];
+        for (uint64_t m = r.Varint(); m > 0; --m) {
+            follow.insert(r.TerminalSymbol());
+        }
+    }
+
+    for (uint64_t n = r.Varint(), i = 0; i < n; ++i) {
+        Automaton::State state;
+        for (uint64_t m = r.Varint(); m > 0; --m) {
+            size_t rule_number = r.Varint();
+            size_t dot_pos = r.Varint();
+            if (rule_number >= g.rules_.size() ||
+                dot_pos > g.rules_[rule_number].prod.size()) {
+                throw GenerationCacheError("Malformed automaton state");
+            }
+            state.insert(Automaton::Item{
+                rule_number, dot_pos, r.TerminalSymbol()
+            });
+        }
+        entry.states_.insert({i, state});
+    }
+
+    entry.transitions_.resize(r.Varint());
+    for (auto &row : entry.transitions_) {
+        for (uint64_t m = r.Varint(); m > 0; --m) {
+            Token token = r.Symbol();
+            size_t target = r.Varint();
+            if (target >= entry.states_.size()) {
+                throw GenerationCacheError("Malformed automaton transition");
+            }
+            row[token] = target;
+        }
+    }
+
+    SymbolIds &ids = entry.tables_.symbols_;
+    for (uint64_t n = r.Varint(); n > 0; --n) {
+        ids.AddTerminal(r.TerminalSymbol());
+    }
+    for (uint64_t n = r.Varint(); n > 0; --n) {
+        ids.AddNonTerminal(r.NonTerminalSymbol());
+    }
+    // the tables are stored sparsely, as runs of empty cells followed by a
+    // non-empty cell
+    size_t state_count = r.Varint();
+    DenseActionTable &action = entry.tables_.action_;
+    action = DenseActionTable(state_count, ids.GetTerminalCount());
+    for (size_t i = 0; i < state_count; ++i) {
+        for (uint64_t m = r.Varint(), t = 0; m > 0; --m, ++t) {
+            t += r.Varint();
+            uint64_t cell = r.Varint();
+            if (t >= ids.GetTerminalCount() || cell > UINT32_MAX) {
+                throw GenerationCacheError("Malformed action table");
+            }
+            Action decoded = DenseActionTable::Decode(
+                static_cast<DenseActionTable::Cell>(cell)
+            );
+            if (!IsValidAction(decoded, g.rules_.size(), state_count)) {
+                throw GenerationCacheError("Malformed action table");
+            }
+            action.Set(i, t, decoded);
+        }
+    }
+    DenseGotoTable &goto_table = entry.tables_.goto_;
+    goto_table = DenseGotoTable(state_count, ids.GetNonTerminalCount());
+    for (size_t i = 0; i < state_count; ++i) {
+        for (uint64_t m = r.Varint(), nt = 0; m > 0; --m, ++nt) {
+            nt += r.Varint();
+            size_t target = r.Varint();
+            if (nt >= ids.GetNonTerminalCount() || target >= state_count) {
+                throw GenerationCacheError("Malformed goto table");
+            }
+            goto_table.Set(i, nt, target);
+        }
+    }
+
+    if (!r.AtEnd()) {
+        throw GenerationCacheError("Trailing data in cache entry");
+    }
+    return entry;
+}
+
+void GenerationCache::Store(uint64_t key, const CacheEntry &entry) const {
+    Writer w;
+
+    w.SymbolTable(CollectSymbols(entry));
+
+    const Grammar &g = entry.grammar_;
+    w.Varint(g.rules_.size());
+    for (const Rule &rule : g.rules_) {
+        w.Symbol(rule.lhs);
+        w.Varint(rule.prod.size());
+        for (const Token &token : rule.prod) {
+            w.Symbol(token);
+        }
+    }
+    w.Varint(g.tokens_.size());
+    for (const Token &token : g.tokens_) {
+        w.Symbol(token);
+    }
+    w.Varint(g.ignored_.size());
+    for (const std::string &regex : g.ignored_) {
+        w.String(regex);
+    }
+
+    w.Varint(entry.first_.size());
+    for (const auto &[token, first] : entry.first_) {
+        w.Symbol(token);
+        w.Varint(first.size());
+        for (const Terminal &t : first) {
+            w.Symbol(t);
+        }
+    }
+    w.Varint(entry.follow_.size());
+    for (const auto &[nt, follow] : entry.follow_) {
+        w.Symbol(nt);
+        w.Varint(follow.size());
+        for (const Terminal &t : follow) {
+            w.Symbol(t);
+        }
+    }
+
+    w.Varint(entry.states_.size());
+    for (size_t i = 0; i < entry.states_.size(); ++i) {
+        const Automaton::State &state = entry.states_.left.at(i);
+        w.Varint(state.size());
+        for (const Automaton::Item &item : state) {
+            w.Varint(item.rule_number_);
+            w.Varint(item.dot_pos_);
+            w.Symbol(item.lookahead_);
+        }
+    }
+
+    w.Varint(entry.transitions_.size());
+    for (const auto &row : entry.transitions_) {
+        w.Varint(row.size());
+        for (const auto &[token, target] : row) {
+            w.Symbol(token);
+            w.Varint(target);
+        }
+    }
+
+    const SymbolIds &ids = entry.tables_.symbols_;
+    w.Varint(ids.GetTerminalCount());
+    for (size_t i = 0; i < ids.GetTerminalCount(); ++i) {
+        w.Symbol(ids.GetTerminal(i));
+    }
+    w.Varint(ids.GetNonTerminalCount());
+    for (size_t i = 0; i < ids.GetNonTerminalCount(); ++i) {
+        w.Symbol(ids.GetNonTerminal(i));
+    }
+    const DenseActionTable &action = entry.tables_.action_;
+    const DenseGotoTable &goto_table = entry.tables_.goto_;
+    w.Varint(action.GetStateCount());
+    for (size_t i = 0; i < action.GetStateCount(); ++i) {
+        std::span<const DenseActionTable::Cell> row = action.GetRow(i);
+        w.Varint(std::count_if(row.begin(), row.end(), [](auto cell) {
+            return cell != 0;
+        }));
+        for (size_t t = 0, last = 0; t < row.size(); ++t) {
+            if (row[t] != 0) {
+                w.Varint(t - last);
+                w.Varint(row[t]);
+                last = t + 1;
+            }
+        }
+    }
+    for (size_t i = 0; i < action.GetStateCount(); ++i) {
+        if (i >= goto_table.GetStateCount()) {
+            w.Varint(0);
+            continue;
+        }
+        std::span<const DenseGotoTable::Cell> row = goto_table.GetRow(i);
+        w.Varint(std::count_if(row.begin(), row.end(), [](auto cell) {
+            return cell != DenseGotoTable::kNone;
+        }));
+        for (size_t nt = 0, last = 0; nt < row.size(); ++nt) {
+            if (row[nt] != DenseGotoTable::kNone) {
+                w.Varint(nt - last);
+                w.Varint(row[nt]);
+                last = nt + 1;
+            }
+        }
+    }
+
+    std::string path = PathFor(key);
+    std::string tmp_path = path + ".tmp";
+    {
+        std::ofstream out(tmp_path, std::ios::binary | std::ios::trunc);
+        Writer header;
+        header.Varint(kFormatVersion);
+        header.Fixed64(Fnv1a(w.Get()));
+        out << kMagic << header.Get() << w.Get();
+        if (!out) {
+            throw GenerationCacheError("Could not write cache entry " + path);
+        }
+    }
+    std::error_code ec;
+    std::filesystem::rename(tmp_path, path, ec);
+    if (ec) {
+        throw GenerationCacheError(
+            "Could not write cache entry " + path + ": " + ec.message()
+        );
+    }
+}
+
+void GenerationCache::MarkLatest(const std::string &source, uint64_t key)
+    const {
+    std::ofstream out(LatestPathFor(source), std::ios::trunc);
+    out << Hex(key) << "\n";
+    if (!out) {
+        throw GenerationCacheError(
+            "Could not write " + LatestPathFor(source)
+        );
+    }
+}
+
+std::optional<CacheEntry> GenerationCache::LoadLatest(const std::string &source
+) const {
+    std::ifstream in(LatestPathFor(source));
+    std::string hex;
+    if (!(in >> hex)) {
+        return std::nullopt;
+    }
+    try {
+        return Load(std::stoull(hex, nullptr, 16));
+    } catch (const std::logic_error &e) {
+        throw GenerationCacheError("Malformed " + LatestPathFor(source));
+    }
+}
+
+std::string GenerationCache::PathFor(uint64_t key) const {
+    return folder_ + "/" + Hex(key) + ".pgc";
+}
+
+std::string GenerationCache::LatestPathFor(const std::string &source) const {
+    std::error_code ec;
+    std::string path = std::filesystem::weakly_canonical(source, ec).string();
+    return folder_ + "/" + Hex(Fnv1a(ec ? source : path)) + ".latest";
+}
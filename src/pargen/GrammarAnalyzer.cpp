@@ -1,21 +1,186 @@
 #include "GrammarAnalyzer.h"
 
+#include <queue>
+#include <unordered_map>
+
 #include "Entities.h"
 #include "Helpers.h"
 
 GrammarAnalyzer::GrammarAnalyzer(const Grammar &g) : g_(g) {
-    ComputeFirst();
-    ComputeFollow();
+    ComputeFirst({}, {});
+    ComputeFollow({}, {});
 }
 
-void GrammarAnalyzer::ComputeFirst() {
+GrammarAnalyzer::GrammarAnalyzer(
+    const Grammar &g, const Grammar &prev_g, const FirstSets &prev_first,
+    const FollowSets &prev_follow
+)
+    : g_(g) {
+    std::vector<Rule> changed_rules = Diff(prev_g);
+
+    // a FIRST set only depends on the symbols of a production up to the
+    // first one that isn't nullable. The scan stops at an affected
+    // non-terminal, so it only needs the nullability of unaffected ones,
+    // which is the same in both grammars and is taken from the previous sets
+    std::unordered_set<NonTerminal> affected_first = diff_->changed_;
+    auto is_affected = [&](const Token &token) {
+        return IsNonTerminal(token) &&
+               (affected_first.contains(std::get<NonTerminal>(token)) ||
+                !prev_first.contains(token));
+    };
+    auto is_nullable = [&](const Token &token) {
+        if (IsTerminal(token)) {
+            return std::get<Terminal>(token) == EPSILON;
+        }
+        return prev_first.at(token).contains(EPSILON);
+    };
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (const Rule &rule : g_.rules_) {
+            if (affected_first.contains(rule.lhs)) {
+                continue;
+            }
+            for (const Token &token : rule.prod) {
+                if (is_affected(token)) {
+                    affected_first.insert(rule.lhs);
+                    changed = true;
+                    break;
+                }
+                if (!is_nullable(token)) {
+                    break;
+                }
+            }
+        }
+    }
+    ComputeFirst(prev_first, affected_first);
+
+    std::unordered_set<NonTerminal> affected_follow;
+    for (const Rule &rule : changed_rules) {
+        for (const Token &token : rule.prod) {
+            if (IsNonTerminal(token)) {
+                affected_follow.insert(std::get<NonTerminal>(token));
+            }
+        }
+    }
+    for (const Rule &rule : g_.rules_) {
+        for (size_t i = 0; i < rule.prod.size(); ++i) {
+            if (IsTerminal(rule.prod[i])) {
+                continue;
+            }
+            for (size_t j = i + 1; j < rule.prod.size(); ++j) {
+                if (is_affected(rule.prod[j])) {
+                    affected_follow.insert(std::get<NonTerminal>(rule.prod[i])
+                    );
+                    break;
+                }
+                if (!is_nullable(rule.prod[j])) {
+                    break;
+                }
+            }
+        }
+    }
+    changed = true;
+    while (changed) {
+        changed = false;
+        for (const Rule &rule : g_.rules_) {
+            if (!affected_follow.contains(rule.lhs)) {
+                continue;
+            }
+            for (const Token &token : rule.prod) {
+                if (IsNonTerminal(token) &&
+                    affected_follow.insert(std::get<NonTerminal>(token)).second) {
+                    changed = true;
+                }
+            }
+        }
+    }
+    ComputeFollow(prev_follow, affected_follow);
+
+    for (const auto &[token, first] : first_) {
+        if (IsTerminal(token)) {
+            continue;
+        }
+        auto it = prev_first.find(token);
+        if (it == prev_first.end() || it->second != first) {
+            diff_->changed_.insert(std::get<NonTerminal>(token));
+        }
+    }
+    for (const auto &[token, first] : first_) {
+        if (IsNonTerminal(token)) {
+            const NonTerminal &nt = std::get<NonTerminal>(token);
+            diff_->recomputed_first_ += affected_first.contains(nt);
+        }
+    }
+    for (const auto &[nt, follow] : follow_) {
+        diff_->recomputed_follow_ += affected_follow.contains(nt);
+    }
+}
+
+std::vector<Rule> GrammarAnalyzer::Diff(const Grammar &prev_g) {
+    auto key = [](const Rule &rule) {
+        std::string k = QualName(rule.lhs);
+        for (const Token &token : rule.prod) {
+            k += '\x1f';
+            k += QualName(token);
+        }
+        return k;
+    };
+
+    std::unordered_map<std::string, std::queue<size_t>> current;
+    for (size_t i = 0; i < g_.rules_.size(); ++i) {
+        current[key(g_[i])].push(i);
+    }
+
+    diff_.emplace();
+    diff_->rule_mapping_.resize(prev_g.rules_.size());
+    std::vector<bool> matched(g_.rules_.size(), false);
+    std::vector<Rule> changed_rules;
+    for (size_t j = 0; j < prev_g.rules_.size(); ++j) {
+        auto it = current.find(key(prev_g[j]));
+        if (it != current.end() && !it->second.empty()) {
+            size_t i = it->second.front();
+            it->second.pop();
+            diff_->rule_mapping_[j] = i;
+            matched[i] = true;
+        } else {
+            changed_rules.push_back(prev_g[j]);
+        }
+    }
+    for (size_t i = 0; i < g_.rules_.size(); ++i) {
+        if (!matched[i]) {
+            changed_rules.push_back(g_[i]);
+        }
+    }
+    for (const Rule &rule : changed_rules) {
+        diff_->changed_.insert(rule.lhs);
+    }
+    return changed_rules;
+}
+
+void GrammarAnalyzer::ComputeFirst(
+    const FirstSets &prev_first,
+    const std::unordered_set<NonTerminal> &affected
+) {
+    auto seed = [&](const Token &token) {
+        auto it = prev_first.find(token);
+        if (it != prev_first.end() &&
+            !affected.contains(std::get<NonTerminal>(token))) {
+            first_[token] = it->second;
+        } else {
+            first_[token] = {};
+        }
+    };
     for (const Token &token : g_.tokens_) {
         if (IsTerminal(token)) {
             first_[token] = {std::get<Terminal>(token)};
         } else {
-            first_[token] = {};
+            seed(token);
         }
     }
+    for (const Rule &rule : g_.rules_) {
+        seed(rule.lhs);
+    }
     first_[EPSILON] = {EPSILON};
 
     bool changed = true;
@@ -81,8 +246,25 @@ std::set<Terminal> GrammarAnalyzer::FirstForSequence(
     return result;
 }
 
-void GrammarAnalyzer::ComputeFollow() {
-    follow_[g_[0].lhs] = {T_EOF};
+void GrammarAnalyzer::ComputeFollow(
+    const FollowSets &prev_follow,
+    const std::unordered_set<NonTerminal> &affected
+) {
+    std::unordered_set<NonTerminal> present;
+    for (const Rule &rule : g_.rules_) {
+        present.insert(rule.lhs);
+        for (const Token &token : rule.prod) {
+            if (IsNonTerminal(token)) {
+                present.insert(std::get<NonTerminal>(token));
+            }
+        }
+    }
+    for (const auto &[nt, follow] : prev_follow) {
+        if (present.contains(nt) && !affected.contains(nt)) {
+            follow_[nt] = follow;
+        }
+    }
+    follow_[g_[0].lhs].insert(T_EOF);
     bool changed = true;
     while (changed) {
         changed = false;
@@ -124,4 +306,8 @@ const FirstSets &GrammarAnalyzer::GetFirst() const {
 
 const FollowSets &GrammarAnalyzer::GetFollow() const {
     return follow_;
+}
+
+const std::optional<GrammarDiff> &GrammarAnalyzer::GetDiff() const {
+    return diff_;
 }
\ No newline at end of file
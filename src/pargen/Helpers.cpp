@@ -19,4 +19,31 @@ std::string QualName(Token token) {
     } else {
         return "NT_" + std::get<NonTerminal>(token).name_;
     }
-}
\ No newline at end of file
+}
+
+std::string DescribeToken(const Token &token) {
+    if (IsNonTerminal(token)) {
+        return "<" + std::get<NonTerminal>(token).name_ + ">";
+    }
+    const Terminal &t = std::get<Terminal>(token);
+    if (t == EPSILON) {
+        return "EPSILON";
+    } else if (t.IsQuote()) {
+        return "'" + t.name_ + "'";
+    }
+    return t.name_;
+}
+
+std::string DescribeRule(const Rule &rule, std::optional<size_t> dot) {
+    std::string s = DescribeToken(rule.lhs) + " =";
+    for (size_t i = 0; i < rule.prod.size(); ++i) {
+        if (dot == i) {
+            s += " .";
+        }
+        s += " " + DescribeToken(rule.prod[i]);
+    }
+    if (dot == rule.prod.size()) {
+        s += " .";
+    }
+    return s;
+}
@@ -0,0 +1,53 @@
+#include "LLTableBuilder.h"
+
+#include "Helpers.h"
+
+LLParserTables::LLParserTables(const Grammar &g, const GrammarAnalyzer &ga)
+    : g_(g), ga_(ga) {
+}
+
+void LLParserTables::Generate() {
+    table_.clear();
+    conflicts_.clear();
+    // the augmented rule `S' = S` is never expanded, the parser starts from S
+    for (size_t i = 1; i < g_.rules_.size(); ++i) {
+        const Rule &rule = g_[i];
+        std::set<Terminal> predict = ga_.FirstForSequence(rule.prod);
+        if (predict.contains(EPSILON)) {
+            predict.erase(EPSILON);
+            const std::set<Terminal> &follow = ga_.GetFollow().at(rule.lhs);
+            predict.insert(follow.begin(), follow.end());
+        }
+
+        auto &row = table_[rule.lhs];
+        for (const Terminal &t : predict) {
+            auto [it, inserted] = row.emplace(QualName(t), i);
+            if (!inserted && it->second != i) {
+                conflicts_.push_back(LLConflict{rule.lhs, t, it->second, i});
+            }
+        }
+    }
+}
+
+bool LLParserTables::IsLL1() const {
+    return conflicts_.empty();
+}
+
+const std::vector<LLConflict> &LLParserTables::GetConflicts() const {
+    return conflicts_;
+}
+
+std::string LLParserTables::DescribeConflicts() const {
+    std::string result;
+    for (const LLConflict &conflict : conflicts_) {
+        result += "<" + conflict.nt_.name_ + "> on " +
+                  QualName(conflict.lookahead_) + ": `" +
+                  DescribeRule(g_[conflict.first_rule_]) + "` vs `" +
+                  DescribeRule(g_[conflict.second_rule_]) + "`\n";
+    }
+    return result;
+}
+
+const PredictTable &LLParserTables::GetTable() const {
+    return table_;
+}
@@ -0,0 +1,129 @@
+#include "LayoutProfile.h"
+
+#include <sstream>
+
+namespace {
+const std::string kHeader = "pargen-profile";
+
+uint64_t HashWord(uint64_t word, uint64_t hash) {
+    for (size_t i = 0; i < sizeof(word); ++i) {
+        hash ^= (word >> (8 * i)) & 0xff;
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+template <typename Cells>
+uint64_t HashCells(const Cells &cells, uint64_t hash) {
+    hash = HashWord(cells.size(), hash);
+    for (auto cell : cells) {
+        hash = HashWord(cell, hash);
+    }
+    return hash;
+}
+}  // namespace
+
+LayoutProfileError::LayoutProfileError(const std::string &msg) : msg_(msg) {
+}
+
+const char *LayoutProfileError::what() const noexcept {
+    return msg_.c_str();
+}
+
+LayoutProfile::LayoutProfile(uint64_t fingerprint, size_t states)
+    : fingerprint_(fingerprint), state_visits_(states, 0) {
+}
+
+LayoutProfile LayoutProfile::Read(std::istream &in) {
+    std::string header;
+    uint32_t version = 0;
+    uint64_t fingerprint = 0;
+    size_t states = 0;
+    if (!(in >> header) || header != kHeader) {
+        throw LayoutProfileError("Not a parser profile");
+    }
+    if (!(in >> version) || version != kVersion) {
+        throw LayoutProfileError(
+            "Parser profile version " + std::to_string(version) +
+            " is not supported, expected " + std::to_string(kVersion)
+        );
+    }
+    if (!(in >> std::hex >> fingerprint >> std::dec >> states)) {
+        throw LayoutProfileError("Malformed parser profile header");
+    }
+    LayoutProfile profile(fingerprint, states);
+
+    std::string line;
+    std::getline(in, line);
+    size_t line_number = 1;
+    while (std::getline(in, line)) {
+        ++line_number;
+        if (line.empty()) {
+            continue;
+        }
+        std::istringstream fields(line);
+        std::string kind;
+        size_t first = 0;
+        size_t count = 0;
+        fields >> kind;
+        if (kind == "state" && fields >> first >> count) {
+            profile.AddStateVisits(first, count);
+            continue;
+        }
+        // the qualified name is the rest of the line, as quoted terminals may
+        // contain spaces
+        if (kind == "terminal" && fields >> count && fields.get() == ' ') {
+            std::string name;
+            std::getline(fields, name);
+            if (!name.empty()) {
+                profile.AddTerminalShifts(name, count);
+                continue;
+            }
+        }
+        throw LayoutProfileError(
+            "Malformed parser profile entry on line " +
+            std::to_string(line_number)
+        );
+    }
+    return profile;
+}
+
+uint64_t LayoutProfile::Fingerprint(const DenseTables &tables) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    hash = HashWord(tables.action_.GetTerminalCount(), hash);
+    hash = HashCells(tables.action_.GetCells(), hash);
+    hash = HashCells(tables.action_.GetDefaults(), hash);
+    hash = HashCells(tables.goto_.GetCells(), hash);
+    hash = HashCells(tables.terminal_classes_, hash);
+    return hash;
+}
+
+uint64_t LayoutProfile::GetFingerprint() const {
+    return fingerprint_;
+}
+
+size_t LayoutProfile::GetStateCount() const {
+    return state_visits_.size();
+}
+
+size_t LayoutProfile::GetStateVisits(size_t state) const {
+    return state < state_visits_.size() ? state_visits_[state] : 0;
+}
+
+size_t LayoutProfile::GetTerminalShifts(const std::string &name) const {
+    auto it = terminal_shifts_.find(name);
+    return it == terminal_shifts_.end() ? 0 : it->second;
+}
+
+void LayoutProfile::AddStateVisits(size_t state, size_t count) {
+    if (state >= state_visits_.size()) {
+        throw LayoutProfileError(
+            "Parser profile has no state " + std::to_string(state)
+        );
+    }
+    state_visits_[state] += count;
+}
+
+void LayoutProfile::AddTerminalShifts(const std::string &name, size_t count) {
+    terminal_shifts_[name] += count;
+}
@@ -0,0 +1,343 @@
+#include "StackAnalyzer.h"
+
+#include <algorithm>
+#include <limits>
+#include <map>
+#include <queue>
+#include <tuple>
+#include <utility>
+
+#include "Helpers.h"
+
+namespace {
+/**
+ * @brief Finds the strongly connected components of a graph (iterative
+ * Tarjan's algorithm).
+ * @param adj The adjacency lists of the graph.
+ * @return The component of every vertex. Components are numbered in reverse
+ * topological order, so every edge goes to a component with a number not
+ * greater than the one it leaves.
+ */
+std::vector<size_t> StronglyConnectedComponents(
+    const std::vector<std::vector<size_t>> &adj
+) {
+    const size_t unvisited = std::numeric_limits<size_t>::max();
+    size_t n = adj.size();
+    std::vector<size_t> index(n, unvisited), low(n, 0), comp(n, unvisited);
+    std::vector<bool> on_stack(n, false);
+    std::vector<size_t> stack;
+    std::vector<std::pair<size_t, size_t>> call_stack;
+    size_t next_index = 0;
+    size_t next_comp = 0;
+
+    for (size_t root = 0; root < n; ++root) {
+        if (index[root] != unvisited) {
+            continue;
+        }
+        call_stack.emplace_back(root, 0);
+        while (!call_stack.empty()) {
+            auto &[v, edge] = call_stack.back();
+            if (edge == 0) {
+                index[v] = low[v] = next_index++;
+                stack.push_back(v);
+                on_stack[v] = true;
+            }
+            if (edge < adj[v].size()) {
+                size_t w = adj[v][edge++];
+                if (index[w] == unvisited) {
+                    call_stack.emplace_back(w, 0);
+                } else if (on_stack[w]) {
+                    low[v] = std::min(low[v], index[w]);
+                }
+                continue;
+            }
+            if (low[v] == index[v]) {
+                size_t w;
+                do {
+                    w = stack.back();
+                    stack.pop_back();
+                    on_stack[w] = false;
+                    comp[w] = next_comp;
+                } while (w != v);
+                ++next_comp;
+            }
+            size_t finished = v;
+            call_stack.pop_back();
+            if (!call_stack.empty()) {
+                size_t parent = call_stack.back().first;
+                low[parent] = std::min(low[parent], low[finished]);
+            }
+        }
+    }
+    return comp;
+}
+
+std::string KindName(RecursionKind kind) {
+    switch (kind) {
+        case RecursionKind::NONE:
+            return "not recursive";
+        case RecursionKind::LEFT:
+            return "left-recursive";
+        case RecursionKind::RIGHT:
+            return "right-recursive";
+        case RecursionKind::NESTED:
+            return "self-embedding";
+    }
+    return "";
+}
+}  // namespace
+
+StackAnalyzer::StackAnalyzer(
+    const Grammar &g, const GrammarAnalyzer &ga,
+    const Automaton::Transitions &transitions
+)
+    : g_(g), ga_(ga), transitions_(transitions) {
+    AnalyzeGrammar();
+    AnalyzeAutomaton();
+}
+
+const std::vector<RecursionInfo> &StackAnalyzer::GetRecursion() const {
+    return recursion_;
+}
+
+const std::vector<StackCycle> &StackAnalyzer::GetCycles() const {
+    return cycles_;
+}
+
+std::optional<size_t> StackAnalyzer::GetMaxDepth() const {
+    return max_depth_;
+}
+
+void StackAnalyzer::AnalyzeGrammar() {
+    std::map<NonTerminal, size_t> ids;
+    std::vector<NonTerminal> nts;
+    for (const Rule &rule : g_.rules_) {
+        if (ids.emplace(rule.lhs, nts.size()).second) {
+            nts.push_back(rule.lhs);
+        }
+    }
+
+    struct Edge {
+        size_t rule_;
+        size_t pos_;
+        size_t target_;
+        RecursionKind kind_;
+    };
+    std::vector<std::vector<Edge>> edges(nts.size());
+    std::vector<std::vector<size_t>> adj(nts.size());
+    for (size_t r = 0; r < g_.rules_.size(); ++r) {
+        const Rule &rule = g_[r];
+        size_t lhs = ids.at(rule.lhs);
+        for (size_t pos = 0; pos < rule.prod.size(); ++pos) {
+            if (!IsNonTerminal(rule.prod[pos])) {
+                continue;
+            }
+            auto it = ids.find(std::get<NonTerminal>(rule.prod[pos]));
+            if (it == ids.end()) {
+                continue;
+            }
+            RecursionKind kind;
+            Production suffix(rule.prod.begin() + pos + 1, rule.prod.end());
+            if (pos == 0) {
+                kind = RecursionKind::LEFT;
+            } else if (suffix.empty() ||
+                       ga_.FirstForSequence(suffix).contains(EPSILON)) {
+                kind = RecursionKind::RIGHT;
+            } else {
+                kind = RecursionKind::NESTED;
+            }
+            edges[lhs].push_back(Edge{r, pos, it->second, kind});
+            adj[lhs].push_back(it->second);
+        }
+    }
+    std::vector<size_t> comp = StronglyConnectedComponents(adj);
+
+    std::vector<RecursionInfo> info(nts.size());
+    for (size_t nt = 0; nt < nts.size(); ++nt) {
+        info[nt] = RecursionInfo{nts[nt], RecursionKind::NONE, {}};
+        for (const Edge &edge : edges[nt]) {
+            if (comp[edge.target_] == comp[nt]) {
+                info[nt].sites_.push_back(
+                    GrowthSite{edge.rule_, edge.pos_, edge.kind_, edge.pos_}
+                );
+            }
+        }
+        if (info[nt].sites_.empty()) {
+            continue;
+        }
+
+        // follow every derivation `A => α A β` within the component, tracking
+        // whether α is non-empty (the stack grows) and whether β is not
+        // nullable (the recursion is nested rather than a tail)
+        using Path = std::tuple<size_t, bool, bool>;
+        std::set<Path> visited;
+        std::queue<Path> queue;
+        queue.emplace(nt, false, false);
+        while (!queue.empty()) {
+            auto [v, grows, nested] = queue.front();
+            queue.pop();
+            for (const Edge &edge : edges[v]) {
+                if (comp[edge.target_] != comp[nt]) {
+                    continue;
+                }
+                bool next_grows = grows || edge.kind_ != RecursionKind::LEFT;
+                bool next_nested =
+                    nested || edge.kind_ == RecursionKind::NESTED;
+                if (edge.target_ == nt) {
+                    RecursionKind kind = RecursionKind::LEFT;
+                    if (next_grows) {
+                        kind = next_nested ? RecursionKind::NESTED
+                                           : RecursionKind::RIGHT;
+                    }
+                    info[nt].kind_ = std::max(info[nt].kind_, kind);
+                    continue;
+                }
+                Path next{edge.target_, next_grows, next_nested};
+                if (visited.insert(next).second) {
+                    queue.push(next);
+                }
+            }
+        }
+    }
+
+    recursion_.clear();
+    for (RecursionInfo &nt_info : info) {
+        if (nt_info.kind_ != RecursionKind::NONE) {
+            recursion_.push_back(std::move(nt_info));
+        }
+    }
+}
+
+void StackAnalyzer::AnalyzeAutomaton() {
+    size_t n = transitions_.size();
+    std::vector<std::vector<size_t>> adj(n);
+    for (size_t i = 0; i < n; ++i) {
+        for (const auto &[token, target] : transitions_[i]) {
+            adj[i].push_back(target);
+        }
+    }
+    std::vector<size_t> comp = StronglyConnectedComponents(adj);
+
+    size_t comp_count = 0;
+    for (size_t c : comp) {
+        comp_count = std::max(comp_count, c + 1);
+    }
+    std::vector<std::vector<size_t>> members(comp_count);
+    for (size_t i = 0; i < n; ++i) {
+        members[comp[i]].push_back(i);
+    }
+
+    cycles_.clear();
+    for (const std::vector<size_t> &states : members) {
+        StackCycle cycle{states, {}, std::numeric_limits<size_t>::max()};
+        for (size_t s : states) {
+            for (const auto &[token, target] : transitions_[s]) {
+                if (comp[target] == comp[s]) {
+                    cycle.tokens_.insert(token);
+                }
+            }
+        }
+        if (cycle.tokens_.empty()) {
+            continue;
+        }
+        // the shortest cycle through every state, searching no deeper than
+        // the best one found so far
+        for (size_t s : states) {
+            std::map<size_t, size_t> dist{{s, 0}};
+            std::queue<size_t> queue;
+            queue.push(s);
+            while (!queue.empty()) {
+                size_t v = queue.front();
+                queue.pop();
+                if (dist[v] + 1 >= cycle.min_growth_) {
+                    break;
+                }
+                for (size_t w : adj[v]) {
+                    if (comp[w] != comp[s]) {
+                        continue;
+                    }
+                    if (w == s) {
+                        cycle.min_growth_ = dist[v] + 1;
+                        break;
+                    }
+                    if (dist.emplace(w, dist[v] + 1).second) {
+                        queue.push(w);
+                    }
+                }
+            }
+        }
+        cycles_.push_back(std::move(cycle));
+    }
+
+    max_depth_.reset();
+    if (!cycles_.empty() || n == 0) {
+        return;
+    }
+    // components are numbered in reverse topological order, so the targets of
+    // the transitions of a state are processed before the state itself
+    std::vector<size_t> order(n);
+    for (size_t i = 0; i < n; ++i) {
+        order[i] = i;
+    }
+    std::sort(order.begin(), order.end(), [&comp](size_t lhs, size_t rhs) {
+        return comp[lhs] < comp[rhs];
+    });
+    std::vector<size_t> longest(n, 0);
+    for (size_t v : order) {
+        for (size_t w : adj[v]) {
+            longest[v] = std::max(longest[v], longest[w] + 1);
+        }
+    }
+    // the initial state is on the stack before any transition is taken
+    max_depth_ = longest[0] + 1;
+}
+
+std::string StackAnalyzer::Describe() const {
+    std::string result;
+    if (max_depth_.has_value()) {
+        result += "The parser stack is bounded by " +
+                  std::to_string(max_depth_.value()) + " entries.\n";
+    } else {
+        result += "The parser stack grows with the input.\n";
+    }
+
+    for (const RecursionInfo &info : recursion_) {
+        result += DescribeToken(info.nt_) + " is " + KindName(info.kind_);
+        if (info.kind_ == RecursionKind::LEFT) {
+            result += ", the stack it needs is bounded";
+        }
+        result += ":\n";
+        for (const GrowthSite &site : info.sites_) {
+            result += "    " + DescribeRule(g_[site.rule_], site.pos_);
+            if (site.entries_per_element_ == 0) {
+                result += " reuses the stack\n";
+                continue;
+            }
+            result += " keeps " + std::to_string(site.entries_per_element_) +
+                      (site.entries_per_element_ == 1 ? " entry" : " entries") +
+                      (site.kind_ == RecursionKind::NESTED
+                           ? " per nesting level\n"
+                           : " per element\n");
+        }
+    }
+
+    for (const StackCycle &cycle : cycles_) {
+        result += "States";
+        for (size_t s : cycle.states_) {
+            result += " " + std::to_string(s);
+        }
+        result += " form a cycle on";
+        // a regex terminal may be stored both with its definition and as a
+        // reference, both are printed the same way
+        std::set<std::string> tokens;
+        for (const Token &token : cycle.tokens_) {
+            if (tokens.insert(DescribeToken(token)).second) {
+                result += " " + DescribeToken(token);
+            }
+        }
+        result += ", pushing at least " + std::to_string(cycle.min_growth_) +
+                  (cycle.min_growth_ == 1 ? " entry" : " entries") +
+                  " per repetition\n";
+    }
+    return result;
+}
@@ -1,5 +1,7 @@
 #include "TableBuilder.h"
 
+#include <utility>
+
 #include "Entities.h"
 #include "GrammarAnalyzer.h"
 #include "Helpers.h"
@@ -11,125 +13,158 @@ const char *TableGeneratorError::what() const noexcept {
     return msg_.c_str();
 }
 
-ParserTables::ParserTables(const Grammar &g, const GrammarAnalyzer &ga)
-    : g_(g), automaton_(g, ga), states_(automaton_.GetStates()) {
+ParserTables::ParserTables(
+    const Grammar &g, const GrammarAnalyzer &ga,
+    const AutomatonLimits &limits
+)
+    : automaton_(g, ga, limits), g_(g) {
+}
+
+ParserTables::ParserTables(
+    const Grammar &g, const GrammarAnalyzer &ga,
+    const Automaton::StateMap &prev_states,
+    const Automaton::Transitions &prev_transitions,
+    const AutomatonLimits &limits
+)
+    : automaton_(g, ga, prev_states, prev_transitions, limits), g_(g) {
 }
 
 void ParserTables::Generate() {
+    tables_.symbols_ = SymbolIds(g_);
     BuildActionTable();
     BuildGotoTable();
 }
 
+const DenseTables &ParserTables::GetTables() const {
+    return tables_;
+}
+
+DenseTables ParserTables::TakeTables() {
+    return std::move(tables_);
+}
+
 ActionTable ParserTables::GetActionTable() const {
-    return action_;
+    return tables_.ToActionTable();
 }
 
 GotoTable ParserTables::GetGotoTable() const {
-    return goto_;
+    return tables_.ToGotoTable();
+}
+
+const Automaton::StateMap &ParserTables::GetStates() const {
+    return automaton_.GetStates();
+}
+
+const Automaton::Transitions &ParserTables::GetTransitions() const {
+    return automaton_.GetTransitions();
+}
+
+size_t ParserTables::GetReusedStates() const {
+    return automaton_.GetReusedStates();
+}
+
+const Automaton &ParserTables::GetAutomaton() const {
+    return automaton_;
 }
 
 void ParserTables::BuildActionTable() {
-    action_.resize(states_.size());
-    for (size_t i = 0; i < states_.size(); ++i) {
-        for (const Automaton::Item &item : states_.left.at(i)) {
+    const Automaton::Transitions &transitions = automaton_.GetTransitions();
+    const Automaton::StateMap &states = automaton_.GetStates();
+    const SymbolIds &symbols = tables_.symbols_;
+    DenseActionTable &action = tables_.action_;
+    action = DenseActionTable(states.size(), symbols.GetTerminalCount());
+    for (size_t i = 0; i < states.size(); ++i) {
+        for (const Automaton::Item &item : states.left.at(i)) {
             std::optional<Token> next_token_opt = automaton_.NextToken(item);
             if (next_token_opt.has_value()) {
                 Token next_token = next_token_opt.value();
                 if (IsTerminal(next_token)) {
-                    Automaton::State next_state =
-                        automaton_.Goto(states_.left.at(i), next_token);
-                    size_t next_state_j = 0;
-                    if (states_.right.find(next_state) != states_.right.end()) {
-                        next_state_j = states_.right.at(next_state);
-                    }
                     if (std::get<Terminal>(next_token) != EPSILON) {
-                        std::string key =
-                            QualName(std::get<Terminal>(next_token));
+                        size_t next_state_j = transitions[i].at(next_token);
+                        size_t key = symbols.GetTerminalId(
+                            std::get<Terminal>(next_token)
+                        );
                         Action new_action{ActionType::SHIFT, next_state_j};
-                        if (action_[i].find(key) != action_[i].end()) {
-                            Action existing = action_[i][key];
-                            if (existing.type_ == ActionType::REDUCE) {
-                                throw TableGeneratorError(
-                                    "Provided grammar is ambiguous "
-                                    "(shift/reduce conflict on token: " +
-                                    key + ")"
-                                );
-                            }
-                            if (existing.type_ == ActionType::SHIFT &&
-                                existing.value_ != new_action.value_) {
-                                throw TableGeneratorError(
-                                    "Provided grammar is ambiguous "
-                                    "(shift/shift conflict on token: " +
-                                    key + ")"
-                                );
-                            }
+                        Action existing = action.Get(i, key);
+                        if (existing.type_ == ActionType::REDUCE) {
+                            throw TableGeneratorError(
+                                "Provided grammar is ambiguous "
+                                "(shift/reduce conflict on token: " +
+                                symbols.GetTerminalName(key) + ")"
+                            );
+                        }
+                        if (existing.type_ == ActionType::SHIFT &&
+                            existing.value_ != new_action.value_) {
+                            throw TableGeneratorError(
+                                "Provided grammar is ambiguous "
+                                "(shift/shift conflict on token: " +
+                                symbols.GetTerminalName(key) + ")"
+                            );
                         }
-                        action_[i][key] = new_action;
+                        action.Set(i, key, new_action);
                     } else {
-                        std::string key = QualName(item.lookahead_);
+                        size_t key = symbols.GetTerminalId(item.lookahead_);
                         Action new_action{
                             ActionType::REDUCE, item.rule_number_
                         };
-                        if (action_[i].find(key) != action_[i].end()) {
-                            Action existing = action_[i][key];
-                            if (existing.type_ == ActionType::SHIFT) {
-                                throw TableGeneratorError(
-                                    "Provided grammar is ambiguous "
-                                    "(shift/reduce conflict on token: " +
-                                    key + ")"
-                                );
-                            }
-                            if (existing.type_ == ActionType::REDUCE &&
-                                existing.value_ != new_action.value_) {
-                                throw TableGeneratorError(
-                                    "Provided grammar is ambiguous "
-                                    "(reduce/reduce conflict on token: " +
-                                    key + ")"
-                                );
-                            }
+                        Action existing = action.Get(i, key);
+                        if (existing.type_ == ActionType::SHIFT) {
+                            throw TableGeneratorError(
+                                "Provided grammar is ambiguous "
+                                "(shift/reduce conflict on token: " +
+                                symbols.GetTerminalName(key) + ")"
+                            );
                         }
-                        action_[i][key] = new_action;
+                        if (existing.type_ == ActionType::REDUCE &&
+                            existing.value_ != new_action.value_) {
+                            throw TableGeneratorError(
+                                "Provided grammar is ambiguous "
+                                "(reduce/reduce conflict on token: " +
+                                symbols.GetTerminalName(key) + ")"
+                            );
+                        }
+                        action.Set(i, key, new_action);
                     }
                 }
             } else {
-                std::string key;
+                size_t key;
                 Action new_action;
                 if (item.rule_number_ != 0) {
-                    key = QualName(item.lookahead_);
+                    key = symbols.GetTerminalId(item.lookahead_);
                     new_action = Action{ActionType::REDUCE, item.rule_number_};
                 } else {
-                    key = QualName(T_EOF);
+                    key = symbols.GetTerminalId(T_EOF);
                     new_action = Action{ActionType::ACCEPT};
                 }
-                if (action_[i].find(key) != action_[i].end()) {
-                    Action existing = action_[i][key];
-                    if (existing.type_ == ActionType::SHIFT ||
-                        (existing.type_ == ActionType::REDUCE &&
-                         existing.value_ != new_action.value_)) {
-                        throw TableGeneratorError(
-                            "Provided grammar is ambiguous (conflict in action "
-                            "table on token: " +
-                            key + ")"
-                        );
-                    }
+                Action existing = action.Get(i, key);
+                if (existing.type_ == ActionType::SHIFT ||
+                    (existing.type_ == ActionType::REDUCE &&
+                     existing.value_ != new_action.value_)) {
+                    throw TableGeneratorError(
+                        "Provided grammar is ambiguous (conflict in action "
+                        "table on token: " +
+                        symbols.GetTerminalName(key) + ")"
+                    );
                 }
-                action_[i][key] = new_action;
+                action.Set(i, key, new_action);
             }
         }
     }
 }
 
 void ParserTables::BuildGotoTable() {
-    for (size_t i = 0; i < states_.size(); ++i) {
-        for (const Token &token : g_.tokens_) {
-            if (IsTerminal(token)) {
-                continue;
-            }
-            NonTerminal nt = std::get<NonTerminal>(token);
-            Automaton::State state = automaton_.Goto(states_.left.at(i), nt);
-            if (states_.right.find(state) != states_.right.end()) {
-                goto_[i][nt] = states_.right.at(state);
+    const Automaton::Transitions &transitions = automaton_.GetTransitions();
+    const SymbolIds &symbols = tables_.symbols_;
+    tables_.goto_ =
+        DenseGotoTable(transitions.size(), symbols.GetNonTerminalCount());
+    for (size_t i = 0; i < transitions.size(); ++i) {
+        for (const auto &[token, target] : transitions[i]) {
+            if (IsNonTerminal(token)) {
+                tables_.goto_.Set(
+                    i, symbols.GetNonTerminalId(std::get<NonTerminal>(token)),
+                    target
+                );
             }
         }
     }
-}
\ No newline at end of file
+}
@@ -0,0 +1,283 @@
+#include "TableBundle.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <numeric>
+
+#include "CombTables.h"
+#include "Helpers.h"
+
+namespace {
+const char kMagic[4] = {'P', 'G', 'T', 'B'};
+
+size_t SectionIndex(BundleSection section) {
+    return static_cast<size_t>(section);
+}
+}  // namespace
+
+TableBundleError::TableBundleError(const std::string &msg) : msg_(msg) {
+}
+
+const char *TableBundleError::what() const noexcept {
+    return msg_.c_str();
+}
+
+TableBundle::TableBundle(
+    const Grammar &g, const DenseTables &tables, const FollowSets &fs
+) {
+    const SymbolIds &symbols = tables.symbols_;
+    const size_t section_count = SectionIndex(BundleSection::COUNT);
+    std::string strings;
+    std::vector<std::vector<uint32_t>> sections(section_count);
+    auto section = [&sections](BundleSection s) -> std::vector<uint32_t> & {
+        return sections[SectionIndex(s)];
+    };
+    auto add_string = [&strings](const std::string &s, auto &words) {
+        words.push_back(static_cast<uint32_t>(strings.size()));
+        words.push_back(static_cast<uint32_t>(s.size()));
+        strings += s;
+    };
+
+    size_t terminals = symbols.GetTerminalCount();
+    for (size_t t = 0; t < terminals; ++t) {
+        add_string(
+            symbols.GetTerminalName(t), section(BundleSection::TERMINALS)
+        );
+    }
+    std::vector<uint32_t> &order = section(BundleSection::TERMINAL_ORDER);
+    order.resize(terminals);
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&symbols](uint32_t a, uint32_t b) {
+        return symbols.GetTerminalName(a) < symbols.GetTerminalName(b);
+    });
+    size_t nonterminals = symbols.GetNonTerminalCount();
+    for (size_t nt = 0; nt < nonterminals; ++nt) {
+        add_string(
+            symbols.GetNonTerminal(nt).name_,
+            section(BundleSection::NONTERMINALS)
+        );
+    }
+
+    std::vector<uint32_t> &rules = section(BundleSection::RULES);
+    std::vector<uint32_t> &rule_symbols = section(BundleSection::SYMBOLS);
+    for (const Rule &rule : g.rules_) {
+        rules.push_back(
+            static_cast<uint32_t>(symbols.GetNonTerminalId(rule.lhs))
+        );
+        rules.push_back(static_cast<uint32_t>(rule_symbols.size()));
+        if (rule.prod.size() == 1 && rule.prod[0] == Token(EPSILON)) {
+            rules.push_back(0);
+            continue;
+        }
+        rules.push_back(static_cast<uint32_t>(rule.prod.size()));
+        for (const Token &token : rule.prod) {
+            if (IsTerminal(token)) {
+                rule_symbols.push_back(static_cast<uint32_t>(
+                    2 * symbols.GetTerminalId(std::get<Terminal>(token))
+                ));
+            } else {
+                const NonTerminal &nt = std::get<NonTerminal>(token);
+                rule_symbols.push_back(
+                    static_cast<uint32_t>(2 * symbols.GetNonTerminalId(nt) + 1)
+                );
+            }
+        }
+    }
+
+    CombTables comb(tables);
+    section(BundleSection::BASE) = comb.GetBase();
+    section(BundleSection::NEXT) = comb.GetNext();
+    section(BundleSection::CHECK) = comb.GetCheck();
+    section(BundleSection::DEFAULTS) = comb.GetDefaults();
+    section(BundleSection::DEFAULT_ONLY) = comb.GetDefaultOnly();
+    section(BundleSection::TERMINAL_CLASSES) = comb.GetTerminalClasses();
+
+    std::vector<uint32_t> &follow_index = section(BundleSection::FOLLOW_INDEX);
+    std::vector<uint32_t> &follow = section(BundleSection::FOLLOW);
+    for (size_t nt = 0; nt < nonterminals; ++nt) {
+        follow_index.push_back(static_cast<uint32_t>(follow.size()));
+        auto it = fs.find(symbols.GetNonTerminal(nt));
+        if (it == fs.end()) {
+            continue;
+        }
+        for (const Terminal &t : it->second) {
+            std::optional<size_t> id = symbols.FindTerminal(t);
+            if (id.has_value()) {
+                follow.push_back(static_cast<uint32_t>(id.value()));
+            }
+        }
+    }
+    follow_index.push_back(static_cast<uint32_t>(follow.size()));
+
+    // the map is ordered by the state and then by the non-terminal, so the
+    // keys come out sorted
+    std::vector<uint32_t> &chains = section(BundleSection::UNIT_CHAINS);
+    std::vector<uint32_t> &chain_symbols =
+        section(BundleSection::UNIT_SYMBOLS);
+    for (const auto &[key, chain] : tables.unit_chains_) {
+        chains.push_back(
+            static_cast<uint32_t>(key.first * nonterminals + key.second)
+        );
+        chains.push_back(static_cast<uint32_t>(chain_symbols.size()));
+        chains.push_back(static_cast<uint32_t>(chain.size()));
+        for (size_t nt : chain) {
+            chain_symbols.push_back(static_cast<uint32_t>(nt));
+        }
+    }
+
+    std::vector<uint32_t> header(kHeaderWords + 2 * section_count);
+    size_t size = header.size() * sizeof(uint32_t);
+    for (size_t s = 0; s < section_count; ++s) {
+        size_t width =
+            s == SectionIndex(BundleSection::STRINGS) ? 1 : sizeof(uint32_t);
+        size_t length = s == SectionIndex(BundleSection::STRINGS)
+                            ? strings.size()
+                            : sections[s].size() * width;
+        header[kHeaderWords + 2 * s] = static_cast<uint32_t>(size);
+        header[kHeaderWords + 2 * s + 1] =
+            static_cast<uint32_t>(length / width);
+        size += (length + 3) / 4 * 4;
+    }
+    if (size > UINT32_MAX) {
+        throw TableBundleError("The tables don't fit into a table bundle");
+    }
+    std::memcpy(&header[0], kMagic, sizeof(kMagic));
+    header[1] = kVersion;
+    header[2] = kByteOrderMark;
+    header[3] = static_cast<uint32_t>(size);
+    header[4] = static_cast<uint32_t>(comb.GetTerminalCount());
+    header[5] = static_cast<uint32_t>(section_count);
+
+    bytes_.assign(size, 0);
+    std::memcpy(
+        bytes_.data(), header.data(), header.size() * sizeof(uint32_t)
+    );
+    std::memcpy(
+        bytes_.data() + header[kHeaderWords], strings.data(), strings.size()
+    );
+    for (size_t s = 1; s < section_count; ++s) {
+        std::memcpy(
+            bytes_.data() + header[kHeaderWords + 2 * s], sections[s].data(),
+            sections[s].size() * sizeof(uint32_t)
+        );
+    }
+}
+
+const std::vector<uint8_t> &TableBundle::GetBytes() const {
+    return bytes_;
+}
+
+void TableBundle::Write(const std::string &path) const {
+    std::ofstream out(path, std::ios::binary);
+    out.write(
+        reinterpret_cast<const char *>(bytes_.data()),
+        static_cast<std::streamsize>(bytes_.size())
+    );
+    if (!out) {
+        throw TableBundleError("Could not write " + path);
+    }
+}
+
+TableBundleView::TableBundleView(std::span<const uint8_t> bytes)
+    : bytes_(bytes) {
+    const size_t section_count = SectionIndex(BundleSection::COUNT);
+    size_t header_size =
+        (TableBundle::kHeaderWords + 2 * section_count) * sizeof(uint32_t);
+    if (bytes_.size() < header_size ||
+        std::memcmp(bytes_.data(), kMagic, sizeof(kMagic)) != 0) {
+        throw TableBundleError("Not a table bundle");
+    }
+    if (Word(1) != TableBundle::kVersion) {
+        throw TableBundleError(
+            "Table bundle version " + std::to_string(Word(1)) +
+            " is not supported, expected " +
+            std::to_string(TableBundle::kVersion)
+        );
+    }
+    if (Word(2) != TableBundle::kByteOrderMark) {
+        throw TableBundleError("Table bundle has a different byte order");
+    }
+    if (Word(3) != bytes_.size() || Word(5) != section_count) {
+        throw TableBundleError("Table bundle is truncated or corrupted");
+    }
+    for (size_t s = 0; s < section_count; ++s) {
+        size_t offset = Word(TableBundle::kHeaderWords + 2 * s);
+        size_t width =
+            s == SectionIndex(BundleSection::STRINGS) ? 1 : sizeof(uint32_t);
+        size_t length = Word(TableBundle::kHeaderWords + 2 * s + 1) * width;
+        if (offset % 4 != 0 || offset + length > bytes_.size()) {
+            throw TableBundleError("Table bundle is truncated or corrupted");
+        }
+    }
+    columns_ = Word(4);
+}
+
+uint32_t TableBundleView::Word(size_t i) const {
+    uint32_t word;
+    std::memcpy(&word, bytes_.data() + i * sizeof(uint32_t), sizeof(word));
+    return word;
+}
+
+size_t TableBundleView::GetColumns() const {
+    return columns_;
+}
+
+std::span<const uint32_t> TableBundleView::GetSection(BundleSection section
+) const {
+    size_t s = SectionIndex(section);
+    size_t offset = Word(TableBundle::kHeaderWords + 2 * s);
+    size_t length = Word(TableBundle::kHeaderWords + 2 * s + 1);
+    if (section == BundleSection::STRINGS) {
+        length /= sizeof(uint32_t);
+    }
+    return std::span<const uint32_t>(
+        reinterpret_cast<const uint32_t *>(bytes_.data() + offset), length
+    );
+}
+
+std::string_view TableBundleView::GetString(uint32_t offset, uint32_t length)
+    const {
+    size_t strings = Word(TableBundle::kHeaderWords);
+    return std::string_view(
+        reinterpret_cast<const char *>(bytes_.data() + strings) + offset, length
+    );
+}
+
+std::optional<size_t> TableBundleView::FindTerminal(std::string_view name
+) const {
+    std::span<const uint32_t> order = GetSection(BundleSection::TERMINAL_ORDER);
+    std::span<const uint32_t> terminals = GetSection(BundleSection::TERMINALS);
+    auto name_of = [&](uint32_t t) {
+        return GetString(terminals[2 * t], terminals[2 * t + 1]);
+    };
+    auto it = std::lower_bound(
+        order.begin(), order.end(), name,
+        [&](uint32_t t, std::string_view key) { return name_of(t) < key; }
+    );
+    if (it == order.end() || name_of(*it) != name) {
+        return std::nullopt;
+    }
+    return *it;
+}
+
+Action TableBundleView::GetAction(size_t state, size_t column) const {
+    std::span<const uint32_t> check = GetSection(BundleSection::CHECK);
+    size_t i = GetSection(BundleSection::BASE)[state] + column;
+    if (column < columns_ && i < check.size() && check[i] == state) {
+        return DenseActionTable::Decode(GetSection(BundleSection::NEXT)[i]);
+    }
+    return DenseActionTable::Decode(GetSection(BundleSection::DEFAULTS)[state]
+    );
+}
+
+std::optional<size_t> TableBundleView::GetGoto(
+    size_t state, size_t nonterminal
+) const {
+    std::span<const uint32_t> check = GetSection(BundleSection::CHECK);
+    size_t i = GetSection(BundleSection::BASE)[state] + columns_ + nonterminal;
+    if (i >= check.size() || check[i] != state) {
+        return std::nullopt;
+    }
+    return GetSection(BundleSection::NEXT)[i];
+}
@@ -0,0 +1,497 @@
+#include "TableOptimizer.h"
+
+#include <algorithm>
+#include <functional>
+#include <map>
+#include <numeric>
+#include <optional>
+#include <queue>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include "Helpers.h"
+
+namespace {
+/**
+ * @brief Returns the cell with the target of a shift replaced using the map.
+ */
+DenseActionTable::Cell MapShift(
+    DenseActionTable::Cell cell, const std::vector<size_t> &map
+) {
+    Action action = DenseActionTable::Decode(cell);
+    if (action.type_ != ActionType::SHIFT) {
+        return cell;
+    }
+    return DenseActionTable::Encode(
+        Action{ActionType::SHIFT, map[action.value_]}
+    );
+}
+
+/**
+ * @brief Returns the number of the largest counts that sum up to 90% of the
+ * total.
+ */
+size_t CountHot(std::vector<size_t> counts) {
+    std::sort(counts.begin(), counts.end(), std::greater<size_t>());
+    size_t total = std::accumulate(counts.begin(), counts.end(), size_t{0});
+    size_t sum = 0;
+    size_t hot = 0;
+    while (sum * 10 < total * 9) {
+        sum += counts[hot++];
+    }
+    return hot;
+}
+}  // namespace
+
+TableOptimizer::TableOptimizer(const Grammar &g, DenseTables &tables)
+    : g_(g), tables_(tables) {
+}
+
+size_t TableOptimizer::ShareReductions() {
+    // an epsilon rule pops nothing, so it only matches other epsilon rules
+    std::map<std::pair<NonTerminal, size_t>, size_t> first_rule;
+    std::vector<size_t> shared(g_.rules_.size());
+    for (size_t r = 0; r < g_.rules_.size(); ++r) {
+        const Rule &rule = g_[r];
+        size_t length = rule.prod.size();
+        if (length == 1 && rule.prod[0] == Token(EPSILON)) {
+            length = 0;
+        }
+        shared[r] = first_rule.emplace(std::pair(rule.lhs, length), r)
+                        .first->second;
+    }
+
+    auto share = [&shared](DenseActionTable::Cell cell) {
+        Action action = DenseActionTable::Decode(cell);
+        if (action.type_ == ActionType::REDUCE) {
+            action.value_ = shared[action.value_];
+        }
+        return DenseActionTable::Encode(action);
+    };
+    DenseActionTable &action = tables_.action_;
+    size_t changed = 0;
+    for (size_t s = 0; s < action.GetStateCount(); ++s) {
+        std::span<const DenseActionTable::Cell> row = action.GetRow(s);
+        for (size_t t = 0; t < row.size(); ++t) {
+            DenseActionTable::Cell cell = share(row[t]);
+            if (cell != row[t]) {
+                action.Set(s, t, DenseActionTable::Decode(cell));
+                ++changed;
+            }
+        }
+        DenseActionTable::Cell def = share(action.GetDefaults()[s]);
+        if (def != action.GetDefaults()[s]) {
+            action.SetDefault(s, DenseActionTable::Decode(def));
+            ++changed;
+        }
+    }
+    return changed;
+}
+
+DefaultReductionStats TableOptimizer::AddDefaultReductions(
+    DefaultReductions mode
+) {
+    DefaultReductionStats stats;
+    if (mode == DefaultReductions::NONE) {
+        return stats;
+    }
+    DenseActionTable &action = tables_.action_;
+    for (size_t s = 0; s < action.GetStateCount(); ++s) {
+        std::span<const DenseActionTable::Cell> row = action.GetRow(s);
+        std::map<DenseActionTable::Cell, size_t> reductions;
+        bool reduces_only = true;
+        for (DenseActionTable::Cell cell : row) {
+            if (cell == 0) {
+                continue;
+            }
+            if (DenseActionTable::Decode(cell).type_ == ActionType::REDUCE) {
+                ++reductions[cell];
+            } else {
+                reduces_only = false;
+            }
+        }
+        if (reductions.empty() ||
+            (mode == DefaultReductions::CONSISTENT &&
+             (!reduces_only || reductions.size() != 1))) {
+            continue;
+        }
+
+        // ties go to the rule with the smallest number, which is the one that
+        // is encoded into the smallest cell
+        auto best = reductions.begin();
+        for (auto it = reductions.begin(); it != reductions.end(); ++it) {
+            if (it->second > best->second) {
+                best = it;
+            }
+        }
+        Action reduction = DenseActionTable::Decode(best->first);
+        for (size_t t = 0; t < row.size(); ++t) {
+            if (row[t] == best->first) {
+                action.Set(s, t, Action{ActionType::ERROR, 0});
+                ++stats.removed_;
+            }
+        }
+        action.SetDefault(s, reduction);
+        ++stats.states_;
+        if (action.IsDefaultOnly(s)) {
+            ++stats.default_only_;
+        }
+    }
+    return stats;
+}
+
+MinimizationStats TableOptimizer::MinimizeStates() {
+    const DenseActionTable &action = tables_.action_;
+    const DenseGotoTable &goto_table = tables_.goto_;
+    size_t n = action.GetStateCount();
+    MinimizationStats stats{n, n};
+    if (n == 0) {
+        return stats;
+    }
+
+    // every round splits the classes whose states differ once the targets are
+    // replaced with the classes from the previous round; a round that doesn't
+    // add a class doesn't change the partition
+    std::vector<size_t> block(n, 0);
+    size_t block_count = 1;
+    while (true) {
+        std::map<std::vector<uint32_t>, size_t> signatures;
+        std::vector<size_t> next_block(n);
+        for (size_t s = 0; s < n; ++s) {
+            std::vector<uint32_t> signature;
+            for (DenseActionTable::Cell cell : action.GetRow(s)) {
+                signature.push_back(MapShift(cell, block));
+            }
+            for (DenseGotoTable::Cell cell : goto_table.GetRow(s)) {
+                signature.push_back(
+                    cell == DenseGotoTable::kNone
+                        ? DenseGotoTable::kNone
+                        : static_cast<uint32_t>(block[cell])
+                );
+            }
+            signature.push_back(action.GetDefaults()[s]);
+            auto it = signatures.emplace(signature, signatures.size()).first;
+            next_block[s] = it->second;
+        }
+        block = std::move(next_block);
+        if (signatures.size() == block_count) {
+            break;
+        }
+        block_count = signatures.size();
+    }
+    stats.after_ = block_count;
+    if (block_count == n) {
+        return stats;
+    }
+
+    // the classes are numbered in the order of their first states, so the
+    // class of the initial state is 0
+    std::vector<size_t> representative(block_count, n);
+    for (size_t s = 0; s < n; ++s) {
+        if (representative[block[s]] == n) {
+            representative[block[s]] = s;
+        }
+    }
+    RenumberStates(representative, block);
+    return stats;
+}
+
+TerminalClassStats TableOptimizer::MergeTerminals() {
+    const DenseActionTable &action = tables_.action_;
+    size_t columns = action.GetTerminalCount();
+    size_t states = action.GetStateCount();
+    TerminalClassStats stats{
+        tables_.symbols_.GetTerminalCount(), columns, columns
+    };
+
+    std::map<std::vector<DenseActionTable::Cell>, size_t> classes;
+    std::vector<size_t> column_class(columns);
+    for (size_t c = 0; c < columns; ++c) {
+        std::vector<DenseActionTable::Cell> column(states);
+        for (size_t s = 0; s < states; ++s) {
+            column[s] = action.GetRow(s)[c];
+        }
+        column_class[c] = classes.emplace(column, classes.size()).first->second;
+    }
+    stats.after_ = classes.size();
+
+    // terminals already sharing a column stay together
+    std::vector<uint32_t> terminal_classes;
+    for (size_t t = 0; t < stats.terminals_; ++t) {
+        terminal_classes.push_back(
+            static_cast<uint32_t>(column_class[tables_.GetTerminalColumn(t)])
+        );
+    }
+    tables_.terminal_classes_ = std::move(terminal_classes);
+    if (stats.after_ == columns) {
+        return stats;
+    }
+
+    DenseActionTable new_action(states, stats.after_);
+    for (size_t s = 0; s < states; ++s) {
+        std::span<const DenseActionTable::Cell> row = action.GetRow(s);
+        for (size_t c = 0; c < columns; ++c) {
+            new_action.Set(
+                s, column_class[c], DenseActionTable::Decode(row[c])
+            );
+        }
+        new_action.SetDefault(s, action.GetDefault(s));
+    }
+    tables_.action_ = std::move(new_action);
+    return stats;
+}
+
+ShiftReduceStats TableOptimizer::FuseShiftReduce() {
+    DenseActionTable &action = tables_.action_;
+    size_t n = action.GetStateCount();
+    ShiftReduceStats stats;
+
+    std::vector<bool> transient(n, false);
+    for (size_t s = 0; s < n; ++s) {
+        Action def = action.GetDefault(s);
+        transient[s] = action.IsDefaultOnly(s) &&
+                       def.type_ == ActionType::REDUCE &&
+                       g_[def.value_].prod[0] != Token(EPSILON);
+    }
+    for (size_t s = 0; s < n; ++s) {
+        std::span<const DenseActionTable::Cell> row = action.GetRow(s);
+        for (size_t t = 0; t < row.size(); ++t) {
+            Action cell = DenseActionTable::Decode(row[t]);
+            if (cell.type_ == ActionType::SHIFT && transient[cell.value_]) {
+                action.Set(
+                    s, t,
+                    Action{
+                        ActionType::SHIFT_REDUCE,
+                        action.GetDefault(cell.value_).value_
+                    }
+                );
+                ++stats.fused_;
+            }
+        }
+    }
+
+    stats.removed_states_ = RemoveUnreachableStates();
+    return stats;
+}
+
+UnitRuleStats TableOptimizer::EliminateUnitRules(UnitRules mode) {
+    UnitRuleStats stats;
+    if (mode == UnitRules::KEEP) {
+        return stats;
+    }
+    const DenseActionTable &action = tables_.action_;
+    size_t n = action.GetStateCount();
+
+    // a state entered on <B> that only reduces by a rule of length 1 reduces
+    // by <A> = <B>, the goto on <A> is taken from the state below it
+    std::vector<std::optional<size_t>> unit_lhs(n);
+    for (size_t s = 0; s < n; ++s) {
+        Action def = action.GetDefault(s);
+        if (!action.IsDefaultOnly(s) || def.type_ != ActionType::REDUCE) {
+            continue;
+        }
+        const Rule &rule = g_[def.value_];
+        std::span<const DenseGotoTable::Cell> gotos = tables_.goto_.GetRow(s);
+        bool leaf = std::all_of(gotos.begin(), gotos.end(), [](auto cell) {
+            return cell == DenseGotoTable::kNone;
+        });
+        if (rule.prod.size() == 1 && rule.prod[0] != Token(EPSILON) && leaf) {
+            unit_lhs[s] = tables_.symbols_.GetNonTerminalId(rule.lhs);
+        }
+    }
+
+    const DenseGotoTable original = tables_.goto_.Clone();
+    for (size_t s = 0; s < n; ++s) {
+        std::span<const DenseGotoTable::Cell> row = original.GetRow(s);
+        for (size_t nt = 0; nt < row.size(); ++nt) {
+            if (row[nt] == DenseGotoTable::kNone) {
+                continue;
+            }
+            size_t target = row[nt];
+            std::vector<size_t> chain;
+            // a chain longer than the number of states would be a cycle of
+            // unit rules, which no LR(1) grammar has
+            while (unit_lhs[target].has_value() && chain.size() <= n) {
+                size_t lhs = unit_lhs[target].value();
+                std::optional<size_t> next = original.Get(s, lhs);
+                if (!next.has_value()) {
+                    break;
+                }
+                chain.push_back(lhs);
+                target = next.value();
+            }
+            if (chain.empty()) {
+                continue;
+            }
+            tables_.goto_.Set(s, nt, target);
+            if (mode == UnitRules::SYNTHESIZE) {
+                tables_.unit_chains_[{s, nt}] = std::move(chain);
+            }
+            ++stats.bypassed_;
+        }
+    }
+    stats.removed_states_ = RemoveUnreachableStates();
+    return stats;
+}
+
+ProfileLayoutStats TableOptimizer::ApplyProfile(const LayoutProfile &profile
+) {
+    if (profile.GetFingerprint() != LayoutProfile::Fingerprint(tables_) ||
+        profile.GetStateCount() != tables_.action_.GetStateCount()) {
+        throw LayoutProfileError(
+            "The profile was gathered with different tables, profile a "
+            "parser generated with the same grammar and options"
+        );
+    }
+    size_t n = tables_.action_.GetStateCount();
+    ProfileLayoutStats stats{n, 0, tables_.action_.GetTerminalCount(), 0};
+
+    std::vector<size_t> visits(n);
+    for (size_t s = 0; s < n; ++s) {
+        visits[s] = profile.GetStateVisits(s);
+    }
+    std::vector<size_t> states(n);
+    std::iota(states.begin(), states.end(), 0);
+    std::stable_sort(
+        states.begin() + (n == 0 ? 0 : 1), states.end(),
+        [&visits](size_t lhs, size_t rhs) {
+            return visits[lhs] > visits[rhs];
+        }
+    );
+    std::vector<size_t> number(n);
+    for (size_t b = 0; b < n; ++b) {
+        number[states[b]] = b;
+    }
+    RenumberStates(states, number);
+    stats.hot_states_ = CountHot(visits);
+
+    const SymbolIds &symbols = tables_.symbols_;
+    std::vector<size_t> shifts(stats.columns_, 0);
+    for (size_t t = 0; t < symbols.GetTerminalCount(); ++t) {
+        shifts[tables_.GetTerminalColumn(t)] +=
+            profile.GetTerminalShifts(symbols.GetTerminalName(t));
+    }
+    stats.hot_columns_ = CountHot(shifts);
+    std::vector<size_t> columns(stats.columns_);
+    std::iota(columns.begin(), columns.end(), 0);
+    std::stable_sort(
+        columns.begin(), columns.end(),
+        [&shifts](size_t lhs, size_t rhs) {
+            return shifts[lhs] > shifts[rhs];
+        }
+    );
+    if (std::is_sorted(columns.begin(), columns.end())) {
+        return stats;
+    }
+
+    std::vector<size_t> column(stats.columns_);
+    for (size_t c = 0; c < stats.columns_; ++c) {
+        column[columns[c]] = c;
+    }
+    std::vector<uint32_t> terminal_classes;
+    for (size_t t = 0; t < symbols.GetTerminalCount(); ++t) {
+        terminal_classes.push_back(
+            static_cast<uint32_t>(column[tables_.GetTerminalColumn(t)])
+        );
+    }
+    tables_.terminal_classes_ = std::move(terminal_classes);
+    const DenseActionTable &action = tables_.action_;
+    DenseActionTable new_action(n, stats.columns_);
+    for (size_t s = 0; s < n; ++s) {
+        std::span<const DenseActionTable::Cell> row = action.GetRow(s);
+        for (size_t c = 0; c < row.size(); ++c) {
+            new_action.Set(s, column[c], DenseActionTable::Decode(row[c]));
+        }
+        new_action.SetDefault(s, action.GetDefault(s));
+    }
+    tables_.action_ = std::move(new_action);
+    return stats;
+}
+
+size_t TableOptimizer::RemoveUnreachableStates() {
+    const DenseActionTable &action = tables_.action_;
+    const DenseGotoTable &goto_table = tables_.goto_;
+    size_t n = action.GetStateCount();
+
+    // a state may still be reached through a goto, so the removed states are
+    // the ones not reached from the initial state at all
+    std::vector<bool> reached(n, false);
+    std::queue<size_t> queue;
+    reached[0] = n > 0;
+    if (n > 0) {
+        queue.push(0);
+    }
+    while (!queue.empty()) {
+        size_t s = queue.front();
+        queue.pop();
+        std::vector<size_t> targets;
+        for (DenseActionTable::Cell cell : action.GetRow(s)) {
+            Action a = DenseActionTable::Decode(cell);
+            if (a.type_ == ActionType::SHIFT) {
+                targets.push_back(a.value_);
+            }
+        }
+        for (DenseGotoTable::Cell cell : goto_table.GetRow(s)) {
+            if (cell != DenseGotoTable::kNone) {
+                targets.push_back(cell);
+            }
+        }
+        for (size_t target : targets) {
+            if (!reached[target]) {
+                reached[target] = true;
+                queue.push(target);
+            }
+        }
+    }
+
+    std::vector<size_t> states;
+    std::vector<size_t> renumbered(n, n);
+    for (size_t s = 0; s < n; ++s) {
+        if (reached[s]) {
+            renumbered[s] = states.size();
+            states.push_back(s);
+        }
+    }
+    if (states.size() == n) {
+        return 0;
+    }
+    RenumberStates(states, renumbered);
+    return n - states.size();
+}
+
+void TableOptimizer::RenumberStates(
+    const std::vector<size_t> &states, const std::vector<size_t> &number
+) {
+    const DenseActionTable &action = tables_.action_;
+    const DenseGotoTable &goto_table = tables_.goto_;
+    DenseActionTable new_action(states.size(), action.GetTerminalCount());
+    DenseGotoTable new_goto(states.size(), goto_table.GetNonTerminalCount());
+    for (size_t b = 0; b < states.size(); ++b) {
+        size_t s = states[b];
+        std::span<const DenseActionTable::Cell> row = action.GetRow(s);
+        for (size_t t = 0; t < row.size(); ++t) {
+            new_action.Set(
+                b, t, DenseActionTable::Decode(MapShift(row[t], number))
+            );
+        }
+        std::span<const DenseGotoTable::Cell> goto_row = goto_table.GetRow(s);
+        for (size_t nt = 0; nt < goto_row.size(); ++nt) {
+            if (goto_row[nt] != DenseGotoTable::kNone) {
+                new_goto.Set(b, nt, number[goto_row[nt]]);
+            }
+        }
+        new_action.SetDefault(b, action.GetDefault(s));
+    }
+    tables_.action_ = std::move(new_action);
+    tables_.goto_ = std::move(new_goto);
+
+    std::map<std::pair<size_t, size_t>, std::vector<size_t>> chains;
+    for (auto &[key, chain] : tables_.unit_chains_) {
+        size_t b = number[key.first];
+        if (b < states.size() && states[b] == key.first) {
+            chains[{b, key.second}] = std::move(chain);
+        }
+    }
+    tables_.unit_chains_ = std::move(chains);
+}
@@ -145,3 +145,62 @@ TEST_CASE("Automaton correctly computes goto", "[Automaton]") {
     );
     REQUIRE(goto_state.size() == 0);  // nonexistent transition
 }
+
+TEST_CASE("Automaton reports split cores", "[Automaton]") {
+    std::string input = R"(
+        <S> = <C> <C>
+        <C> = 'c' <C> | 'd'
+    )";
+
+    GrammarParser gp(MakeStream(input));
+    REQUIRE_NOTHROW(gp.Parse());
+    Grammar g = gp.Get();
+    GrammarAnalyzer ga(g);
+
+    SECTION("Splits") {
+        Automaton a(g, ga);
+        REQUIRE(a.GetStates().size() == 10);
+        REQUIRE(a.GetCoreCount() == 7);
+        REQUIRE(a.GetEstimatedMemory() > 0);
+
+        std::vector<Automaton::CoreSplit> splits = a.GetCoreSplits(10);
+        REQUIRE(splits.size() == 3);
+        for (const Automaton::CoreSplit &split : splits) {
+            REQUIRE(split.states_.size() == 2);
+            REQUIRE(
+                split.lookaheads_ ==
+                std::set<Terminal>({Terminal{"c"}, Terminal{"d"}, T_EOF})
+            );
+        }
+        REQUIRE(a.GetCoreSplits(1).size() == 1);
+        REQUIRE(
+            a.DescribeCoreSplits(1).find("split by lookaheads: $ 'c' 'd'") !=
+            std::string::npos
+        );
+    }
+
+    SECTION("State budget") {
+        AutomatonLimits limits;
+        limits.max_states_ = 8;
+        size_t reported = 0;
+        limits.report_every_ = 2;
+        limits.on_progress_ = [&reported](size_t, size_t, size_t) {
+            ++reported;
+        };
+        try {
+            Automaton a(g, ga, limits);
+            FAIL("the budget is not enforced");
+        } catch (const AutomatonBudgetError &e) {
+            std::string msg = e.what();
+            REQUIRE(msg.find("8 states") != std::string::npos);
+            REQUIRE(msg.find("split by lookaheads") != std::string::npos);
+        }
+        REQUIRE(reported == 4);
+    }
+
+    SECTION("Memory budget") {
+        AutomatonLimits limits;
+        limits.max_memory_ = 1;
+        REQUIRE_THROWS_AS(Automaton(g, ga, limits), AutomatonBudgetError);
+    }
+}
@@ -0,0 +1,100 @@
+#define CATCH_CONFIG_MAIN
+
+#include <catch2/catch_test_macros.hpp>
+
+#include "BNFParser.h"
+#include "CombTables.h"
+#include "DenseTables.h"
+#include "Entities.h"
+#include "GrammarAnalyzer.h"
+#include "TableBuilder.h"
+#include "TestHelpers.h"
+
+namespace {
+/**
+ * @brief Checks that every cell of the compressed tables equals the cell of
+ * the dense tables they were packed from.
+ */
+void RequireSameCells(const DenseTables &dense, const CombTables &comb) {
+    REQUIRE(comb.GetStateCount() == dense.action_.GetStateCount());
+    for (size_t s = 0; s < dense.action_.GetStateCount(); ++s) {
+        for (size_t t = 0; t < dense.action_.GetTerminalCount(); ++t) {
+            Action expected = dense.action_.Get(s, t);
+            Action actual = comb.GetAction(s, t);
+            REQUIRE(actual.type_ == expected.type_);
+            REQUIRE(actual.value_ == expected.value_);
+        }
+        for (size_t nt = 0; nt < dense.goto_.GetNonTerminalCount(); ++nt) {
+            REQUIRE(comb.GetGoto(s, nt) == dense.goto_.Get(s, nt));
+        }
+    }
+}
+}  // namespace
+
+TEST_CASE("CombTables packs hand-made tables", "[CombTables]") {
+    DenseTables dense;
+    dense.action_ = DenseActionTable(3, 4);
+    dense.goto_ = DenseGotoTable(3, 2);
+    dense.action_.Set(0, 0, Action{ActionType::SHIFT, 1});
+    dense.action_.Set(0, 3, Action{ActionType::SHIFT, 2});
+    dense.action_.Set(1, 1, Action{ActionType::REDUCE, 4});
+    dense.action_.Set(2, 0, Action{ActionType::ACCEPT, 0});
+    dense.goto_.Set(0, 1, 2);
+    dense.goto_.Set(1, 0, 0);
+
+    CombTables comb(dense);
+    RequireSameCells(dense, comb);
+    // the rows don't overlap, so they are interleaved instead of appended
+    REQUIRE(comb.GetNext().size() < 3 * (4 + 2));
+    REQUIRE(comb.GetCheck().size() == comb.GetNext().size());
+    REQUIRE(comb.GetAction(1, 7).type_ == ActionType::ERROR);
+    REQUIRE_FALSE(comb.GetGoto(1, 5).has_value());
+
+    // in the order of the states the first row starts the vectors
+    CombTables in_order(dense, true);
+    RequireSameCells(dense, in_order);
+    REQUIRE(in_order.GetBase()[0] == 0);
+}
+
+TEST_CASE("CombTables packs the tables of a grammar", "[CombTables]") {
+    std::string input = R"(
+        num = [0-9]+
+        id = [a-z]+
+        <S> = <Sum>
+        <Sum> = <Sum> '+' <Prod> | <Sum> '-' <Prod> | <Prod>
+        <Prod> = <Prod> '*' <Atom> | <Prod> '/' <Atom> | <Atom>
+        <Atom> = num | id | '(' <Sum> ')' | id '(' <Args> ')'
+        <Args> = <Sum> <MoreArgs> | EPSILON
+        <MoreArgs> = ',' <Sum> <MoreArgs> | EPSILON
+    )";
+
+    GrammarParser gp(MakeStream(input));
+    REQUIRE_NOTHROW(gp.Parse());
+    Grammar g = gp.Get();
+    GrammarAnalyzer ga(g);
+    ParserTables tables(g, ga);
+    REQUIRE_NOTHROW(tables.Generate());
+    const DenseTables &dense = tables.GetTables();
+
+    CombTables comb(dense);
+    RequireSameCells(dense, comb);
+
+    size_t states = dense.action_.GetStateCount();
+    size_t columns =
+        dense.action_.GetTerminalCount() + dense.goto_.GetNonTerminalCount();
+    REQUIRE(comb.GetNext().size() < states * columns);
+    REQUIRE(comb.GetCheckWidth() == CombTables::WidthFor(states));
+    REQUIRE(
+        comb.GetByteSize() <
+        (dense.action_.GetCells().size() + dense.goto_.GetCells().size()) *
+            sizeof(uint32_t)
+    );
+}
+
+TEST_CASE("CombTables picks the narrowest integer types", "[CombTables]") {
+    REQUIRE(CombTables::WidthFor(0) == 1);
+    REQUIRE(CombTables::WidthFor(255) == 1);
+    REQUIRE(CombTables::WidthFor(256) == 2);
+    REQUIRE(CombTables::WidthFor(65535) == 2);
+    REQUIRE(CombTables::WidthFor(65536) == 4);
+}
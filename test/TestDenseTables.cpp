@@ -0,0 +1,130 @@
+#define CATCH_CONFIG_MAIN
+
+#include <catch2/catch_test_macros.hpp>
+
+#include "BNFParser.h"
+#include "DenseTables.h"
+#include "Entities.h"
+#include "GrammarAnalyzer.h"
+#include "Helpers.h"
+#include "TableBuilder.h"
+#include "TestHelpers.h"
+
+TEST_CASE("DenseActionTable encodes actions", "[DenseTables]") {
+    for (ActionType type :
+         {ActionType::SHIFT, ActionType::REDUCE, ActionType::ACCEPT}) {
+        for (size_t value : {size_t{0}, size_t{1}, size_t{12345}}) {
+            DenseActionTable::Cell cell =
+                DenseActionTable::Encode(Action{type, value});
+            Action decoded = DenseActionTable::Decode(cell);
+            REQUIRE(decoded.type_ == type);
+            REQUIRE(decoded.value_ == value);
+        }
+    }
+    REQUIRE(DenseActionTable::Encode(Action{ActionType::ERROR, 7}) == 0);
+    REQUIRE(DenseActionTable::Decode(0).type_ == ActionType::ERROR);
+    REQUIRE_THROWS_AS(
+        DenseActionTable::Encode(Action{ActionType::SHIFT, size_t{1} << 40}),
+        std::out_of_range
+    );
+
+    DenseActionTable table(3, 4);
+    REQUIRE(table.GetStateCount() == 3);
+    REQUIRE(table.GetTerminalCount() == 4);
+    REQUIRE(table.Get(2, 3).type_ == ActionType::ERROR);
+    table.Set(2, 3, Action{ActionType::REDUCE, 5});
+    REQUIRE(table.Get(2, 3).type_ == ActionType::REDUCE);
+    REQUIRE(table.Get(2, 3).value_ == 5);
+    REQUIRE(
+        table.GetRow(2)[3] ==
+        DenseActionTable::Encode(Action{ActionType::REDUCE, 5})
+    );
+
+    DenseActionTable moved = std::move(table);
+    REQUIRE(moved.Get(2, 3).value_ == 5);
+    DenseActionTable copy = moved.Clone();
+    REQUIRE(copy.GetCells() == moved.GetCells());
+}
+
+TEST_CASE("DenseGotoTable stores transitions", "[DenseTables]") {
+    DenseGotoTable table(2, 3);
+    REQUIRE_FALSE(table.Get(1, 2).has_value());
+    table.Set(1, 2, 0);
+    REQUIRE(table.Get(1, 2) == 0);
+    REQUIRE(table.GetRow(1)[2] == 0);
+    REQUIRE(table.GetRow(0)[2] == DenseGotoTable::kNone);
+}
+
+TEST_CASE("SymbolIds assigns ids by qualified name", "[DenseTables]") {
+    std::string input = R"(
+        int = [0-9]+
+        <S> = <T> <E>
+        <E> = '+' <T> <E> | EPSILON
+        <T> = int
+    )";
+
+    GrammarParser gp(MakeStream(input));
+    REQUIRE_NOTHROW(gp.Parse());
+    Grammar g = gp.Get();
+    SymbolIds ids(g);
+
+    REQUIRE(ids.GetTerminalId(T_EOF) == 0);
+    // `int` is stored twice in the grammar, with its definition and as a
+    // reference, but gets a single id
+    REQUIRE(ids.GetTerminalCount() == 3);
+    REQUIRE(
+        ids.GetTerminalId(Terminal{"int", " "}) ==
+        ids.GetTerminalId(Terminal{"int", "[0-9]+"})
+    );
+    REQUIRE(ids.GetTerminalName(ids.GetTerminalId(Terminal{"+"})) == "T_+");
+    REQUIRE_FALSE(ids.FindTerminal(EPSILON).has_value());
+    REQUIRE(ids.GetNonTerminalCount() == 4);
+    REQUIRE(ids.GetNonTerminal(0) == NonTerminal{"S'"});
+    REQUIRE(
+        ids.GetNonTerminal(ids.GetNonTerminalId(NonTerminal{"E"})) ==
+        NonTerminal{"E"}
+    );
+}
+
+TEST_CASE("ParserTables builds dense tables", "[DenseTables]") {
+    std::string input = R"(
+        int = [0-9]+
+        <S> = <T> <E>
+        <E> = '+' <T> <E> | EPSILON
+        <T> = int
+    )";
+
+    GrammarParser gp(MakeStream(input));
+    REQUIRE_NOTHROW(gp.Parse());
+    Grammar g = gp.Get();
+    GrammarAnalyzer ga(g);
+    ParserTables tables(g, ga);
+    REQUIRE_NOTHROW(tables.Generate());
+
+    const DenseTables &dense = tables.GetTables();
+    const SymbolIds &ids = dense.symbols_;
+    REQUIRE(dense.action_.GetStateCount() == tables.GetStates().size());
+    REQUIRE(dense.action_.GetTerminalCount() == ids.GetTerminalCount());
+
+    const Automaton::Transitions &transitions = tables.GetTransitions();
+    for (size_t i = 0; i < transitions.size(); ++i) {
+        for (const auto &[token, target] : transitions[i]) {
+            if (IsNonTerminal(token)) {
+                REQUIRE(
+                    dense.goto_.Get(
+                        i, ids.GetNonTerminalId(std::get<NonTerminal>(token))
+                    ) == target
+                );
+            } else {
+                Action action = dense.action_.Get(
+                    i, ids.GetTerminalId(std::get<Terminal>(token))
+                );
+                REQUIRE(action.type_ == ActionType::SHIFT);
+                REQUIRE(action.value_ == target);
+            }
+        }
+    }
+
+    DenseTables taken = tables.TakeTables();
+    REQUIRE(taken.action_.GetStateCount() == transitions.size());
+}
@@ -0,0 +1,129 @@
+#define CATCH_CONFIG_MAIN
+
+#include <catch2/catch_test_macros.hpp>
+
+#include "BNFParser.h"
+#include "Entities.h"
+#include "ExpressionAnalyzer.h"
+#include "TestHelpers.h"
+
+namespace {
+Grammar ParseGrammar(const std::string &input) {
+    GrammarParser gp(MakeStream(input));
+    gp.Parse();
+    return gp.Get();
+}
+
+const std::string kLeftRecursive = R"(
+    id = [0-9]+
+    <S> = <E>
+    <F> = '(' <E> ')' | id
+    <E> = <E> '+' <T> | <E> '-' <T> | <T>
+    <T> = <T> '*' <F> | <F>
+)";
+}  // namespace
+
+TEST_CASE("ExpressionAnalyzer finds left-recursive levels", "[Expression]") {
+    Grammar g = ParseGrammar(kLeftRecursive);
+    Expression e = ExpressionAnalyzer(g).Analyze(NonTerminal{"E"});
+    REQUIRE(e.levels_.size() == 2);
+    REQUIRE(e.levels_[0].lhs_ == NonTerminal{"E"});
+    REQUIRE_FALSE(e.levels_[0].tail_.has_value());
+    REQUIRE(e.levels_[0].operators_ == std::vector<Terminal>{{"+"}, {"-"}});
+    REQUIRE(e.levels_[0].next_ == NonTerminal{"T"});
+    REQUIRE(e.levels_[1].lhs_ == NonTerminal{"T"});
+    REQUIRE(e.levels_[1].operators_ == std::vector<Terminal>{{"*"}});
+    REQUIRE(e.levels_[1].next_ == NonTerminal{"F"});
+    REQUIRE(e.operand_ == NonTerminal{"F"});
+
+    // the tightest level can be marked on its own, but not together with `<E>`
+    ExpressionAnalyzer ea(g);
+    REQUIRE(ea.Analyze(NonTerminal{"T"}).operand_ == NonTerminal{"F"});
+    REQUIRE(ea.Analyze({NonTerminal{"E"}, NonTerminal{"E"}}).size() == 1);
+    REQUIRE_THROWS_AS(
+        ea.Analyze({NonTerminal{"E"}, NonTerminal{"T"}}), ExpressionError
+    );
+}
+
+TEST_CASE("ExpressionAnalyzer finds levels with tails", "[Expression]") {
+    Grammar g = ParseGrammar(R"(
+        number = [0-9]+
+        <Statement> = 'let' number '=' <Expression> ';'
+        <Expression> = <Term> <ExpressionTail>
+        <ExpressionTail> = '+' <Term> <ExpressionTail> | '-' <Term> <ExpressionTail> | EPSILON
+        <Term> = <Factor> <TermTail>
+        <TermTail> = '*' <Factor> <TermTail> | EPSILON
+        <Factor> = '(' <Expression> ')' | number
+    )");
+    Expression e = ExpressionAnalyzer(g).Analyze(NonTerminal{"Expression"});
+    REQUIRE(e.levels_.size() == 2);
+    REQUIRE(e.levels_[0].tail_ == NonTerminal{"ExpressionTail"});
+    REQUIRE(e.levels_[0].operators_ == std::vector<Terminal>{{"+"}, {"-"}});
+    REQUIRE(e.levels_[0].next_ == NonTerminal{"Term"});
+    REQUIRE(e.levels_[1].tail_ == NonTerminal{"TermTail"});
+    REQUIRE(e.levels_[1].operators_ == std::vector<Terminal>{{"*"}});
+    REQUIRE(e.operand_ == NonTerminal{"Factor"});
+}
+
+TEST_CASE("ExpressionAnalyzer rejects other non-terminals", "[Expression]") {
+    Grammar left = ParseGrammar(kLeftRecursive);
+    ExpressionAnalyzer plain(left);
+    REQUIRE_THROWS_AS(plain.Analyze(NonTerminal{"F"}), ExpressionError);
+    REQUIRE_THROWS_AS(plain.Analyze(NonTerminal{"X"}), ExpressionError);
+
+    const std::vector<std::string> grammars = {
+        // an operator after the operand wouldn't always continue the
+        // expression
+        R"(
+            id = [0-9]+
+            <S> = <E> | <E> '*' '*'
+            <E> = <E> '+' <T> | <T>
+            <T> = <T> '*' <F> | <F>
+            <F> = id
+        )",
+        // a level used outside of the expression
+        R"(
+            id = [0-9]+
+            <S> = <E> ';' <T>
+            <E> = <E> '+' <T> | <T>
+            <T> = <T> '*' <F> | <F>
+            <F> = id
+        )",
+        // an operand used outside of the expression
+        R"(
+            id = [0-9]+
+            <S> = <E> ';' <F>
+            <E> = <E> '+' <F> | <F>
+            <F> = id
+        )",
+        // the operand starts with a level
+        R"(
+            id = [0-9]+
+            <S> = <E>
+            <E> = <E> '+' <F> | <F>
+            <F> = <G> <E> '!' | id
+            <G> = EPSILON
+        )",
+        // the operand can be empty
+        R"(
+            id = [0-9]+
+            <S> = <E>
+            <E> = <E> '+' <F> | <F>
+            <F> = id | EPSILON
+        )",
+        // one operator on two levels
+        R"(
+            id = [0-9]+
+            <S> = <E>
+            <E> = <E> '+' <T> | <T>
+            <T> = <T> '+' <F> | <F>
+            <F> = id
+        )",
+    };
+    for (const std::string &input : grammars) {
+        Grammar g = ParseGrammar(input);
+        REQUIRE_THROWS_AS(
+            ExpressionAnalyzer(g).Analyze(NonTerminal{"E"}), ExpressionError
+        );
+    }
+}
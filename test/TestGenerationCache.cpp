@@ -0,0 +1,158 @@
+#define CATCH_CONFIG_MAIN
+
+#include <catch2/catch_test_macros.hpp>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+
+#include "BNFParser.h"
+#include "GenerationCache.h"
+#include "TableBuilder.h"
+#include "TestHelpers.h"
+
+TEST_CASE("GenerationCache round-trips an entry", "[GenerationCache]") {
+    std::string input = R"(
+        int = [0-9]+
+        IGNORE = [ \t]+
+        <S> = <T> <E>
+        <E> = '+' <T> <E> | EPSILON
+        <T> = int
+    )";
+
+    GrammarParser gp(MakeStream(input));
+    REQUIRE_NOTHROW(gp.Parse());
+
+    Grammar g = gp.Get();
+    GrammarAnalyzer ga(g);
+    ParserTables tables(g, ga);
+    REQUIRE_NOTHROW(tables.Generate());
+
+    CacheEntry stored{
+        g,
+        ga.GetFirst(),
+        ga.GetFollow(),
+        tables.GetStates(),
+        tables.GetTransitions(),
+        tables.GetTables().Clone()
+    };
+
+    auto folder =
+        std::filesystem::temp_directory_path() / "pargen_cache_roundtrip";
+    std::filesystem::remove_all(folder);
+    GenerationCache cache(folder.string());
+    uint64_t key = GenerationCache::Key(input);
+
+    REQUIRE_FALSE(cache.Load(key).has_value());
+    cache.Store(key, stored);
+    std::optional<CacheEntry> loaded = cache.Load(key);
+    REQUIRE(loaded.has_value());
+
+    REQUIRE(loaded->grammar_.rules_.size() == g.rules_.size());
+    for (size_t i = 0; i < g.rules_.size(); ++i) {
+        REQUIRE(loaded->grammar_[i].lhs == g[i].lhs);
+        REQUIRE(loaded->grammar_[i].prod == g[i].prod);
+    }
+    REQUIRE(loaded->grammar_.tokens_ == g.tokens_);
+    REQUIRE(loaded->grammar_.ignored_ == g.ignored_);
+    REQUIRE(loaded->first_ == stored.first_);
+    REQUIRE(loaded->follow_ == stored.follow_);
+    REQUIRE(loaded->states_.size() == stored.states_.size());
+    for (size_t i = 0; i < stored.states_.size(); ++i) {
+        REQUIRE(loaded->states_.left.at(i) == stored.states_.left.at(i));
+    }
+    REQUIRE(loaded->transitions_ == stored.transitions_);
+    REQUIRE(
+        loaded->tables_.action_.GetCells() == stored.tables_.action_.GetCells()
+    );
+    REQUIRE(
+        loaded->tables_.goto_.GetCells() == stored.tables_.goto_.GetCells()
+    );
+    REQUIRE(
+        loaded->tables_.ToActionTable().size() ==
+        stored.tables_.ToActionTable().size()
+    );
+    REQUIRE(loaded->tables_.ToGotoTable() == stored.tables_.ToGotoTable());
+
+    std::filesystem::remove_all(folder);
+}
+
+TEST_CASE("GenerationCache keys depend on grammar text", "[GenerationCache]") {
+    REQUIRE(
+        GenerationCache::Key("<S> = 'a'") == GenerationCache::Key("<S> = 'a'")
+    );
+    REQUIRE(
+        GenerationCache::Key("<S> = 'a'") != GenerationCache::Key("<S> = 'b'")
+    );
+}
+
+TEST_CASE("GenerationCache rejects corrupted entries", "[GenerationCache]") {
+    auto folder =
+        std::filesystem::temp_directory_path() / "pargen_cache_corrupted";
+    std::filesystem::remove_all(folder);
+    GenerationCache cache(folder.string());
+    uint64_t key = GenerationCache::Key("<S> = 'a'");
+
+    GrammarParser gp(MakeStream("<S> = 'a'"));
+    REQUIRE_NOTHROW(gp.Parse());
+    cache.Store(key, CacheEntry{gp.Get()});
+
+    for (const auto &file : std::filesystem::directory_iterator(folder)) {
+        std::filesystem::resize_file(file.path(), 6);
+    }
+    REQUIRE_THROWS_AS(cache.Load(key), GenerationCacheError);
+
+    std::filesystem::remove_all(folder);
+}
+
+TEST_CASE(
+    "GenerationCache never loads an entry with a flipped byte",
+    "[GenerationCache]"
+) {
+    std::string input = R"(
+        int = [0-9]+
+        <S> = <S> '+' int | int
+    )";
+    GrammarParser gp(MakeStream(input));
+    REQUIRE_NOTHROW(gp.Parse());
+    Grammar g = gp.Get();
+    GrammarAnalyzer ga(g);
+    ParserTables tables(g, ga);
+    REQUIRE_NOTHROW(tables.Generate());
+
+    auto folder =
+        std::filesystem::temp_directory_path() / "pargen_cache_flipped";
+    std::filesystem::remove_all(folder);
+    GenerationCache cache(folder.string());
+    uint64_t key = GenerationCache::Key(input);
+    cache.Store(
+        key, CacheEntry{
+                 g, ga.GetFirst(), ga.GetFollow(), tables.GetStates(),
+                 tables.GetTransitions(), tables.GetTables().Clone()
+             }
+    );
+    auto path = std::filesystem::directory_iterator(folder)->path();
+    std::string stored;
+    {
+        std::ifstream in(path, std::ios::binary);
+        stored.assign(std::istreambuf_iterator<char>(in), {});
+    }
+    REQUIRE(cache.Load(key).has_value());
+
+    // a flipped version is an incompatible entry, anything else is an error
+    for (size_t i = 0; i < stored.size(); ++i) {
+        std::string corrupted = stored;
+        corrupted[i] = static_cast<char>(corrupted[i] ^ 0x10);
+        {
+            std::ofstream out(path, std::ios::binary | std::ios::trunc);
+            out << corrupted;
+        }
+        std::optional<CacheEntry> loaded;
+        try {
+            loaded = cache.Load(key);
+        } catch (const GenerationCacheError &) {
+        }
+        REQUIRE_FALSE(loaded.has_value());
+    }
+
+    std::filesystem::remove_all(folder);
+}
@@ -162,3 +162,93 @@ TEST_CASE(
         REQUIRE(follow[NonTerminal{"S"}] == std::set<Terminal>({T_EOF}));
     }
 }
+
+TEST_CASE(
+    "GrammarAnalyzer computes identical sets incrementally",
+    "[GrammarAnalyzer]"
+) {
+    std::string prev_input = R"(
+        int = [0-9]+
+        <S> = <E>
+        <E> = <T> <R>
+        <R> = '+' <T> <R> | EPSILON
+        <T> = <F> <Q>
+        <Q> = '*' <F> <Q> | EPSILON
+        <F> = '(' <E> ')' | int
+    )";
+    std::string input = R"(
+        int = [0-9]+
+        <S> = <E>
+        <E> = <T> <R>
+        <R> = '+' <T> <R> | '-' <T> <R> | EPSILON
+        <T> = <F> <Q>
+        <Q> = '*' <F> <Q> | EPSILON
+        <F> = '(' <E> ')' | int | '-' <F>
+    )";
+
+    GrammarParser prev_gp(MakeStream(prev_input));
+    REQUIRE_NOTHROW(prev_gp.Parse());
+    Grammar prev_g = prev_gp.Get();
+    GrammarAnalyzer prev_ga(prev_g);
+
+    GrammarParser gp(MakeStream(input));
+    REQUIRE_NOTHROW(gp.Parse());
+    Grammar g = gp.Get();
+    GrammarAnalyzer full(g);
+    GrammarAnalyzer incremental(
+        g, prev_g, prev_ga.GetFirst(), prev_ga.GetFollow()
+    );
+
+    REQUIRE(incremental.GetFirst() == full.GetFirst());
+    REQUIRE(incremental.GetFollow() == full.GetFollow());
+
+    REQUIRE(incremental.GetDiff().has_value());
+    const GrammarDiff &diff = incremental.GetDiff().value();
+    REQUIRE(diff.changed_.contains(NonTerminal{"R"}));
+    REQUIRE(diff.changed_.contains(NonTerminal{"F"}));
+    REQUIRE_FALSE(diff.changed_.contains(NonTerminal{"Q"}));
+    REQUIRE(diff.rule_mapping_.size() == prev_g.rules_.size());
+    REQUIRE(diff.recomputed_first_ < full.GetFirst().size());
+}
+
+TEST_CASE(
+    "GrammarAnalyzer recomputes only the sets a local edit affects",
+    "[GrammarAnalyzer]"
+) {
+    std::string prev_input = R"(
+        int = [0-9]+
+        <S> = <E>
+        <E> = <T> <R>
+        <R> = '+' <T> <R> | EPSILON
+        <T> = int
+    )";
+    std::string input = R"(
+        int = [0-9]+
+        <S> = <E>
+        <E> = <T> <R>
+        <R> = '+' <T> <R> | '-' <T> <R> | EPSILON
+        <T> = int
+    )";
+
+    GrammarParser prev_gp(MakeStream(prev_input));
+    REQUIRE_NOTHROW(prev_gp.Parse());
+    Grammar prev_g = prev_gp.Get();
+    GrammarAnalyzer prev_ga(prev_g);
+
+    GrammarParser gp(MakeStream(input));
+    REQUIRE_NOTHROW(gp.Parse());
+    Grammar g = gp.Get();
+    GrammarAnalyzer full(g);
+    GrammarAnalyzer incremental(
+        g, prev_g, prev_ga.GetFirst(), prev_ga.GetFollow()
+    );
+
+    REQUIRE(incremental.GetFirst() == full.GetFirst());
+    REQUIRE(incremental.GetFollow() == full.GetFollow());
+
+    // <E> starts with <T>, which isn't nullable, so only FIRST(<R>) changes
+    const GrammarDiff &diff = incremental.GetDiff().value();
+    REQUIRE(diff.recomputed_first_ == 1);
+    REQUIRE(diff.recomputed_first_ < full.GetFollow().size());
+    REQUIRE(diff.recomputed_follow_ < full.GetFollow().size());
+}
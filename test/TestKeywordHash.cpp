@@ -0,0 +1,39 @@
+#define CATCH_CONFIG_MAIN
+
+#include <catch2/catch_test_macros.hpp>
+
+#include "KeywordHash.h"
+
+TEST_CASE("KeywordHash finds every keyword", "[KeywordHash]") {
+    std::vector<std::string> keywords = {"let", "while", "if", "else", "in"};
+    KeywordHash hash(keywords);
+    for (size_t k = 0; k < keywords.size(); ++k) {
+        REQUIRE(hash.Find(keywords[k]) == k);
+    }
+    REQUIRE(hash.Find("letter") == std::nullopt);
+    REQUIRE(hash.Find("i") == std::nullopt);
+    REQUIRE(hash.Find("") == std::nullopt);
+    // 5 keywords at a load factor of at most 0.8
+    REQUIRE(hash.GetSlots().size() == 8);
+    REQUIRE(hash.GetSeeds().size() == 2);
+
+    KeywordHash empty({});
+    REQUIRE(empty.Find("let") == std::nullopt);
+}
+
+TEST_CASE("KeywordHash places many keywords", "[KeywordHash]") {
+    std::vector<std::string> keywords;
+    for (size_t k = 0; k < 1000; ++k) {
+        keywords.push_back("KW" + std::to_string(k * 7919));
+    }
+    KeywordHash hash(keywords);
+    size_t used = 0;
+    for (uint32_t slot : hash.GetSlots()) {
+        used += slot != 0;
+    }
+    REQUIRE(used == keywords.size());
+    for (size_t k = 0; k < keywords.size(); ++k) {
+        REQUIRE(hash.Find(keywords[k]) == k);
+        REQUIRE(hash.Find(keywords[k] + "_") == std::nullopt);
+    }
+}
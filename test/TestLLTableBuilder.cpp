@@ -0,0 +1,93 @@
+#define CATCH_CONFIG_MAIN
+
+#include <catch2/catch_test_macros.hpp>
+
+#include "BNFParser.h"
+#include "Entities.h"
+#include "GrammarAnalyzer.h"
+#include "Helpers.h"
+#include "LLTableBuilder.h"
+#include "TestHelpers.h"
+
+TEST_CASE("LLParserTables builds predictive table", "[LLTableBuilder]") {
+    std::string input = R"(
+        int = [0-9]+
+        <S> = <T> <E>
+        <E> = '+' <T> <E> | EPSILON
+        <T> = int | '(' <S> ')'
+    )";
+
+    GrammarParser gp(MakeStream(input));
+    REQUIRE_NOTHROW(gp.Parse());
+    Grammar g = gp.Get();
+    GrammarAnalyzer ga(g);
+    LLParserTables tables(g, ga);
+    REQUIRE_NOTHROW(tables.Generate());
+
+    REQUIRE(tables.IsLL1());
+    REQUIRE(tables.GetConflicts().empty());
+
+    const PredictTable &table = tables.GetTable();
+    auto predicted = [&](const std::string &nt, const Terminal &t) {
+        return g[table.at(NonTerminal{nt}).at(QualName(t))];
+    };
+
+    REQUIRE(
+        predicted("S", Terminal{"int", " "}).prod ==
+        std::vector<Token>({NonTerminal{"T"}, NonTerminal{"E"}})
+    );
+    REQUIRE(
+        predicted("S", Terminal{"("}).prod ==
+        std::vector<Token>({NonTerminal{"T"}, NonTerminal{"E"}})
+    );
+    REQUIRE(
+        predicted("E", Terminal{"+"}).prod ==
+        std::vector<Token>({Terminal{"+"}, NonTerminal{"T"}, NonTerminal{"E"}})
+    );
+    REQUIRE(predicted("E", T_EOF).prod == std::vector<Token>({EPSILON}));
+    REQUIRE(predicted("E", Terminal{")"}).prod == std::vector<Token>({EPSILON}));
+    REQUIRE(
+        predicted("T", Terminal{"("}).prod ==
+        std::vector<Token>({Terminal{"("}, NonTerminal{"S"}, Terminal{")"}})
+    );
+    REQUIRE_FALSE(table.at(NonTerminal{"T"}).contains(QualName(T_EOF)));
+}
+
+TEST_CASE("LLParserTables reports conflicts", "[LLTableBuilder]") {
+    SECTION("Left recursion") {
+        std::string input = R"(
+            int = [0-9]+
+            <S> = <S> '+' int | int
+        )";
+        GrammarParser gp(MakeStream(input));
+        REQUIRE_NOTHROW(gp.Parse());
+        Grammar g = gp.Get();
+        GrammarAnalyzer ga(g);
+        LLParserTables tables(g, ga);
+        tables.Generate();
+
+        REQUIRE_FALSE(tables.IsLL1());
+        REQUIRE(tables.GetConflicts().size() == 1);
+        const LLConflict &conflict = tables.GetConflicts()[0];
+        REQUIRE(conflict.nt_ == NonTerminal{"S"});
+        REQUIRE(conflict.lookahead_ == Terminal{"int", " "});
+        REQUIRE(conflict.first_rule_ != conflict.second_rule_);
+        REQUIRE_FALSE(tables.DescribeConflicts().empty());
+    }
+
+    SECTION("Common prefix") {
+        std::string input = R"(
+            <S> = 'a' 'b' | 'a' 'c'
+        )";
+        GrammarParser gp(MakeStream(input));
+        REQUIRE_NOTHROW(gp.Parse());
+        Grammar g = gp.Get();
+        GrammarAnalyzer ga(g);
+        LLParserTables tables(g, ga);
+        tables.Generate();
+
+        REQUIRE_FALSE(tables.IsLL1());
+        REQUIRE(tables.GetConflicts().size() == 1);
+        REQUIRE(tables.GetConflicts()[0].lookahead_ == Terminal{"a"});
+    }
+}
@@ -0,0 +1,194 @@
+#define CATCH_CONFIG_MAIN
+
+#include <catch2/catch_test_macros.hpp>
+
+#include "BNFParser.h"
+#include "DenseTables.h"
+#include "Entities.h"
+#include "GrammarAnalyzer.h"
+#include "Helpers.h"
+#include "LayoutProfile.h"
+#include "TableBuilder.h"
+#include "TableOptimizer.h"
+#include "TestHelpers.h"
+
+namespace {
+DenseTables BuildTables(const std::string &input, Grammar &g) {
+    GrammarParser gp(MakeStream(input));
+    gp.Parse();
+    g = gp.Get();
+    GrammarAnalyzer ga(g);
+    ParserTables tables(g, ga);
+    tables.Generate();
+    return tables.TakeTables();
+}
+
+/**
+ * @brief Runs the shift-reduce loop of the generated parser over the tables
+ * and counts the visits and the shifts the way the profiling parser does.
+ * @return Whether the input is accepted.
+ */
+bool Run(
+    const Grammar &g, const DenseTables &tables,
+    const std::vector<Terminal> &input, LayoutProfile &profile
+) {
+    std::vector<size_t> states{0};
+    size_t pos = 0;
+    while (true) {
+        Terminal a = pos < input.size() ? input[pos] : T_EOF;
+        profile.AddStateVisits(states.back(), 1);
+        Action action = tables.action_.Resolve(
+            states.back(),
+            tables.GetTerminalColumn(tables.symbols_.GetTerminalId(a))
+        );
+        switch (action.type_) {
+            case ActionType::SHIFT:
+                profile.AddTerminalShifts(QualName(a), 1);
+                states.push_back(action.value_);
+                ++pos;
+                break;
+            case ActionType::REDUCE: {
+                const Rule &rule = g[action.value_];
+                if (rule.prod[0] != Token(EPSILON)) {
+                    states.resize(states.size() - rule.prod.size());
+                }
+                std::optional<size_t> target = tables.goto_.Get(
+                    states.back(), tables.symbols_.GetNonTerminalId(rule.lhs)
+                );
+                if (!target.has_value()) {
+                    return false;
+                }
+                states.push_back(target.value());
+                break;
+            }
+            case ActionType::ACCEPT:
+                return true;
+            default:
+                return false;
+        }
+    }
+}
+
+const std::string kExpressions = R"(
+    num = [0-9]+
+    <S> = <Sum>
+    <Sum> = <Sum> '+' <Prod> | <Prod>
+    <Prod> = <Prod> '*' <Atom> | <Atom>
+    <Atom> = num | '(' <Sum> ')'
+)";
+
+const Terminal num{"num", "[0-9]+"}, plus{"+"}, times{"*"}, open{"("},
+    close{")"};
+
+const std::vector<std::vector<Terminal>> kCorpus = {
+    {num, plus, num, plus, num, plus, num},
+    {num, plus, num, times, num, plus, num},
+    {num, plus, num},
+    {open, num, plus, num, close, times, num},
+};
+
+const std::vector<std::vector<Terminal>> kInputs = {
+    {num},
+    {open, open, num, close, close},
+    {num, plus},
+    {open, num},
+    {num, close},
+    {num, num},
+};
+}  // namespace
+
+TEST_CASE("LayoutProfile reads a written profile", "[LayoutProfile]") {
+    LayoutProfile profile = LayoutProfile::Read(*MakeStream(
+        "pargen-profile 1 1f 4\n"
+        "state 0 7\n"
+        "state 3 2\n"
+        "state 3 1\n"
+        "\n"
+        "terminal 5 T_+\n"
+        "terminal 2 T_a b\n"
+    ));
+    REQUIRE(profile.GetFingerprint() == 0x1f);
+    REQUIRE(profile.GetStateCount() == 4);
+    REQUIRE(profile.GetStateVisits(0) == 7);
+    REQUIRE(profile.GetStateVisits(1) == 0);
+    REQUIRE(profile.GetStateVisits(3) == 3);
+    REQUIRE(profile.GetTerminalShifts("T_+") == 5);
+    REQUIRE(profile.GetTerminalShifts("T_a b") == 2);
+    REQUIRE(profile.GetTerminalShifts("T_*") == 0);
+
+    REQUIRE_THROWS_AS(
+        LayoutProfile::Read(*MakeStream("state 0 1\n")), LayoutProfileError
+    );
+    REQUIRE_THROWS_AS(
+        LayoutProfile::Read(*MakeStream("pargen-profile 2 1f 4\n")),
+        LayoutProfileError
+    );
+    // state 4 doesn't exist, the terminal has no name
+    const std::string header = "pargen-profile 1 1f 4\n";
+    REQUIRE_THROWS_AS(
+        LayoutProfile::Read(*MakeStream(header + "state 4 1\n")),
+        LayoutProfileError
+    );
+    REQUIRE_THROWS_AS(
+        LayoutProfile::Read(*MakeStream(header + "terminal 1\n")),
+        LayoutProfileError
+    );
+}
+
+TEST_CASE("ApplyProfile puts the most used rows first", "[LayoutProfile]") {
+    Grammar g;
+    DenseTables tables = BuildTables(kExpressions, g);
+    DenseTables plain = tables.Clone();
+    LayoutProfile profile(
+        LayoutProfile::Fingerprint(tables), tables.action_.GetStateCount()
+    );
+    for (const auto &input : kCorpus) {
+        REQUIRE(Run(g, tables, input, profile));
+    }
+
+    TableOptimizer optimizer(g, tables);
+    ProfileLayoutStats stats = optimizer.ApplyProfile(profile);
+    REQUIRE(stats.states_ == plain.action_.GetStateCount());
+    REQUIRE(stats.hot_states_ < stats.states_);
+    REQUIRE(stats.columns_ == plain.action_.GetTerminalCount());
+    REQUIRE(stats.hot_columns_ <= stats.columns_);
+    REQUIRE(tables.action_.GetStateCount() == stats.states_);
+
+    LayoutProfile renumbered(
+        LayoutProfile::Fingerprint(tables), tables.action_.GetStateCount()
+    );
+    for (const auto &input : kCorpus) {
+        REQUIRE(Run(g, tables, input, renumbered));
+    }
+    REQUIRE(renumbered.GetStateVisits(0) == profile.GetStateVisits(0));
+    for (size_t s = 2; s < stats.states_; ++s) {
+        REQUIRE(
+            renumbered.GetStateVisits(s - 1) >= renumbered.GetStateVisits(s)
+        );
+    }
+    // the columns are sorted by the shifts of their terminals
+    const SymbolIds &ids = tables.symbols_;
+    REQUIRE(tables.GetTerminalColumn(ids.GetTerminalId(num)) == 0);
+    REQUIRE(tables.GetTerminalColumn(ids.GetTerminalId(plus)) == 1);
+    REQUIRE(tables.GetTerminalColumn(ids.GetTerminalId(times)) == 2);
+
+    LayoutProfile ignored(
+        LayoutProfile::Fingerprint(plain), plain.action_.GetStateCount()
+    );
+    for (const auto &input : kInputs) {
+        REQUIRE(
+            Run(g, tables, input, renumbered) == Run(g, plain, input, ignored)
+        );
+    }
+}
+
+TEST_CASE("ApplyProfile rejects a profile of other tables", "[LayoutProfile]") {
+    Grammar g;
+    DenseTables tables = BuildTables(kExpressions, g);
+    TableOptimizer optimizer(g, tables);
+    LayoutProfile profile(
+        LayoutProfile::Fingerprint(tables), tables.action_.GetStateCount()
+    );
+    optimizer.AddDefaultReductions(DefaultReductions::CONSISTENT);
+    REQUIRE_THROWS_AS(optimizer.ApplyProfile(profile), LayoutProfileError);
+}
@@ -0,0 +1,167 @@
+#define CATCH_CONFIG_MAIN
+
+#include <algorithm>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include "LexerAutomaton.h"
+
+namespace {
+using MatchResult = std::optional<std::pair<size_t, size_t>>;
+
+MatchResult Matched(size_t pattern, size_t length) {
+    return std::make_pair(pattern, length);
+}
+}  // namespace
+
+TEST_CASE("LexerAutomaton takes the longest match", "[LexerAutomaton]") {
+    LexerAutomaton dfa({"\"let\"", "\"=\"", "[a-zA-Z][a-zA-Z0-9]*", "[ \\t\\n]+"}
+    );
+    REQUIRE(dfa.Match("let x") == Matched(0, 3));
+    // the identifier is longer than the keyword
+    REQUIRE(dfa.Match("letter = 1") == Matched(2, 6));
+    REQUIRE(dfa.Match("le") == Matched(2, 2));
+    REQUIRE(dfa.Match("=") == Matched(1, 1));
+    REQUIRE(dfa.Match(" \t\nx") == Matched(3, 3));
+    REQUIRE(dfa.Match("1") == std::nullopt);
+    REQUIRE(dfa.Match("") == std::nullopt);
+
+    // of the patterns matching the same prefix the first one wins
+    LexerAutomaton swapped({"[a-z]+", "\"let\""});
+    REQUIRE(swapped.Match("let") == Matched(0, 3));
+}
+
+TEST_CASE("LexerAutomaton compiles the flex syntax", "[LexerAutomaton]") {
+    LexerAutomaton json({"\\\"[^\\\"]*\\\"", "-?[0-9]+(\\.[0-9]+)?"});
+    REQUIRE(json.Match("\"a b\\n\" rest") == Matched(0, 7));
+    REQUIRE(json.Match("-12.5e") == Matched(1, 5));
+    REQUIRE(json.Match("12.") == Matched(1, 2));
+    REQUIRE(json.Match("\"unterminated") == std::nullopt);
+
+    LexerAutomaton misc(
+        {"a{2,3}", "b{2}", "c{2,}", "\\x41|\\102", "[[:digit:]_]+", ".",
+         "\"+\"|\"\\n\""}
+    );
+    REQUIRE(misc.Match("aaaa") == Matched(0, 3));
+    REQUIRE(misc.Match("bbb") == Matched(1, 2));
+    REQUIRE(misc.Match("ccccc") == Matched(2, 5));
+    REQUIRE(misc.Match("c") == Matched(5, 1));
+    REQUIRE(misc.Match("AB") == Matched(3, 1));
+    REQUIRE(misc.Match("B") == Matched(3, 1));
+    REQUIRE(misc.Match("1_2x") == Matched(4, 3));
+    // `.` doesn't match a newline
+    REQUIRE(misc.Match("\n") == Matched(6, 1));
+    REQUIRE(LexerAutomaton({"."}).Match("\n") == std::nullopt);
+    REQUIRE(LexerAutomaton({"[^a]"}).Match("\n") == Matched(0, 1));
+    REQUIRE(LexerAutomaton({"[]a-]+"}).Match("]-a]b") == Matched(0, 4));
+
+    // trailing whitespace ends the pattern
+    REQUIRE(LexerAutomaton({"[ ]+  "}).Match("  ") == Matched(0, 2));
+
+    const std::vector<std::string> invalid = {
+        "(a",  "a)",   "[a",    "\"a",    "a b",   "^a",       "a$",
+        "a/b", "*a",   "{num}", "a{3,2}", "[b-a]", "[[:foo:]]", "a\\",
+    };
+    for (const std::string &pattern : invalid) {
+        REQUIRE_THROWS_AS(LexerAutomaton({pattern}), RegexError);
+    }
+}
+
+TEST_CASE("LexerAutomaton minimizes the DFA", "[LexerAutomaton]") {
+    // dead, start, after a letter; both keywords and identifiers collapse
+    // into the last one as they are the same pattern
+    LexerAutomaton dfa({"[a-z]+|\"if\"|\"in\""});
+    REQUIRE(dfa.GetStateCount() == 3);
+    // letters and everything else
+    REQUIRE(dfa.GetClassCount() == 2);
+    REQUIRE(dfa.GetAccept(0) == std::nullopt);
+    REQUIRE(dfa.GetAccept(1) == std::nullopt);
+    REQUIRE(dfa.GetAccept(2) == 0);
+    size_t letter = dfa.GetClasses()['q'];
+    REQUIRE(dfa.GetClasses()['i'] == letter);
+    REQUIRE(dfa.GetClasses()['0'] != letter);
+    REQUIRE(dfa.GetNext(1, letter) == 2);
+    REQUIRE(dfa.GetNext(2, letter) == 2);
+    REQUIRE(dfa.GetNext(2, dfa.GetClasses()['0']) == 0);
+
+    // separate patterns keep their states apart
+    LexerAutomaton keywords({"\"if\"", "[a-z]+"});
+    REQUIRE(keywords.GetStateCount() == 5);
+    REQUIRE(keywords.GetClassCount() == 4);
+    REQUIRE(keywords.Match("if") == Matched(0, 2));
+    REQUIRE(keywords.Match("iff") == Matched(1, 3));
+}
+
+TEST_CASE("LexerAutomaton finds the loops of the states", "[LexerAutomaton]") {
+    LexerAutomaton dfa({"\"//\"[^\\n]*", "[ \\t]+", "\"/\""});
+    // the dead state loops on everything
+    REQUIRE(dfa.GetLoopBytes(0).size() == 256);
+    REQUIRE(dfa.GetLoopBytes(1).empty());
+
+    size_t space = dfa.GetNext(1, dfa.GetClasses()[' ']);
+    REQUIRE(dfa.GetLoopBytes(space) == std::vector<unsigned char>{'\t', ' '});
+
+    size_t slash = dfa.GetNext(1, dfa.GetClasses()['/']);
+    REQUIRE(dfa.GetLoopBytes(slash).empty());
+    size_t comment = dfa.GetNext(slash, dfa.GetClasses()['/']);
+    std::vector<unsigned char> loop = dfa.GetLoopBytes(comment);
+    REQUIRE(loop.size() == 255);
+    REQUIRE(std::find(loop.begin(), loop.end(), '\n') == loop.end());
+}
+
+TEST_CASE(
+    "LexerAutomaton counts the states continuing with a byte",
+    "[LexerAutomaton]"
+) {
+    LexerAutomaton dfa({"\"//\"[^\\n]*", "[ \\t]+", "\"/\"", "[a-z]+"});
+    // every match ends at a newline
+    REQUIRE(dfa.CountContinuing('\n') == 0);
+    // the comment and the whitespace
+    REQUIRE(dfa.CountContinuing(' ') == 2);
+    // the comment and the identifier, the slash starting the comment
+    REQUIRE(dfa.CountContinuing('a') == 2);
+    REQUIRE(dfa.CountContinuing('/') == 2);
+
+    // a string goes on with anything
+    LexerAutomaton strings({"\\\"[^\\\"]*\\\""});
+    REQUIRE(strings.CountContinuing('\n') == 1);
+    REQUIRE(strings.CountContinuing('"') == 1);
+}
+
+TEST_CASE("LexerAutomaton compiles UTF-8 classes", "[LexerAutomaton]") {
+    LexerAutomaton identifiers({"[a-zA-Z_\\u00c0-\\u{24F}\\u0400-\\u04FF]+"});
+    REQUIRE(identifiers.Match("caf\xc3\xa9 x") == Matched(0, 5));
+    REQUIRE(identifiers.Match("\xd0\x9f\xd1\x80\xd0\xb8") == Matched(0, 6));
+    // a lone continuation byte and a character outside the ranges
+    REQUIRE(identifiers.Match("a\xa9") == Matched(0, 1));
+    REQUIRE(identifiers.Match("\xe4\xb8\xad") == std::nullopt);
+
+    // the characters of the pattern itself are UTF-8 too
+    LexerAutomaton literal({"[\xc3\xa0-\xc3\xbf]+", "\xc3\xa9+"});
+    REQUIRE(literal.Match("\xc3\xa0\xc3\xbf!") == Matched(0, 4));
+    // the repetition applies to the whole character
+    LexerAutomaton repeated({"\xc3\xa9+"});
+    REQUIRE(repeated.Match("\xc3\xa9\xc3\xa9") == Matched(0, 4));
+    REQUIRE(repeated.Match("\xc3\xa9\xa9") == Matched(0, 2));
+
+    // the negation matches the valid encodings of the other code points only
+    LexerAutomaton negated({"[^\"\\u{5c}]+"});
+    REQUIRE(negated.Match("a\xf0\x9f\x98\x80" "b\"") == Matched(0, 6));
+    REQUIRE(negated.Match("a\xc3") == Matched(0, 1));
+    REQUIRE(negated.Match("a\xed\xa0\x80") == Matched(0, 1));
+    REQUIRE(negated.Match("\xc0\xaf") == std::nullopt);
+    // a class without code points still matches bytes
+    REQUIRE(LexerAutomaton({"[^a]"}).Match("\xff") == Matched(0, 1));
+
+    LexerAutomaton escapes({"\"\\u{1F600}\"", "\\U0001F601"});
+    REQUIRE(escapes.Match("\xf0\x9f\x98\x80") == Matched(0, 4));
+    REQUIRE(escapes.Match("\xf0\x9f\x98\x81") == Matched(1, 4));
+
+    const std::vector<std::string> invalid = {
+        "\\u12", "\\u{}", "\\u{110000}", "\\uD800", "[\\xff\\u00e9]",
+        "[\\u00e9-a]",
+    };
+    for (const std::string &pattern : invalid) {
+        REQUIRE_THROWS_AS(LexerAutomaton({pattern}), RegexError);
+    }
+}
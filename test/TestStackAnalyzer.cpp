@@ -0,0 +1,71 @@
+#define CATCH_CONFIG_MAIN
+
+#include <catch2/catch_test_macros.hpp>
+
+#include "Automaton.h"
+#include "BNFParser.h"
+#include "Entities.h"
+#include "GrammarAnalyzer.h"
+#include "StackAnalyzer.h"
+#include "TestHelpers.h"
+
+TEST_CASE("StackAnalyzer classifies recursion", "[StackAnalyzer]") {
+    std::string input = R"(
+        id = [a-z]+
+        <S> = <List> <Sum>
+        <List> = <Item> <List> | EPSILON
+        <Item> = id ';'
+        <Sum> = <Sum> '+' <F> | <F>
+        <F> = id | '(' <Sum> ')'
+    )";
+
+    GrammarParser gp(MakeStream(input));
+    REQUIRE_NOTHROW(gp.Parse());
+    Grammar g = gp.Get();
+    GrammarAnalyzer ga(g);
+    Automaton a(g, ga);
+    StackAnalyzer sa(g, ga, a.GetTransitions());
+
+    std::map<std::string, RecursionInfo> info;
+    for (const RecursionInfo &nt_info : sa.GetRecursion()) {
+        info.emplace(nt_info.nt_.name_, nt_info);
+    }
+    REQUIRE(info.size() == 3);
+    REQUIRE(info.at("List").kind_ == RecursionKind::RIGHT);
+    REQUIRE(info.at("List").sites_.size() == 1);
+    REQUIRE(info.at("List").sites_[0].entries_per_element_ == 1);
+    // `<Sum>` is left-recursive, but also embeds itself through `<F>`
+    REQUIRE(info.at("Sum").kind_ == RecursionKind::NESTED);
+    REQUIRE(info.at("F").kind_ == RecursionKind::NESTED);
+    REQUIRE(info.at("F").sites_[0].entries_per_element_ == 1);
+
+    REQUIRE_FALSE(sa.GetMaxDepth().has_value());
+    REQUIRE_FALSE(sa.GetCycles().empty());
+    for (const StackCycle &cycle : sa.GetCycles()) {
+        REQUIRE(cycle.min_growth_ >= 1);
+    }
+    REQUIRE(sa.Describe().find("right-recursive") != std::string::npos);
+}
+
+TEST_CASE("StackAnalyzer bounds the stack", "[StackAnalyzer]") {
+    std::string input = R"(
+        int = [0-9]+
+        <S> = <S> '+' <T> | <T>
+        <T> = <T> '*' int | int
+    )";
+
+    GrammarParser gp(MakeStream(input));
+    REQUIRE_NOTHROW(gp.Parse());
+    Grammar g = gp.Get();
+    GrammarAnalyzer ga(g);
+    Automaton a(g, ga);
+    StackAnalyzer sa(g, ga, a.GetTransitions());
+
+    REQUIRE(sa.GetRecursion().size() == 2);
+    for (const RecursionInfo &info : sa.GetRecursion()) {
+        REQUIRE(info.kind_ == RecursionKind::LEFT);
+    }
+    REQUIRE(sa.GetCycles().empty());
+    // the deepest stack is `0 S + T * int`
+    REQUIRE(sa.GetMaxDepth() == 6);
+}
@@ -49,3 +49,91 @@ TEST_CASE("TableBuilder detects ambiguous grammar", "[TableBuilder]") {
     ParserTables tables(g, ga);
     REQUIRE_THROWS_AS(tables.Generate(), TableGeneratorError);
 }
+
+TEST_CASE(
+    "TableBuilder rebuilds identical tables incrementally", "[TableBuilder]"
+) {
+    std::string prev_input = R"(
+        id = [a-z]+
+        num = [0-9]+
+        <S> = <StatementList>
+        <StatementList> = <Statement> <StatementList> | EPSILON
+        <Statement> = 'let' id '=' <E> ';' | 'print' <E> ';'
+        <E> = <E> '+' <T> | <T>
+        <T> = <T> '*' <F> | <F>
+        <F> = '(' <E> ')' | id | num
+    )";
+    std::vector<std::string> edits = {
+        // new alternative of an existing rule
+        R"(
+        id = [a-z]+
+        num = [0-9]+
+        <S> = <StatementList>
+        <StatementList> = <Statement> <StatementList> | EPSILON
+        <Statement> = 'let' id '=' <E> ';' | 'print' <E> ';'
+        <E> = <E> '+' <T> | <E> '-' <T> | <T>
+        <T> = <T> '*' <F> | <F>
+        <F> = '(' <E> ')' | id | num
+    )",
+        // removed alternative and a new non-terminal
+        R"(
+        id = [a-z]+
+        num = [0-9]+
+        <S> = <StatementList>
+        <StatementList> = <Statement> <StatementList> | EPSILON
+        <Statement> = 'let' id '=' <E> ';' | <Block>
+        <Block> = '{' <StatementList> '}'
+        <E> = <E> '+' <T> | <T>
+        <T> = <T> '*' <F> | <F>
+        <F> = '(' <E> ')' | id
+    )",
+    };
+
+    GrammarParser prev_gp(MakeStream(prev_input));
+    REQUIRE_NOTHROW(prev_gp.Parse());
+    Grammar prev_g = prev_gp.Get();
+    GrammarAnalyzer prev_ga(prev_g);
+    ParserTables prev_tables(prev_g, prev_ga);
+    REQUIRE_NOTHROW(prev_tables.Generate());
+
+    for (const std::string &input : edits) {
+        GrammarParser gp(MakeStream(input));
+        REQUIRE_NOTHROW(gp.Parse());
+        Grammar g = gp.Get();
+
+        GrammarAnalyzer full_ga(g);
+        ParserTables full(g, full_ga);
+        REQUIRE_NOTHROW(full.Generate());
+
+        GrammarAnalyzer incremental_ga(
+            g, prev_g, prev_ga.GetFirst(), prev_ga.GetFollow()
+        );
+        ParserTables incremental(
+            g, incremental_ga, prev_tables.GetStates(),
+            prev_tables.GetTransitions()
+        );
+        REQUIRE_NOTHROW(incremental.Generate());
+
+        REQUIRE(incremental.GetReusedStates() > 0);
+        REQUIRE(incremental.GetStates().size() == full.GetStates().size());
+        for (size_t i = 0; i < full.GetStates().size(); ++i) {
+            REQUIRE(
+                incremental.GetStates().left.at(i) ==
+                full.GetStates().left.at(i)
+            );
+        }
+        REQUIRE(incremental.GetTransitions() == full.GetTransitions());
+        REQUIRE(incremental.GetGotoTable() == full.GetGotoTable());
+
+        ActionTable full_action = full.GetActionTable();
+        ActionTable incremental_action = incremental.GetActionTable();
+        REQUIRE(incremental_action.size() == full_action.size());
+        for (size_t i = 0; i < full_action.size(); ++i) {
+            REQUIRE(incremental_action[i].size() == full_action[i].size());
+            for (const auto &[key, action] : full_action[i]) {
+                REQUIRE(incremental_action[i].at(key).type_ == action.type_);
+                REQUIRE(incremental_action[i].at(key).value_ == action.value_);
+            }
+        }
+    }
+}
@@ -0,0 +1,198 @@
+#define CATCH_CONFIG_MAIN
+
+#include <catch2/catch_test_macros.hpp>
+#include <cstring>
+
+#include "BNFParser.h"
+#include "DenseTables.h"
+#include "Entities.h"
+#include "GrammarAnalyzer.h"
+#include "Helpers.h"
+#include "TableBuilder.h"
+#include "TableBundle.h"
+#include "TableOptimizer.h"
+#include "TestHelpers.h"
+
+namespace {
+struct Built {
+    Grammar g;
+    FollowSets follow;
+    DenseTables tables;
+};
+
+Built Build(const std::string &input) {
+    GrammarParser gp(MakeStream(input));
+    gp.Parse();
+    Built built;
+    built.g = gp.Get();
+    GrammarAnalyzer ga(built.g);
+    built.follow = ga.GetFollow();
+    ParserTables tables(built.g, ga);
+    tables.Generate();
+    built.tables = tables.TakeTables();
+    return built;
+}
+
+const std::string kExpressions = R"(
+    num = [0-9]+
+    <S> = <Sum>
+    <Sum> = <Sum> '+' <Prod> | <Prod>
+    <Prod> = <Prod> '*' <Atom> | <Atom>
+    <Atom> = num | '(' <Sum> ')' | '[' <Args> ']'
+    <Args> = <Sum> | EPSILON
+)";
+}  // namespace
+
+TEST_CASE("TableBundle stores the tables", "[TableBundle]") {
+    Built built = Build(kExpressions);
+    const DenseTables &tables = built.tables;
+    TableBundle bundle(built.g, tables, built.follow);
+    const std::vector<uint8_t> &bytes = bundle.GetBytes();
+    REQUIRE(std::memcmp(bytes.data(), "PGTB", 4) == 0);
+    REQUIRE(bytes.size() % 4 == 0);
+
+    TableBundleView view(bytes);
+    REQUIRE(view.GetColumns() == tables.action_.GetTerminalCount());
+    const SymbolIds &ids = tables.symbols_;
+    for (size_t s = 0; s < tables.action_.GetStateCount(); ++s) {
+        for (size_t t = 0; t < ids.GetTerminalCount(); ++t) {
+            Action expected = tables.action_.Resolve(s, t);
+            Action actual = view.GetAction(s, t);
+            REQUIRE(actual.type_ == expected.type_);
+            REQUIRE(actual.value_ == expected.value_);
+        }
+        for (size_t nt = 0; nt < ids.GetNonTerminalCount(); ++nt) {
+            REQUIRE(view.GetGoto(s, nt) == tables.goto_.Get(s, nt));
+        }
+    }
+
+    for (size_t t = 0; t < ids.GetTerminalCount(); ++t) {
+        REQUIRE(view.FindTerminal(ids.GetTerminalName(t)) == t);
+    }
+    REQUIRE_FALSE(view.FindTerminal("T_-").has_value());
+
+    std::span<const uint32_t> rules = view.GetSection(BundleSection::RULES);
+    std::span<const uint32_t> symbols =
+        view.GetSection(BundleSection::SYMBOLS);
+    REQUIRE(rules.size() == 3 * built.g.rules_.size());
+    for (size_t r = 0; r < built.g.rules_.size(); ++r) {
+        const Rule &rule = built.g[r];
+        REQUIRE(rules[3 * r] == ids.GetNonTerminalId(rule.lhs));
+        if (rule.prod[0] == Token(EPSILON)) {
+            REQUIRE(rules[3 * r + 2] == 0);
+            continue;
+        }
+        REQUIRE(rules[3 * r + 2] == rule.prod.size());
+        uint32_t first = symbols[rules[3 * r + 1]];
+        if (IsTerminal(rule.prod[0])) {
+            REQUIRE(
+                first ==
+                2 * ids.GetTerminalId(std::get<Terminal>(rule.prod[0]))
+            );
+        } else {
+            const NonTerminal &nt = std::get<NonTerminal>(rule.prod[0]);
+            REQUIRE(first == 2 * ids.GetNonTerminalId(nt) + 1);
+        }
+    }
+
+    std::span<const uint32_t> names =
+        view.GetSection(BundleSection::NONTERMINALS);
+    std::span<const uint32_t> index =
+        view.GetSection(BundleSection::FOLLOW_INDEX);
+    std::span<const uint32_t> follow = view.GetSection(BundleSection::FOLLOW);
+    REQUIRE(index.size() == ids.GetNonTerminalCount() + 1);
+    for (size_t nt = 0; nt < ids.GetNonTerminalCount(); ++nt) {
+        REQUIRE(
+            view.GetString(names[2 * nt], names[2 * nt + 1]) ==
+            ids.GetNonTerminal(nt).name_
+        );
+        auto it = built.follow.find(ids.GetNonTerminal(nt));
+        std::set<Terminal> expected;
+        if (it != built.follow.end()) {
+            expected = it->second;
+        }
+        REQUIRE(index[nt + 1] - index[nt] == expected.size());
+        for (size_t i = index[nt]; i < index[nt + 1]; ++i) {
+            REQUIRE(expected.contains(ids.GetTerminal(follow[i])));
+        }
+    }
+}
+
+TEST_CASE("TableBundle stores optimized tables", "[TableBundle]") {
+    Built built = Build(R"(
+        id = [a-z]+
+        <S> = <E>
+        <E> = <T>
+        <T> = <F>
+        <F> = id | '(' <E> ')' | id '+' id
+    )");
+    DenseTables &tables = built.tables;
+    TableOptimizer optimizer(built.g, tables);
+    optimizer.AddDefaultReductions(DefaultReductions::ALL);
+    optimizer.EliminateUnitRules(UnitRules::SYNTHESIZE);
+    optimizer.FuseShiftReduce();
+    optimizer.MergeTerminals();
+    REQUIRE_FALSE(tables.unit_chains_.empty());
+
+    TableBundle bundle(built.g, tables, built.follow);
+    TableBundleView view(bundle.GetBytes());
+    REQUIRE(view.GetColumns() == tables.action_.GetTerminalCount());
+    for (size_t s = 0; s < tables.action_.GetStateCount(); ++s) {
+        for (size_t c = 0; c < tables.action_.GetTerminalCount(); ++c) {
+            Action expected = tables.action_.Resolve(s, c);
+            REQUIRE(view.GetAction(s, c).type_ == expected.type_);
+            REQUIRE(view.GetAction(s, c).value_ == expected.value_);
+        }
+    }
+    std::span<const uint32_t> classes =
+        view.GetSection(BundleSection::TERMINAL_CLASSES);
+    REQUIRE(
+        std::vector<uint32_t>(classes.begin(), classes.end()) ==
+        tables.terminal_classes_
+    );
+
+    size_t nonterminals = tables.symbols_.GetNonTerminalCount();
+    std::span<const uint32_t> chains =
+        view.GetSection(BundleSection::UNIT_CHAINS);
+    std::span<const uint32_t> chain_symbols =
+        view.GetSection(BundleSection::UNIT_SYMBOLS);
+    REQUIRE(chains.size() == 3 * tables.unit_chains_.size());
+    size_t i = 0;
+    for (const auto &[key, chain] : tables.unit_chains_) {
+        REQUIRE(chains[3 * i] == key.first * nonterminals + key.second);
+        REQUIRE(
+            std::vector<size_t>(
+                chain_symbols.begin() + chains[3 * i + 1],
+                chain_symbols.begin() + chains[3 * i + 1] + chains[3 * i + 2]
+            ) == chain
+        );
+        ++i;
+    }
+}
+
+TEST_CASE("TableBundleView rejects foreign images", "[TableBundle]") {
+    Built built = Build(kExpressions);
+    TableBundle bundle(built.g, built.tables, built.follow);
+    std::vector<uint8_t> bytes = bundle.GetBytes();
+
+    std::vector<uint8_t> magic = bytes;
+    magic[0] = 'X';
+    REQUIRE_THROWS_AS(TableBundleView(magic), TableBundleError);
+
+    std::vector<uint8_t> version = bytes;
+    uint32_t next_version = TableBundle::kVersion + 1;
+    std::memcpy(version.data() + 4, &next_version, sizeof(next_version));
+    REQUIRE_THROWS_AS(TableBundleView(version), TableBundleError);
+
+    std::vector<uint8_t> swapped = bytes;
+    std::swap(swapped[8], swapped[11]);
+    std::swap(swapped[9], swapped[10]);
+    REQUIRE_THROWS_AS(TableBundleView(swapped), TableBundleError);
+
+    std::vector<uint8_t> truncated(bytes.begin(), bytes.end() - 4);
+    REQUIRE_THROWS_AS(TableBundleView(truncated), TableBundleError);
+
+    std::vector<uint8_t> empty;
+    REQUIRE_THROWS_AS(TableBundleView(empty), TableBundleError);
+    REQUIRE_NOTHROW(TableBundleView(bytes));
+}
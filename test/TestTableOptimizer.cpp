@@ -0,0 +1,395 @@
+#define CATCH_CONFIG_MAIN
+
+#include <catch2/catch_test_macros.hpp>
+
+#include "BNFParser.h"
+#include "CombTables.h"
+#include "DenseTables.h"
+#include "Entities.h"
+#include "GrammarAnalyzer.h"
+#include "Helpers.h"
+#include "TableBuilder.h"
+#include "TableOptimizer.h"
+#include "TestHelpers.h"
+
+namespace {
+DenseTables BuildTables(const std::string &input, Grammar *grammar = nullptr) {
+    GrammarParser gp(MakeStream(input));
+    gp.Parse();
+    Grammar g = gp.Get();
+    GrammarAnalyzer ga(g);
+    ParserTables tables(g, ga);
+    tables.Generate();
+    if (grammar != nullptr) {
+        *grammar = g;
+    }
+    return tables.TakeTables();
+}
+
+/**
+ * @brief Runs the shift-reduce loop of the generated parser over the tables.
+ * @return Whether the input is accepted.
+ */
+bool Accepts(
+    const Grammar &g, const DenseTables &tables,
+    const std::vector<Terminal> &input
+) {
+    std::vector<size_t> states{0};
+    size_t pos = 0;
+    while (true) {
+        Terminal a = pos < input.size() ? input[pos] : T_EOF;
+        Action action = tables.action_.Resolve(
+            states.back(),
+            tables.GetTerminalColumn(tables.symbols_.GetTerminalId(a))
+        );
+        switch (action.type_) {
+            case ActionType::SHIFT:
+                states.push_back(action.value_);
+                ++pos;
+                break;
+            case ActionType::REDUCE:
+            case ActionType::SHIFT_REDUCE: {
+                const Rule &rule = g[action.value_];
+                size_t popped = rule.prod.size();
+                if (rule.prod[0] == Token(EPSILON)) {
+                    popped = 0;
+                }
+                // the shifted terminal of a fused action has no state
+                if (action.type_ == ActionType::SHIFT_REDUCE) {
+                    ++pos;
+                    --popped;
+                }
+                states.resize(states.size() - popped);
+                std::optional<size_t> target = tables.goto_.Get(
+                    states.back(),
+                    tables.symbols_.GetNonTerminalId(rule.lhs)
+                );
+                if (!target.has_value()) {
+                    return false;
+                }
+                states.push_back(target.value());
+                break;
+            }
+            case ActionType::ACCEPT:
+                return true;
+            case ActionType::ERROR:
+                return false;
+        }
+    }
+}
+
+const std::string kExpressions = R"(
+    num = [0-9]+
+    <S> = <Sum>
+    <Sum> = <Sum> '+' <Prod> | <Prod>
+    <Prod> = <Prod> '*' <Atom> | <Atom>
+    <Atom> = num | '(' <Sum> ')'
+)";
+}  // namespace
+
+TEST_CASE("Default reductions in consistent states", "[TableOptimizer]") {
+    Grammar g;
+    DenseTables tables = BuildTables(kExpressions, &g);
+    DenseTables plain = tables.Clone();
+    TableOptimizer optimizer(g, tables);
+    DefaultReductionStats stats =
+        optimizer.AddDefaultReductions(DefaultReductions::CONSISTENT);
+
+    REQUIRE(stats.states_ > 0);
+    REQUIRE(stats.default_only_ == stats.states_);
+    REQUIRE(stats.removed_ > 0);
+    const DenseActionTable &action = tables.action_;
+    for (size_t s = 0; s < action.GetStateCount(); ++s) {
+        for (size_t t = 0; t < action.GetTerminalCount(); ++t) {
+            Action expected = plain.action_.Get(s, t);
+            Action actual = action.Resolve(s, t);
+            if (expected.type_ != ActionType::ERROR) {
+                REQUIRE(actual.type_ == expected.type_);
+                REQUIRE(actual.value_ == expected.value_);
+            }
+        }
+        if (action.IsDefaultOnly(s)) {
+            REQUIRE(action.GetDefault(s).type_ == ActionType::REDUCE);
+        }
+    }
+}
+
+TEST_CASE("Default reductions in every reducing state", "[TableOptimizer]") {
+    Grammar g;
+    DenseTables tables = BuildTables(
+        R"(
+        id = [a-z]+
+        <S> = <List>
+        <List> = id <Rest>
+        <Rest> = ',' id <Rest> | EPSILON
+    )",
+        &g
+    );
+    DenseTables consistent = tables.Clone();
+    DenseTables plain = tables.Clone();
+
+    DefaultReductionStats some =
+        TableOptimizer(g, consistent)
+            .AddDefaultReductions(DefaultReductions::CONSISTENT);
+    DefaultReductionStats all =
+        TableOptimizer(g, tables).AddDefaultReductions(DefaultReductions::ALL);
+    // the states reading `,` or the end of a list both shift and reduce
+    REQUIRE(all.states_ > some.states_);
+    REQUIRE(all.removed_ > some.removed_);
+
+    const DenseActionTable &action = tables.action_;
+    for (size_t s = 0; s < action.GetStateCount(); ++s) {
+        for (size_t t = 0; t < action.GetTerminalCount(); ++t) {
+            Action expected = plain.action_.Get(s, t);
+            if (expected.type_ == ActionType::ERROR) {
+                continue;
+            }
+            Action actual = action.Resolve(s, t);
+            REQUIRE(actual.type_ == expected.type_);
+            REQUIRE(actual.value_ == expected.value_);
+            if (expected.type_ != ActionType::REDUCE) {
+                REQUIRE(action.Get(s, t).type_ == expected.type_);
+            }
+        }
+    }
+
+    CombTables comb(tables);
+    for (size_t s = 0; s < action.GetStateCount(); ++s) {
+        REQUIRE(comb.GetDefaultOnly()[s] == (action.IsDefaultOnly(s) ? 1 : 0));
+        for (size_t t = 0; t < action.GetTerminalCount(); ++t) {
+            REQUIRE(comb.GetAction(s, t).type_ == action.Resolve(s, t).type_);
+            REQUIRE(
+                comb.GetAction(s, t).value_ == action.Resolve(s, t).value_
+            );
+        }
+    }
+}
+
+TEST_CASE("No default reductions leave the tables intact", "[TableOptimizer]") {
+    Grammar g;
+    DenseTables tables = BuildTables(kExpressions, &g);
+    DenseTables plain = tables.Clone();
+    DefaultReductionStats stats =
+        TableOptimizer(g, tables).AddDefaultReductions(DefaultReductions::NONE);
+    REQUIRE(stats.states_ == 0);
+    REQUIRE(tables.action_.GetCells() == plain.action_.GetCells());
+    REQUIRE(tables.action_.GetDefaults() == plain.action_.GetDefaults());
+}
+
+TEST_CASE("Minimization merges equivalent states", "[TableOptimizer]") {
+    DenseTables tables;
+    tables.action_ = DenseActionTable(4, 2);
+    tables.goto_ = DenseGotoTable(4, 1);
+    // states 1 and 2 only reduce by rule 1, state 3 by rule 2
+    tables.action_.Set(0, 0, Action{ActionType::SHIFT, 1});
+    tables.action_.Set(0, 1, Action{ActionType::SHIFT, 2});
+    tables.action_.Set(1, 0, Action{ActionType::REDUCE, 1});
+    tables.action_.Set(2, 0, Action{ActionType::REDUCE, 1});
+    tables.action_.Set(3, 0, Action{ActionType::REDUCE, 2});
+    tables.goto_.Set(0, 0, 3);
+
+    Grammar g;
+    MinimizationStats stats = TableOptimizer(g, tables).MinimizeStates();
+    REQUIRE(stats.before_ == 4);
+    REQUIRE(stats.after_ == 3);
+    REQUIRE(tables.action_.GetStateCount() == 3);
+    REQUIRE(tables.goto_.GetStateCount() == 3);
+    Action first = tables.action_.Get(0, 0);
+    Action second = tables.action_.Get(0, 1);
+    REQUIRE(first.type_ == ActionType::SHIFT);
+    REQUIRE(first.value_ == second.value_);
+    REQUIRE(tables.action_.Get(first.value_, 0).value_ == 1);
+    REQUIRE(tables.action_.Get(tables.goto_.Get(0, 0).value(), 0).value_ == 2);
+}
+
+TEST_CASE("Minimized tables accept the same inputs", "[TableOptimizer]") {
+    Grammar g;
+    DenseTables plain = BuildTables(kExpressions, &g);
+    DenseTables tables = plain.Clone();
+    TableOptimizer optimizer(g, tables);
+    // canonical LR(1) keeps separate copies of the states inside and outside
+    // of the parentheses, which only differ in the lookaheads of reductions
+    REQUIRE(optimizer.MinimizeStates().after_ == plain.action_.GetStateCount());
+    optimizer.AddDefaultReductions(DefaultReductions::ALL);
+    MinimizationStats stats = optimizer.MinimizeStates();
+    REQUIRE(stats.before_ == plain.action_.GetStateCount());
+    REQUIRE(stats.after_ < stats.before_);
+    REQUIRE(tables.action_.GetStateCount() == stats.after_);
+
+    Terminal num{"num", "[0-9]+"}, plus{"+"}, times{"*"}, open{"("},
+        close{")"};
+    std::vector<std::vector<Terminal>> inputs = {
+        {num},
+        {num, plus, num, times, num},
+        {open, num, plus, num, close, times, num},
+        {open, open, num, close, close},
+        {num, plus},
+        {open, num},
+        {num, close},
+        {plus, num},
+        {open, close},
+        {num, num},
+    };
+    for (const auto &input : inputs) {
+        REQUIRE(Accepts(g, tables, input) == Accepts(g, plain, input));
+    }
+    REQUIRE(Accepts(g, tables, inputs[2]));
+    REQUIRE_FALSE(Accepts(g, tables, inputs[4]));
+}
+
+TEST_CASE("Terminals used the same way share a column", "[TableOptimizer]") {
+    Grammar g;
+    DenseTables plain = BuildTables(
+        R"(
+        num = [0-9]+
+        <S> = <Sum>
+        <Sum> = <Sum> <Op> num | num
+        <Op> = '+' | '-'
+    )",
+        &g
+    );
+    DenseTables tables = plain.Clone();
+    TableOptimizer optimizer(g, tables);
+    // `+` and `-` lead to different states, which are merged only once the
+    // reductions by `<Op> = '+'` and `<Op> = '-'` are considered equal
+    REQUIRE(
+        optimizer.MergeTerminals().after_ == plain.action_.GetTerminalCount()
+    );
+    REQUIRE(optimizer.ShareReductions() > 0);
+    REQUIRE(optimizer.MinimizeStates().after_ < plain.action_.GetStateCount());
+    TerminalClassStats stats = optimizer.MergeTerminals();
+    REQUIRE(stats.terminals_ == plain.symbols_.GetTerminalCount());
+    REQUIRE(stats.after_ == stats.before_ - 1);
+    REQUIRE(tables.action_.GetTerminalCount() == stats.after_);
+
+    const SymbolIds &ids = tables.symbols_;
+    Terminal num{"num", "[0-9]+"}, plus{"+"}, minus{"-"};
+    REQUIRE(
+        tables.GetTerminalColumn(ids.GetTerminalId(plus)) ==
+        tables.GetTerminalColumn(ids.GetTerminalId(minus))
+    );
+    REQUIRE(
+        tables.GetTerminalColumn(ids.GetTerminalId(plus)) !=
+        tables.GetTerminalColumn(ids.GetTerminalId(num))
+    );
+
+    std::vector<std::vector<Terminal>> inputs = {
+        {num},         {num, plus, num}, {num, minus, num, plus, num},
+        {num, plus},   {plus, num},      {num, num},
+        {num, minus, minus, num},
+    };
+    for (const auto &input : inputs) {
+        REQUIRE(Accepts(g, tables, input) == Accepts(g, plain, input));
+    }
+
+    CombTables comb(tables);
+    REQUIRE(comb.GetTerminalCount() == stats.after_);
+    REQUIRE(comb.GetTerminalClasses() == tables.terminal_classes_);
+}
+
+TEST_CASE("Shifts into reducing states are fused", "[TableOptimizer]") {
+    Grammar g;
+    DenseTables plain = BuildTables(kExpressions, &g);
+    DenseTables tables = plain.Clone();
+    TableOptimizer optimizer(g, tables);
+    REQUIRE(optimizer.FuseShiftReduce().fused_ == 0);
+    optimizer.AddDefaultReductions(DefaultReductions::CONSISTENT);
+    ShiftReduceStats stats = optimizer.FuseShiftReduce();
+    // `num` and `)` are always reduced right after they are shifted
+    REQUIRE(stats.fused_ > 0);
+    REQUIRE(stats.removed_states_ > 0);
+    REQUIRE(
+        tables.action_.GetStateCount() ==
+        plain.action_.GetStateCount() - stats.removed_states_
+    );
+    REQUIRE(tables.goto_.GetStateCount() == tables.action_.GetStateCount());
+
+    Terminal num{"num", "[0-9]+"}, plus{"+"}, times{"*"}, open{"("},
+        close{")"};
+    size_t num_id = tables.symbols_.GetTerminalId(num);
+    REQUIRE(tables.action_.Get(0, num_id).type_ == ActionType::SHIFT_REDUCE);
+    std::vector<std::vector<Terminal>> inputs = {
+        {num},
+        {num, plus, num, times, num},
+        {open, num, plus, num, close, times, num},
+        {open, open, num, close, close},
+        {num, plus},
+        {open, num},
+        {num, close},
+        {open, close},
+        {num, num},
+    };
+    for (const auto &input : inputs) {
+        REQUIRE(Accepts(g, tables, input) == Accepts(g, plain, input));
+    }
+
+    CombTables comb(tables);
+    for (size_t s = 0; s < tables.action_.GetStateCount(); ++s) {
+        for (size_t t = 0; t < tables.action_.GetTerminalCount(); ++t) {
+            Action expected = tables.action_.Resolve(s, t);
+            REQUIRE(comb.GetAction(s, t).type_ == expected.type_);
+            REQUIRE(comb.GetAction(s, t).value_ == expected.value_);
+        }
+    }
+}
+
+TEST_CASE("Unit reductions are bypassed", "[TableOptimizer]") {
+    const std::string input = R"(
+        id = [a-z]+
+        <S> = <E>
+        <E> = <T>
+        <T> = <F>
+        <F> = id | '(' <E> ')'
+    )";
+    Grammar g;
+    DenseTables plain = BuildTables(input, &g);
+    TableOptimizer(g, plain).AddDefaultReductions(DefaultReductions::CONSISTENT);
+    DenseTables dropped = plain.Clone();
+    DenseTables tables = plain.Clone();
+
+    UnitRuleStats kept =
+        TableOptimizer(g, tables).EliminateUnitRules(UnitRules::KEEP);
+    REQUIRE(kept.bypassed_ == 0);
+    REQUIRE(tables.goto_.GetCells() == plain.goto_.GetCells());
+
+    UnitRuleStats stats =
+        TableOptimizer(g, tables).EliminateUnitRules(UnitRules::SYNTHESIZE);
+    REQUIRE(stats.bypassed_ > 0);
+    REQUIRE(stats.removed_states_ > 0);
+    REQUIRE(
+        tables.action_.GetStateCount() ==
+        plain.action_.GetStateCount() - stats.removed_states_
+    );
+
+    // <F> goes straight to the state after <S>, past <T>, <E> and <S>
+    const SymbolIds &ids = tables.symbols_;
+    size_t f = ids.GetNonTerminalId(NonTerminal{"F"});
+    auto chain = tables.unit_chains_.find({0, f});
+    REQUIRE(chain != tables.unit_chains_.end());
+    REQUIRE(
+        chain->second == std::vector<size_t>{
+                             ids.GetNonTerminalId(NonTerminal{"T"}),
+                             ids.GetNonTerminalId(NonTerminal{"E"}),
+                             ids.GetNonTerminalId(NonTerminal{"S"}),
+                         }
+    );
+    REQUIRE(
+        tables.goto_.Get(0, f) ==
+        tables.goto_.Get(0, ids.GetNonTerminalId(NonTerminal{"S"}))
+    );
+
+    UnitRuleStats drop =
+        TableOptimizer(g, dropped).EliminateUnitRules(UnitRules::DROP);
+    REQUIRE(drop.bypassed_ == stats.bypassed_);
+    REQUIRE(dropped.unit_chains_.empty());
+    REQUIRE(dropped.goto_.GetCells() == tables.goto_.GetCells());
+
+    Terminal id{"id", "[a-z]+"}, open{"("}, close{")"};
+    std::vector<std::vector<Terminal>> inputs = {
+        {id}, {open, id, close}, {open, open, id, close, close},
+        {open, id}, {id, close}, {open, close}, {id, id},
+    };
+    for (const auto &input : inputs) {
+        REQUIRE(Accepts(g, tables, input) == Accepts(g, plain, input));
+    }
+}